@@ -0,0 +1,147 @@
+//replaces the global operator new/delete so that AllocationScope can count heap traffic.
+//sizes of freed blocks come from the allocator itself (_msize, malloc_usable_size), so the unsized
+//delete overloads are covered too. counting is skipped while no AllocationScope is active.
+#include "AllocationTracker.h"
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+
+namespace
+{
+	std::size_t usable_size(void* p)
+	{
+#ifdef _WIN32
+		return _msize(p);
+#elif defined(__APPLE__)
+		return malloc_size(p);
+#else
+		return malloc_usable_size(p);
+#endif
+	}
+
+	std::size_t usable_size(void* p, std::size_t alignment)
+	{
+#ifdef _WIN32
+		return _aligned_msize(p, alignment, 0);
+#else
+		(void)alignment;
+		return usable_size(p);
+#endif
+	}
+
+	void* allocate(std::size_t size) noexcept
+	{
+		auto p = std::malloc(size == 0 ? 1 : size);
+		auto& counters = bglx::test::global_allocations();
+		if (p != nullptr && counters.active.load(std::memory_order_relaxed) > 0)
+			counters.on_allocate(size, usable_size(p));
+		return p;
+	}
+
+	void* allocate(std::size_t size, std::size_t alignment) noexcept
+	{
+		size = size == 0 ? 1 : size;
+#ifdef _WIN32
+		auto p = _aligned_malloc(size, alignment);
+#else
+		void* p = nullptr;
+		if (posix_memalign(&p, std::max(alignment, sizeof(void*)), size) != 0)
+			p = nullptr;
+#endif
+		auto& counters = bglx::test::global_allocations();
+		if (p != nullptr && counters.active.load(std::memory_order_relaxed) > 0)
+			counters.on_allocate(size, usable_size(p, alignment));
+		return p;
+	}
+
+	void deallocate(void* p) noexcept
+	{
+		if (p == nullptr)
+			return;
+		auto& counters = bglx::test::global_allocations();
+		if (counters.active.load(std::memory_order_relaxed) > 0)
+			counters.on_deallocate(usable_size(p));
+		std::free(p);
+	}
+
+	void deallocate(void* p, std::size_t alignment) noexcept
+	{
+		if (p == nullptr)
+			return;
+		auto& counters = bglx::test::global_allocations();
+		if (counters.active.load(std::memory_order_relaxed) > 0)
+			counters.on_deallocate(usable_size(p, alignment));
+#ifdef _WIN32
+		_aligned_free(p);
+#else
+		std::free(p);
+#endif
+	}
+
+	//the throwing forms retry through the new handler like the standard ones
+	template <class Allocate>
+	void* allocate_or_throw(Allocate allocate)
+	{
+		for (;;) {
+			if (auto p = allocate())
+				return p;
+			auto handler = std::get_new_handler();
+			if (handler == nullptr)
+				throw std::bad_alloc();
+			handler();
+		}
+	}
+
+	struct MarkHooked
+	{
+		MarkHooked() { bglx::test::global_allocations().hooked = true; }
+	} markHooked;
+}
+
+void* operator new(std::size_t size) { return allocate_or_throw([size] { return allocate(size); }); }
+void* operator new[](std::size_t size) { return allocate_or_throw([size] { return allocate(size); }); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void* operator new(std::size_t size, std::align_val_t al)
+{
+	return allocate_or_throw([=] { return allocate(size, static_cast<std::size_t>(al)); });
+}
+void* operator new[](std::size_t size, std::align_val_t al)
+{
+	return allocate_or_throw([=] { return allocate(size, static_cast<std::size_t>(al)); });
+}
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept
+{
+	return allocate(size, static_cast<std::size_t>(al));
+}
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept
+{
+	return allocate(size, static_cast<std::size_t>(al));
+}
+
+void operator delete(void* p) noexcept { deallocate(p); }
+void operator delete[](void* p) noexcept { deallocate(p); }
+void operator delete(void* p, std::size_t) noexcept { deallocate(p); }
+void operator delete[](void* p, std::size_t) noexcept { deallocate(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { deallocate(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { deallocate(p); }
+
+void operator delete(void* p, std::align_val_t al) noexcept { deallocate(p, static_cast<std::size_t>(al)); }
+void operator delete[](void* p, std::align_val_t al) noexcept { deallocate(p, static_cast<std::size_t>(al)); }
+void operator delete(void* p, std::size_t, std::align_val_t al) noexcept { deallocate(p, static_cast<std::size_t>(al)); }
+void operator delete[](void* p, std::size_t, std::align_val_t al) noexcept { deallocate(p, static_cast<std::size_t>(al)); }
+void operator delete(void* p, std::align_val_t al, const std::nothrow_t&) noexcept
+{
+	deallocate(p, static_cast<std::size_t>(al));
+}
+void operator delete[](void* p, std::align_val_t al, const std::nothrow_t&) noexcept
+{
+	deallocate(p, static_cast<std::size_t>(al));
+}
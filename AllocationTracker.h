@@ -0,0 +1,209 @@
+#pragma once
+#include <boost/container/pmr/global_resource.hpp>
+#include <boost/container/pmr/memory_resource.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace bglx::test
+{
+	//allocation sizes are histogrammed in power-of-two buckets: bucket 0 holds sizes up to 8 bytes,
+	//bucket b sizes in (2^(b+2), 2^(b+3)], the last bucket everything above 64 MB
+	constexpr int AllocationBuckets = 25;
+
+	static int allocation_bucket(std::size_t size)
+	{
+		auto bucket = 0;
+		for (auto limit = std::size_t{ 8 }; size > limit && bucket < AllocationBuckets - 1; limit <<= 1)
+			++bucket;
+		return bucket;
+	}
+
+	struct AllocationStats
+	{
+		std::uint64_t count = 0;
+		std::uint64_t bytes = 0;
+		//highest live bytes above the live bytes at the start
+		std::uint64_t peakLive = 0;
+		std::uint64_t histogram[AllocationBuckets] = {};
+	};
+
+	//counters fed by an allocator. everything is relaxed atomics, so threads may allocate concurrently.
+	//live and peak count what the allocator really handed out (usable sizes), bytes what was asked for.
+	class AllocationCounters
+	{
+	public:
+		void on_allocate(std::size_t size, std::size_t usable)
+		{
+			m_count.fetch_add(1, std::memory_order_relaxed);
+			m_bytes.fetch_add(size, std::memory_order_relaxed);
+			m_histogram[allocation_bucket(size)].fetch_add(1, std::memory_order_relaxed);
+			auto grown = static_cast<std::int64_t>(usable);
+			auto live = m_live.fetch_add(grown, std::memory_order_relaxed) + grown;
+			auto peak = m_peak.load(std::memory_order_relaxed);
+			while (live > peak && !m_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) { }
+		}
+
+		void on_deallocate(std::size_t usable)
+		{
+			m_live.fetch_sub(static_cast<std::int64_t>(usable), std::memory_order_relaxed);
+		}
+
+		//totals so far, peakLive relative to zero
+		AllocationStats totals() const
+		{
+			auto stats = AllocationStats{};
+			stats.count = m_count.load(std::memory_order_relaxed);
+			stats.bytes = m_bytes.load(std::memory_order_relaxed);
+			stats.peakLive = static_cast<std::uint64_t>(std::max<std::int64_t>(m_peak.load(std::memory_order_relaxed), 0));
+			for (int b = 0; b < AllocationBuckets; ++b)
+				stats.histogram[b] = m_histogram[b].load(std::memory_order_relaxed);
+			return stats;
+		}
+
+		std::int64_t live() const { return m_live.load(std::memory_order_relaxed); }
+
+		//restarts the peak at the current live bytes and returns the previous peak,
+		//so nested scopes can measure their own peak and hand the outer one back
+		std::int64_t restart_peak() { return m_peak.exchange(live(), std::memory_order_relaxed); }
+
+		void merge_peak(std::int64_t peak)
+		{
+			auto current = m_peak.load(std::memory_order_relaxed);
+			while (peak > current && !m_peak.compare_exchange_weak(current, peak, std::memory_order_relaxed)) { }
+		}
+
+		std::int64_t peak() const { return m_peak.load(std::memory_order_relaxed); }
+
+		//set while at least one scope tracks these counters, the global hooks skip counting otherwise
+		std::atomic<int> active{ 0 };
+		//set by AllocationHooks.cpp when the global operator new/delete are replaced
+		std::atomic<bool> hooked{ false };
+
+	private:
+		std::atomic<std::uint64_t> m_count{ 0 };
+		std::atomic<std::uint64_t> m_bytes{ 0 };
+		std::atomic<std::int64_t> m_live{ 0 };
+		std::atomic<std::int64_t> m_peak{ 0 };
+		std::atomic<std::uint64_t> m_histogram[AllocationBuckets] = {};
+	};
+
+	//counters of the global operator new/delete, filled by AllocationHooks.cpp.
+	//inline so that every translation unit shares them; created on first use, which does not allocate.
+	inline AllocationCounters& global_allocations()
+	{
+		static AllocationCounters counters;
+		return counters;
+	}
+
+	//measures the allocations made between construction and stop() on a set of counters (the global
+	//operator new by default). scopes nest; allocations of all threads during the scope are included.
+	class AllocationScope
+	{
+	public:
+		explicit AllocationScope(AllocationCounters& counters = global_allocations())
+			: m_counters(counters)
+		{
+			m_counters.active.fetch_add(1, std::memory_order_relaxed);
+			m_outerPeak = m_counters.restart_peak();
+			m_startLive = m_counters.live();
+			m_start = m_counters.totals();
+		}
+
+		~AllocationScope() { stop(); }
+
+		AllocationScope(const AllocationScope&) = delete;
+		AllocationScope& operator=(const AllocationScope&) = delete;
+
+		//ends the scope once, later calls return the same stats
+		AllocationStats stop()
+		{
+			if (m_stopped)
+				return m_stats;
+			m_stopped = true;
+			auto end = m_counters.totals();
+			m_stats.count = end.count - m_start.count;
+			m_stats.bytes = end.bytes - m_start.bytes;
+			m_stats.peakLive = static_cast<std::uint64_t>(std::max<std::int64_t>(m_counters.peak() - m_startLive, 0));
+			for (int b = 0; b < AllocationBuckets; ++b)
+				m_stats.histogram[b] = end.histogram[b] - m_start.histogram[b];
+			m_counters.merge_peak(m_outerPeak);
+			m_counters.active.fetch_sub(1, std::memory_order_relaxed);
+			return m_stats;
+		}
+
+	private:
+		AllocationCounters& m_counters;
+		std::int64_t m_outerPeak;
+		std::int64_t m_startLive;
+		AllocationStats m_start;
+		AllocationStats m_stats;
+		bool m_stopped = false;
+	};
+
+	//memory resource that counts what passes through it to an upstream resource, for pmr graphs
+	class CountingResource : public boost::container::pmr::memory_resource
+	{
+	public:
+		explicit CountingResource(
+			boost::container::pmr::memory_resource* upstream = boost::container::pmr::get_default_resource())
+			: m_upstream(upstream) { }
+
+		AllocationCounters& counters() { return m_counters; }
+
+	protected:
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override
+		{
+			auto p = m_upstream->allocate(bytes, alignment);
+			m_counters.on_allocate(bytes, bytes);
+			return p;
+		}
+
+		void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+		{
+			m_upstream->deallocate(p, bytes, alignment);
+			m_counters.on_deallocate(bytes);
+		}
+
+		bool do_is_equal(const boost::container::pmr::memory_resource& other) const noexcept override
+		{
+			return this == &other;
+		}
+
+	private:
+		boost::container::pmr::memory_resource* m_upstream;
+		AllocationCounters m_counters;
+	};
+
+	static std::string format_bytes(std::uint64_t bytes)
+	{
+		std::ostringstream text;
+		if (bytes < 1024)
+			text << bytes << " B";
+		else {
+			const char* unit = bytes < (1u << 20) ? " KB" : bytes < (1u << 30) ? " MB" : " GB";
+			auto scale = bytes < (1u << 20) ? 1024.0 : bytes < (1u << 30) ? 1048576.0 : 1073741824.0;
+			text << std::fixed << std::setprecision(2) << bytes / scale << unit;
+		}
+		return text.str();
+	}
+
+	//"12 allocations, 1.50 KB, peak live 1.00 KB, sizes <=8 B: 2, <=16 B: 10"
+	static std::string format_allocation_stats(const AllocationStats& stats)
+	{
+		std::ostringstream text;
+		text << stats.count << " allocations, " << format_bytes(stats.bytes) << ", peak live " << format_bytes(stats.peakLive);
+		auto separator = ", sizes ";
+		for (int b = 0; b < AllocationBuckets; ++b) {
+			if (stats.histogram[b] == 0)
+				continue;
+			text << separator << (b == AllocationBuckets - 1 ? ">" : "<=")
+				<< format_bytes(std::uint64_t{ 8 } << (b == AllocationBuckets - 1 ? b - 1 : b)) << ": " << stats.histogram[b];
+			separator = ", ";
+		}
+		return text.str();
+	}
+}
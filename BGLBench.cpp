@@ -0,0 +1,447 @@
+// BGLBench.cpp : benchmarks of the BoostGraphX Euler algorithms, results as JSON.
+//   BGLBench [--min-order 10] [--max-order 22] [--order-step 2] [--max-list-order 20]
+//            [--repetitions 5] [--warmup 1] [--cpu 0] [--filter text] [--label text] [--out results.json]
+// orders go up to 26; adjacency_list graphs stop at --max-list-order, CsrGraph runs all orders.
+#define _SILENCE_CXX17_ITERATOR_BASE_CLASS_DEPRECATION_WARNING
+#include "NamedDag.h"
+#include "CsrGraph.h"
+#include "BufferedWriter.h"
+#include "RandomEulerGraph.h"
+#include <BoostGraphX/euler_graph.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace bglx::test
+{
+	struct BenchOptions
+	{
+		int minOrder = 10;
+		int maxOrder = 22;
+		int orderStep = 2;
+		int maxListOrder = 20;
+		int repetitions = 5;
+		int warmup = 1;
+		//-1 leaves the thread where the scheduler puts it
+		int cpu = 0;
+		std::string filter;
+		std::string label;
+		std::string out;
+	};
+
+	struct BenchResult
+	{
+		std::string name;
+		std::string family;
+		std::string container;
+		std::string overload;
+		int order;
+		std::size_t nrVertices;
+		std::size_t nrEdges;
+		std::vector<std::int64_t> ns;
+	};
+
+	using EdgeList = std::vector<std::pair<std::uint32_t, std::uint32_t>>;
+
+	//same topology as make_De_Bruigin_graph(order) without the names: vertex i is the (order + 1) bit
+	//string with value i, and its out-edges shift in a 0 and a 1
+	static EdgeList de_bruijn_edges(int order)
+	{
+		auto nrVertices = std::uint32_t{ 2 } << order;
+		EdgeList edges;
+		edges.reserve(std::size_t{ nrVertices } * 2);
+		for (std::uint32_t v = 0; v < nrVertices; ++v) {
+			edges.emplace_back(v, (2 * v) & (nrVertices - 1));
+			edges.emplace_back(v, (2 * v + 1) & (nrVertices - 1));
+		}
+		return edges;
+	}
+
+	//random Eulerian digraph with as many vertices and edges as de_bruijn_edges(order), before the
+	//parallel edges are split so that setS out-edge lists keep all of them
+	static EdgeList random_euler_edges(int order, DegreeDistribution distribution, std::uint64_t seed)
+	{
+		auto options = RandomEulerOptions{};
+		options.nrVertices = std::size_t{ 2 } << order;
+		options.nrEdges = options.nrVertices * 2;
+		options.distribution = distribution;
+		options.seed = seed;
+		options.simple = true;
+		auto g = make_random_euler_csr(options);
+		EdgeList edges;
+		edges.reserve(boost::num_edges(g));
+		for (auto e : boost::make_iterator_range(boost::edges(g)))
+			edges.emplace_back(static_cast<std::uint32_t>(e.source), static_cast<std::uint32_t>(boost::target(e, g)));
+		return edges;
+	}
+
+	template <class Graph>
+	struct GraphTag { };
+
+	//vecS vertex adjacency_list graphs, vertex i is descriptor i
+	template <class Graph>
+	static Graph make_graph(std::size_t nrVertices, const EdgeList& edges, GraphTag<Graph>)
+	{
+		auto g = Graph{ nrVertices };
+		for (auto [u, v] : edges)
+			boost::add_edge(u, v, g);
+		return g;
+	}
+
+	static FlatDag make_graph(std::size_t nrVertices, const EdgeList& edges, GraphTag<FlatDag>)
+	{
+		auto g = FlatDag{ nrVertices };
+		auto loader = BulkEdgeLoader<FlatDag>{ g };
+		loader.reserve(edges.size());
+		for (auto [u, v] : edges)
+			loader.add_edge(u, v);
+		loader.freeze();
+		return g;
+	}
+
+	static Dag_VSet make_graph(std::size_t nrVertices, const EdgeList& edges, GraphTag<Dag_VSet>)
+	{
+		auto g = Dag_VSet{};
+		std::vector<Dag_VSet::vertex_descriptor> vertices(nrVertices);
+		for (auto& v : vertices)
+			v = boost::add_vertex(g);
+		for (auto [u, v] : edges)
+			boost::add_edge(vertices[u], vertices[v], g);
+		return g;
+	}
+
+	static CsrGraph make_graph(std::size_t nrVertices, const EdgeList& edges, GraphTag<CsrGraph>)
+	{
+		return make_csr_graph(nrVertices, edges);
+	}
+
+	//pins the calling thread to one cpu and restores its previous affinity on scope exit
+	class CpuPin
+	{
+	public:
+		explicit CpuPin(int cpu)
+		{
+			if (cpu < 0)
+				return;
+#ifdef _WIN32
+			m_previous = SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{ 1 } << cpu);
+			m_pinned = m_previous != 0;
+#elif defined(__linux__)
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			CPU_SET(cpu, &set);
+			m_pinned = sched_getaffinity(0, sizeof(m_previous), &m_previous) == 0 && sched_setaffinity(0, sizeof(set), &set) == 0;
+#endif
+		}
+
+		~CpuPin()
+		{
+			if (!m_pinned)
+				return;
+#ifdef _WIN32
+			SetThreadAffinityMask(GetCurrentThread(), m_previous);
+#elif defined(__linux__)
+			sched_setaffinity(0, sizeof(m_previous), &m_previous);
+#endif
+		}
+
+		CpuPin(const CpuPin&) = delete;
+		CpuPin& operator=(const CpuPin&) = delete;
+
+		bool pinned() const { return m_pinned; }
+
+	private:
+		bool m_pinned = false;
+#ifdef _WIN32
+		DWORD_PTR m_previous = 0;
+#elif defined(__linux__)
+		cpu_set_t m_previous;
+#endif
+	};
+
+	class BenchRunner
+	{
+	public:
+		explicit BenchRunner(const BenchOptions& options) : m_options(options) { }
+
+		const std::vector<BenchResult>& results() const { return m_results; }
+
+		//runs warmup + repetitions of one overload; every run is checked to cover all edges once
+		template <class Graph, class Find>
+		void run(const std::string& family, const std::string& container, const std::string& overload, int order,
+			const Graph& g, Find find)
+		{
+			auto result = BenchResult{ family + "/" + container + "/" + overload + "/order=" + std::to_string(order),
+				family, container, overload, order, boost::num_vertices(g), boost::num_edges(g), {} };
+			if (!m_options.filter.empty() && result.name.find(m_options.filter) == std::string::npos)
+				return;
+			//only the timed runs are pinned; generating the inputs and building the graphs use every core
+			auto pin = CpuPin{ m_options.cpu };
+			for (int r = 0; r < m_options.warmup + m_options.repetitions; ++r) {
+				auto beg = std::chrono::steady_clock::now();
+				auto cycle = find(g);
+				auto end = std::chrono::steady_clock::now();
+				if (cycle.size() != boost::num_edges(g))
+					throw std::runtime_error(result.name + ": the Euler cycle misses edges.");
+				if (r >= m_options.warmup)
+					result.ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - beg).count());
+			}
+			auto sorted = result.ns;
+			std::sort(sorted.begin(), sorted.end());
+			std::cerr << result.name << ": median " << sorted[sorted.size() / 2] / 1e6 << " ms, "
+				<< result.nrEdges / (sorted[sorted.size() / 2] / 1e9) / 1e6 << " M edges/s\n";
+			m_results.push_back(std::move(result));
+		}
+
+		//default and explicit index map overloads for graphs with an internal vertex index
+		template <class Graph>
+		void run_indexed(const std::string& family, const std::string& container, int order, const Graph& g)
+		{
+			auto start = *boost::vertices(g).first;
+			run(family, container, "default", order, g, [start](const Graph& g) {
+				return bglx::find_one_directed_euler_cycle_hierholzer(g, start);
+			});
+			run(family, container, "index_map", order, g, [start](const Graph& g) {
+				return bglx::find_one_directed_euler_cycle_hierholzer(g, start, get(boost::vertex_index, g));
+			});
+		}
+
+		void run_family(const std::string& family, int order, const EdgeList& edges)
+		{
+			auto nrVertices = std::size_t{ 0 };
+			for (auto [u, v] : edges)
+				nrVertices = std::max<std::size_t>(nrVertices, std::max(u, v) + std::size_t{ 1 });
+			if (order <= m_options.maxListOrder) {
+				run_indexed(family, "Dag", order, make_graph(nrVertices, edges, GraphTag<Dag>{}));
+				run_indexed(family, "FlatDag", order, make_graph(nrVertices, edges, GraphTag<FlatDag>{}));
+				using VecDag = boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS>;
+				run_indexed(family, "VecDag", order, make_graph(nrVertices, edges, GraphTag<VecDag>{}));
+				using ListDag = boost::adjacency_list<boost::listS, boost::vecS, boost::directedS>;
+				run_indexed(family, "ListDag", order, make_graph(nrVertices, edges, GraphTag<ListDag>{}));
+
+				//setS vertices have no internal index, only the property map overload applies
+				auto g = make_graph(nrVertices, edges, GraphTag<Dag_VSet>{});
+				std::unordered_map<Dag_VSet::vertex_descriptor, std::size_t> indices;
+				for (auto v : boost::make_iterator_range(boost::vertices(g)))
+					indices.emplace(v, indices.size());
+				auto indexMap = boost::associative_property_map<decltype(indices)>(indices);
+				auto start = *boost::vertices(g).first;
+				run(family, "Dag_VSet", "associative_map", order, g, [start, indexMap](const Dag_VSet& g) {
+					return bglx::find_one_directed_euler_cycle_hierholzer(g, start, indexMap);
+				});
+			}
+			run_indexed(family, "CsrGraph", order, make_graph(nrVertices, edges, GraphTag<CsrGraph>{}));
+		}
+
+		void run_all()
+		{
+			for (int order = m_options.minOrder; order <= m_options.maxOrder; order += m_options.orderStep) {
+				run_family("de_bruijn", order, de_bruijn_edges(order));
+				run_family("random_uniform", order, random_euler_edges(order, DegreeDistribution::Uniform, 42 + order));
+				run_family("random_power_law", order, random_euler_edges(order, DegreeDistribution::PowerLaw, 42 + order));
+				run_family("random_hubs", order, random_euler_edges(order, DegreeDistribution::Hubs, 42 + order));
+			}
+		}
+
+	private:
+		BenchOptions m_options;
+		std::vector<BenchResult> m_results;
+	};
+
+	static void write_json_string(BufferedWriter& out, const std::string& text)
+	{
+		out.put('"');
+		for (auto c : text) {
+			if (c == '"' || c == '\\') {
+				out.put('\\');
+				out.put(c);
+			}
+			else if (static_cast<unsigned char>(c) < 0x20) {
+				out.write("\\u00");
+				out.put("0123456789abcdef"[(c >> 4) & 0xF]);
+				out.put("0123456789abcdef"[c & 0xF]);
+			}
+			else {
+				out.put(c);
+			}
+		}
+		out.put('"');
+	}
+
+	static std::string compiler_name()
+	{
+#if defined(_MSC_VER)
+		return "MSVC " + std::to_string(_MSC_FULL_VER);
+#elif defined(__clang__)
+		return std::string{ "clang " } + __clang_version__;
+#elif defined(__GNUC__)
+		return std::string{ "gcc " } + __VERSION__;
+#else
+		return "unknown";
+#endif
+	}
+
+	//one object: a context block describing the run and one entry per benchmark with its raw timings
+	static void write_bench_json(BufferedWriter& out, const BenchOptions& options, bool pinned,
+		const std::vector<BenchResult>& results)
+	{
+		char date[32] = {};
+		auto now = std::time(nullptr);
+		std::tm utc{};
+#ifdef _WIN32
+		gmtime_s(&utc, &now);
+#else
+		gmtime_r(&now, &utc);
+#endif
+		std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", &utc);
+		out.write("{\n  \"context\": {\n    \"date\": ");
+		write_json_string(out, date);
+		out.write(",\n    \"label\": ");
+		write_json_string(out, options.label);
+		out.write(",\n    \"compiler\": ");
+		write_json_string(out, compiler_name());
+#ifdef NDEBUG
+		out.write(",\n    \"build\": \"release\"");
+#else
+		out.write(",\n    \"build\": \"debug\"");
+#endif
+		out.write(",\n    \"hardware_threads\": ");
+		out.write_number(std::thread::hardware_concurrency());
+		out.write(",\n    \"cpu\": ");
+		out.write_number(pinned ? options.cpu : -1);
+		out.write(",\n    \"warmup\": ");
+		out.write_number(options.warmup);
+		out.write(",\n    \"repetitions\": ");
+		out.write_number(options.repetitions);
+		out.write("\n  },\n  \"benchmarks\": [");
+		auto separator = "\n";
+		for (auto& result : results) {
+			auto sorted = result.ns;
+			std::sort(sorted.begin(), sorted.end());
+			auto mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+			auto variance = 0.0;
+			for (auto ns : sorted)
+				variance += (ns - mean) * (ns - mean);
+			auto stddev = sorted.size() > 1 ? std::sqrt(variance / (sorted.size() - 1)) : 0.0;
+			auto median = sorted.size() % 2 ? double(sorted[sorted.size() / 2])
+				: (sorted[sorted.size() / 2 - 1] + sorted[sorted.size() / 2]) / 2.0;
+
+			out.write(separator);
+			out.write("    {\n      \"name\": ");
+			write_json_string(out, result.name);
+			out.write(",\n      \"family\": ");
+			write_json_string(out, result.family);
+			out.write(",\n      \"container\": ");
+			write_json_string(out, result.container);
+			out.write(",\n      \"overload\": ");
+			write_json_string(out, result.overload);
+			out.write(",\n      \"order\": ");
+			out.write_number(result.order);
+			out.write(",\n      \"vertices\": ");
+			out.write_number(result.nrVertices);
+			out.write(",\n      \"edges\": ");
+			out.write_number(result.nrEdges);
+			out.write(",\n      \"ns\": [");
+			for (std::size_t i = 0; i < result.ns.size(); ++i) {
+				if (i != 0)
+					out.write(", ");
+				out.write_number(result.ns[i]);
+			}
+			out.write("],\n      \"min_ns\": ");
+			out.write_number(sorted.front());
+			out.write(",\n      \"median_ns\": ");
+			out.write_number(std::llround(median));
+			out.write(",\n      \"mean_ns\": ");
+			out.write_number(std::llround(mean));
+			out.write(",\n      \"max_ns\": ");
+			out.write_number(sorted.back());
+			out.write(",\n      \"stddev_ns\": ");
+			out.write_number(std::llround(stddev));
+			out.write(",\n      \"edges_per_second\": ");
+			out.write_number(std::llround(result.nrEdges / (median / 1e9)));
+			out.write("\n    }");
+			separator = ",\n";
+		}
+		out.write("\n  ]\n}\n");
+	}
+
+	static BenchOptions parse_bench_options(int argc, char** argv)
+	{
+		auto options = BenchOptions{};
+		for (int i = 1; i < argc; ++i) {
+			auto arg = std::string{ argv[i] };
+			if (i + 1 >= argc)
+				throw std::invalid_argument("Missing value for " + arg);
+			auto value = std::string{ argv[++i] };
+			if (arg == "--min-order")
+				options.minOrder = std::stoi(value);
+			else if (arg == "--max-order")
+				options.maxOrder = std::stoi(value);
+			else if (arg == "--order-step")
+				options.orderStep = std::max(1, std::stoi(value));
+			else if (arg == "--max-list-order")
+				options.maxListOrder = std::stoi(value);
+			else if (arg == "--repetitions")
+				options.repetitions = std::max(1, std::stoi(value));
+			else if (arg == "--warmup")
+				options.warmup = std::max(0, std::stoi(value));
+			else if (arg == "--cpu")
+				options.cpu = std::stoi(value);
+			else if (arg == "--filter")
+				options.filter = value;
+			else if (arg == "--label")
+				options.label = value;
+			else if (arg == "--out")
+				options.out = value;
+			else
+				throw std::invalid_argument("Unknown option " + arg);
+		}
+		if (options.minOrder < 1 || options.maxOrder > 26)
+			throw std::invalid_argument("Orders must lie in 1..26.");
+		return options;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	using namespace bglx::test;
+	try {
+		auto options = parse_bench_options(argc, argv);
+		//probes the cpu once, the runner pins around the timed runs only
+		auto pinned = CpuPin{ options.cpu }.pinned();
+		if (options.cpu >= 0 && !pinned)
+			std::cerr << "Could not pin to cpu " << options.cpu << ", running unpinned.\n";
+		auto runner = BenchRunner{ options };
+		runner.run_all();
+		if (options.out.empty()) {
+			auto out = BufferedWriter{ stdout };
+			write_bench_json(out, options, pinned, runner.results());
+		}
+		else {
+			auto out = BufferedWriter{ options.out };
+			write_bench_json(out, options, pinned, runner.results());
+			out.close();
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
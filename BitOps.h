@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace bglx::test::detail
+{
+	//x must not be 0
+	static unsigned count_trailing_zeros(std::uint64_t x)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, x);
+		return static_cast<unsigned>(index);
+#else
+		return static_cast<unsigned>(__builtin_ctzll(x));
+#endif
+	}
+}
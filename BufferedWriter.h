@@ -0,0 +1,141 @@
+#pragma once
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace bglx::test
+{
+	//formats into one large buffer and hands it to the file in a single write once it is full,
+	//so exporting millions of lines costs a few hundred syscalls instead of a flush per line.
+	//writes either to a file it opens (unbuffered on the stdio side) or to a borrowed FILE* like stdout.
+	class BufferedWriter
+	{
+	public:
+		static constexpr std::size_t DefaultCapacity = std::size_t{ 1 } << 20;
+
+		explicit BufferedWriter(const std::string& path, std::size_t capacity = DefaultCapacity)
+			: m_file(open_for_writing(path)), m_owned(true), m_capacity(capacity)
+		{
+			if (m_file == nullptr)
+				throw std::runtime_error("Can not open " + path + " for writing.");
+			std::setvbuf(m_file, nullptr, _IONBF, 0);
+			m_buffer = std::make_unique<char[]>(m_capacity);
+		}
+
+		explicit BufferedWriter(std::FILE* file, std::size_t capacity = DefaultCapacity)
+			: m_file(file), m_owned(false), m_capacity(capacity), m_buffer(std::make_unique<char[]>(capacity)) { }
+
+		~BufferedWriter()
+		{
+			try {
+				close();
+			}
+			catch (...) {
+			}
+		}
+
+		BufferedWriter(const BufferedWriter&) = delete;
+		BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+		void write(std::string_view text)
+		{
+			if (text.size() > m_capacity - m_size) {
+				flush();
+				if (text.size() >= m_capacity) {
+					write_through(text.data(), text.size());
+					return;
+				}
+			}
+			std::memcpy(m_buffer.get() + m_size, text.data(), text.size());
+			m_size += text.size();
+		}
+
+		void put(char c)
+		{
+			if (m_size == m_capacity)
+				flush();
+			m_buffer[m_size++] = c;
+		}
+
+		//decimal text of an integer, formatted in place with std::to_chars
+		template <class Int>
+		void write_number(Int value)
+		{
+			static_assert(std::is_integral_v<Int>, "only integers are formatted");
+			constexpr std::size_t MaxDigits = 24;
+			if (m_capacity - m_size < MaxDigits)
+				flush();
+			if (m_capacity < MaxDigits) {
+				char digits[MaxDigits];
+				auto result = std::to_chars(digits, digits + MaxDigits, value);
+				write({ digits, static_cast<std::size_t>(result.ptr - digits) });
+				return;
+			}
+			auto result = std::to_chars(m_buffer.get() + m_size, m_buffer.get() + m_capacity, value);
+			m_size = result.ptr - m_buffer.get();
+		}
+
+		//raw bytes, for binary formats
+		void write_bytes(const void* data, std::size_t size)
+		{
+			write({ static_cast<const char*>(data), size });
+		}
+
+		//writes out what is buffered; a borrowed FILE* is flushed as well so the output shows up in order
+		void flush()
+		{
+			if (m_file == nullptr)
+				throw std::runtime_error("Writing to a closed BufferedWriter.");
+			if (m_size != 0) {
+				write_through(m_buffer.get(), m_size);
+				m_size = 0;
+			}
+			if (!m_owned)
+				std::fflush(m_file);
+		}
+
+		//flushes and, for a file it opened, closes it. reports errors the destructor would swallow.
+		void close()
+		{
+			if (m_file == nullptr)
+				return;
+			flush();
+			auto file = std::exchange(m_file, nullptr);
+			if (m_owned && std::fclose(file) != 0)
+				throw std::runtime_error("Closing the output file failed.");
+		}
+
+		std::size_t bytes_written() const { return m_written + m_size; }
+
+	private:
+		static std::FILE* open_for_writing(const std::string& path)
+		{
+#ifdef _MSC_VER
+			std::FILE* file = nullptr;
+			return fopen_s(&file, path.c_str(), "wb") == 0 ? file : nullptr;
+#else
+			return std::fopen(path.c_str(), "wb");
+#endif
+		}
+
+		void write_through(const char* data, std::size_t size)
+		{
+			if (std::fwrite(data, 1, size, m_file) != size)
+				throw std::runtime_error("Writing the output file failed.");
+			m_written += size;
+		}
+
+		std::FILE* m_file;
+		bool m_owned;
+		std::size_t m_capacity;
+		std::unique_ptr<char[]> m_buffer;
+		std::size_t m_size = 0;
+		std::size_t m_written = 0;
+	};
+}
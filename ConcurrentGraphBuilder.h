@@ -0,0 +1,178 @@
+#pragma once
+#include "CsrGraph.h"
+#include "NamedDag.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bglx::test
+{
+	//producers are padded to this, so two of them never share a cache line
+	constexpr std::size_t CacheLineSize = 64;
+
+	struct ConcurrentBuildOptions
+	{
+		//0 means one thread per hardware thread
+		unsigned nrThreads = 0;
+		//at least this many vertices, more if an edge names a higher one
+		std::size_t nrVertices = 0;
+		//keep only the first of several u -> v edges, like setS does
+		bool removeParallelEdges = false;
+	};
+
+	//collects the edges that several threads find at the same time. every thread adds to its own
+	//producer(i): an append to a buffer on cache lines of its own, without locks or atomics, so adding
+	//scales with the number of threads. once all producers are done, finish_csr or finish_dag sorts
+	//the edges into rows in parallel. edges keep their order within a producer, and a lower producer
+	//number comes first; among parallel edges that decides which one, and which name, is kept.
+	class ConcurrentGraphBuilder
+	{
+	public:
+		class alignas(CacheLineSize) Producer
+		{
+		public:
+			void reserve(std::size_t nrEdges) { m_edges.reserve(nrEdges); }
+			std::size_t nr_edges() const { return m_edges.size(); }
+
+			void add_edge(std::uint32_t source, std::uint32_t target)
+			{
+				m_edges.emplace_back(source, target);
+				m_nrVertices = std::max<std::uint64_t>(m_nrVertices, std::uint64_t{ std::max(source, target) } + 1);
+				if (m_named)
+					m_nameEnds.push_back(m_names.size());
+			}
+
+			void add_edge(std::uint32_t source, std::uint32_t target, std::string_view name)
+			{
+				//names start with the first named edge, the unnamed ones before it get empty names
+				if (!m_named && !name.empty()) {
+					m_named = true;
+					m_nameEnds.assign(m_edges.size(), 0);
+				}
+				m_names += name;
+				add_edge(source, target);
+			}
+
+		private:
+			friend class ConcurrentGraphBuilder;
+
+			std::string_view name(std::size_t i) const
+			{
+				if (!m_named)
+					return {};
+				auto begin = i == 0 ? 0 : m_nameEnds[i - 1];
+				return { m_names.data() + begin, static_cast<std::size_t>(m_nameEnds[i] - begin) };
+			}
+
+			std::vector<std::pair<std::uint32_t, std::uint32_t>> m_edges;
+			std::uint64_t m_nrVertices = 0;
+			//end of the name of every edge in m_names, once any edge has a name
+			bool m_named = false;
+			std::vector<std::uint64_t> m_nameEnds;
+			std::string m_names;
+		};
+
+		explicit ConcurrentGraphBuilder(unsigned nrProducers) : m_producers(std::max(1u, nrProducers)) { }
+
+		unsigned nr_producers() const { return static_cast<unsigned>(m_producers.size()); }
+		//only the thread that owns producer i may add to it
+		Producer& producer(unsigned i) { return m_producers[i]; }
+
+		//rows sorted by target, every row in (producer, order of adding) among equal targets, the
+		//same as load_edge_list_csr. edge names are kept if any producer added one. call after all
+		//producers are done; the builder keeps its edges.
+		CsrGraph finish_csr(const ConcurrentBuildOptions& options = {}) const
+		{
+			auto nrThreads = options.nrThreads == 0 ? default_thread_count() : options.nrThreads;
+			auto nrVertices = static_cast<std::uint64_t>(options.nrVertices);
+			auto hasNames = false;
+			for (auto& producer : m_producers) {
+				nrVertices = std::max(nrVertices, producer.m_nrVertices);
+				hasNames |= producer.m_named;
+			}
+			if (nrVertices > std::numeric_limits<std::uint32_t>::max())
+				throw std::invalid_argument("CSR rows support up to 2^32 - 1 vertices.");
+			auto n = static_cast<std::size_t>(nrVertices);
+
+			//every edge into the row of its source, rows in producer order
+			struct RowEdge
+			{
+				std::uint32_t target;
+				std::uint32_t producer;
+				std::uint64_t index;
+			};
+			std::vector<std::uint64_t> rowOffsets;
+			auto rows = detail::scatter_rows_by_owner<RowEdge>(n, m_producers.size(), [&](std::size_t p, auto&& emit) {
+				auto& edges = m_producers[p].m_edges;
+				for (std::size_t i = 0; i < edges.size(); ++i)
+					emit(edges[i].first, RowEdge{ edges[i].second, static_cast<std::uint32_t>(p), i });
+			}, nrThreads, rowOffsets);
+			auto rowBegin = [&rowOffsets](std::size_t v) { return rowOffsets[v]; };
+			auto rowEnd = [&rowOffsets](std::size_t v) { return rowOffsets[v + 1]; };
+
+			//rows are in producer order already, a stable sort by target keeps the first of equal targets first.
+			//offsets[v + 1] holds the kept out-degree of v until the prefix sum below
+			auto storage = CsrStorage{};
+			storage.offsets.assign(n + 1, 0);
+			parallel_chunks(n, nrThreads, [&](unsigned, std::size_t begin, std::size_t end) {
+				for (auto v = begin; v < end; ++v) {
+					auto first = rows.begin() + rowBegin(v);
+					auto last = rows.begin() + rowEnd(v);
+					std::stable_sort(first, last, [](const RowEdge& a, const RowEdge& b) { return a.target < b.target; });
+					if (options.removeParallelEdges)
+						last = std::unique(first, last, [](const RowEdge& a, const RowEdge& b) { return a.target == b.target; });
+					storage.offsets[v + 1] = last - first;
+				}
+			});
+			for (std::size_t v = 0; v < n; ++v)
+				storage.offsets[v + 1] += storage.offsets[v];
+			auto nrEdges = static_cast<std::size_t>(storage.offsets[n]);
+			storage.targets.resize(nrEdges);
+			if (hasNames)
+				storage.edgeNameOffsets.assign(nrEdges + 1, 0);
+			parallel_chunks(n, nrThreads, [&](unsigned, std::size_t begin, std::size_t end) {
+				for (auto v = begin; v < end; ++v) {
+					auto from = rowBegin(v);
+					for (auto i = storage.offsets[v]; i < storage.offsets[v + 1]; ++i, ++from) {
+						storage.targets[i] = rows[from].target;
+						if (hasNames)
+							storage.edgeNameOffsets[i + 1] = m_producers[rows[from].producer].name(rows[from].index).size();
+					}
+				}
+			});
+			if (hasNames) {
+				for (std::size_t i = 0; i < nrEdges; ++i)
+					storage.edgeNameOffsets[i + 1] += storage.edgeNameOffsets[i];
+				storage.edgeNames.resize(storage.edgeNameOffsets[nrEdges]);
+				parallel_chunks(n, nrThreads, [&](unsigned, std::size_t begin, std::size_t end) {
+					for (auto v = begin; v < end; ++v) {
+						auto from = rowBegin(v);
+						for (auto i = storage.offsets[v]; i < storage.offsets[v + 1]; ++i, ++from) {
+							auto name = m_producers[rows[from].producer].name(rows[from].index);
+							if (!name.empty())
+								std::memcpy(&storage.edgeNames[storage.edgeNameOffsets[i]], name.data(), name.size());
+						}
+					}
+				});
+			}
+			return CsrGraph{ std::move(storage) };
+		}
+
+		//finish_csr without parallel edges, copied into a Dag (vertices named by their id)
+		Dag finish_dag(ConcurrentBuildOptions options = {}) const
+		{
+			options.removeParallelEdges = true;
+			return make_dag(finish_csr(options));
+		}
+
+	private:
+		std::vector<Producer> m_producers;
+	};
+}
@@ -0,0 +1,387 @@
+#pragma once
+#include "CsrGraph.h"
+#include "EulerDegrees.h"
+#include "Parallel.h"
+#include "TopologicalSort.h"
+#include <boost/graph/graph_traits.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace bglx::test
+{
+	//component[v] is the component of vertex v. components are numbered 0..nrComponents-1 in the order
+	//of their smallest vertex, so the labels do not depend on the thread count.
+	struct ComponentLabels
+	{
+		static constexpr std::uint32_t NoComponent = std::numeric_limits<std::uint32_t>::max();
+
+		std::vector<std::uint32_t> component;
+		std::size_t nrComponents = 0;
+	};
+
+	namespace detail
+	{
+		inline void check_component_vertices(std::size_t nrVertices)
+		{
+			if (nrVertices >= ComponentLabels::NoComponent - 1)
+				throw std::invalid_argument("Connected components support up to 2^32 - 3 vertices.");
+		}
+
+		//representative[v] names the component of v by any of its vertices; numbers them in the
+		//order of their smallest vertex
+		inline ComponentLabels number_components(std::vector<std::uint32_t> representative)
+		{
+			auto result = ComponentLabels{};
+			auto n = representative.size();
+			std::vector<std::uint32_t> number(n, ComponentLabels::NoComponent);
+			for (std::size_t v = 0; v < n; ++v) {
+				auto& id = number[representative[v]];
+				if (id == ComponentLabels::NoComponent)
+					id = static_cast<std::uint32_t>(result.nrComponents++);
+				representative[v] = id;
+			}
+			result.component = std::move(representative);
+			return result;
+		}
+
+		//lock-free union-find. a root is only hooked below a smaller root, with compare_exchange, so
+		//parents only decrease, the root of a tree is its smallest vertex and finds can halve paths
+		//without locks: whatever a vertex points to stays one of its ancestors.
+		class ConcurrentUnionFind
+		{
+		public:
+			ConcurrentUnionFind(std::size_t size, unsigned nrThreads)
+				: m_size(size), m_parent(std::make_unique<std::atomic<std::uint32_t>[]>(size))
+			{
+				parallel_for(size, size < (1 << 16) ? 1u : nrThreads, [this](std::size_t v) {
+					m_parent[v].store(static_cast<std::uint32_t>(v), std::memory_order_relaxed);
+				});
+			}
+
+			std::uint32_t find(std::uint32_t v)
+			{
+				for (auto parent = m_parent[v].load(std::memory_order_relaxed); parent != v;) {
+					auto grandParent = m_parent[parent].load(std::memory_order_relaxed);
+					//losing the race is fine, another thread shortened the path
+					auto expected = parent;
+					if (grandParent != parent)
+						m_parent[v].compare_exchange_weak(expected, grandParent, std::memory_order_relaxed);
+					v = parent;
+					parent = grandParent;
+				}
+				return v;
+			}
+
+			void unite(std::uint32_t u, std::uint32_t v)
+			{
+				for (;;) {
+					u = find(u);
+					v = find(v);
+					if (u == v)
+						return;
+					if (u < v)
+						std::swap(u, v);
+					//fails when another thread hooked u first, then both finds start over
+					auto root = u;
+					if (m_parent[u].compare_exchange_strong(root, v, std::memory_order_relaxed))
+						return;
+				}
+			}
+
+			ComponentLabels labels(unsigned nrThreads)
+			{
+				std::vector<std::uint32_t> root(m_size);
+				parallel_for(m_size, m_size < (1 << 16) ? 1u : nrThreads, [&](std::size_t v) {
+					root[v] = find(static_cast<std::uint32_t>(v));
+				});
+				return number_components(std::move(root));
+			}
+
+		private:
+			std::size_t m_size = 0;
+			std::unique_ptr<std::atomic<std::uint32_t>[]> m_parent;
+		};
+
+		//strongly connected components in three steps (Slota, Rajamanickam and Madduri, "BFS and
+		//coloring-based parallel algorithms for strongly connected components"):
+		//- trim: vertices in the Kahn order of the graph or of its reverse are on no cycle and are
+		//  components of their own; both orders come from topological_levels_rows
+		//- forward-backward: the vertices reached from a pivot of high degree by a parallel BFS forward,
+		//  and within those by one backward, form the pivot's component, in real graphs the giant one
+		//- what is left is small and goes through an iterative Tarjan on the calling thread
+		//on one thread only the forward trim and Tarjan run: the rest needs the reversed edges and touches
+		//every edge several times at random, where Tarjan touches it once. nothing recurses, so long
+		//paths and cycles need no stack.
+		class StrongComponentSearch
+		{
+		public:
+			StrongComponentSearch(std::size_t nrVertices, const std::uint64_t* offsets, const std::uint32_t* targets,
+				unsigned nrThreads)
+				: m_nrVertices(nrVertices), m_offsets(offsets), m_targets(targets), m_nrThreads(nrThreads),
+				m_component(std::make_unique<std::atomic<std::uint32_t>[]>(nrVertices))
+			{
+				parallel_for(nrVertices, threads_for(nrVertices), [this](std::size_t v) {
+					m_component[v].store(ComponentLabels::NoComponent, std::memory_order_relaxed);
+				});
+			}
+
+			ComponentLabels run()
+			{
+				if (!trim() && m_nrThreads > 1)
+					forward_backward();
+				tarjan();
+				std::vector<std::uint32_t> representative(m_nrVertices);
+				for (std::size_t v = 0; v < m_nrVertices; ++v)
+					representative[v] = m_component[v].load(std::memory_order_relaxed);
+				return number_components(std::move(representative));
+			}
+
+		private:
+			//marks the vertices of the forward search until the backward one claims them
+			static constexpr std::uint32_t Reached = ComponentLabels::NoComponent - 1;
+
+			unsigned threads_for(std::size_t nrItems) const { return nrItems < (1 << 14) ? 1u : m_nrThreads; }
+			bool assigned(std::uint32_t v) const { return m_component[v].load(std::memory_order_relaxed) != ComponentLabels::NoComponent; }
+
+			//true when every vertex was trimmed, which is the case for any acyclic graph
+			bool trim()
+			{
+				auto forward = topological_levels_rows(m_nrVertices, m_offsets, m_targets, m_nrThreads);
+				auto single = [this](const std::vector<std::uint32_t>& order) {
+					parallel_for(order.size(), threads_for(order.size()), [&](std::size_t i) {
+						m_component[order[i]].store(order[i], std::memory_order_relaxed);
+					});
+				};
+				single(forward.order);
+				if (forward.is_acyclic() || m_nrThreads == 1)
+					return forward.is_acyclic();
+				m_reverse = reverse_rows(m_nrVertices, m_offsets, m_targets, m_nrThreads);
+				single(topological_levels_rows(m_nrVertices, m_reverse.offsets.data(), m_reverse.targets.data(), m_nrThreads).order);
+				return false;
+			}
+
+			//level-synchronous BFS from source over rows; claim(v) decides, once per vertex, whether it
+			//joins the search
+			template <class Claim>
+			void bfs(std::uint32_t source, const std::uint64_t* offsets, const std::uint32_t* targets, Claim&& claim)
+			{
+				std::vector<std::uint32_t> frontier{ source };
+				std::vector<std::vector<std::uint32_t>> found(m_nrThreads);
+				while (!frontier.empty()) {
+					auto nrSlices = threads_for(frontier.size());
+					parallel_chunks(frontier.size(), nrSlices, [&](unsigned s, std::size_t begin, std::size_t end) {
+						for (auto i = begin; i < end; ++i) {
+							auto v = frontier[i];
+							for (auto e = offsets[v]; e < offsets[v + 1]; ++e) {
+								if (claim(targets[e]))
+									found[s].push_back(targets[e]);
+							}
+						}
+					});
+					frontier.clear();
+					for (unsigned s = 0; s < nrSlices; ++s) {
+						frontier.insert(frontier.end(), found[s].begin(), found[s].end());
+						found[s].clear();
+					}
+				}
+			}
+
+			void forward_backward()
+			{
+				//the component of the vertex with the most edges both ways is most likely the giant one
+				std::vector<std::pair<std::uint64_t, std::uint32_t>> best(m_nrThreads, { 0, 0 });
+				auto nrSlices = threads_for(m_nrVertices);
+				parallel_chunks(m_nrVertices, nrSlices, [&](unsigned s, std::size_t begin, std::size_t end) {
+					for (auto v = begin; v < end; ++v) {
+						if (assigned(static_cast<std::uint32_t>(v)))
+							continue;
+						auto score = (m_offsets[v + 1] - m_offsets[v]) * (m_reverse.offsets[v + 1] - m_reverse.offsets[v]);
+						if (score > best[s].first)
+							best[s] = { score, static_cast<std::uint32_t>(v) };
+					}
+				});
+				auto pivot = std::max_element(best.begin(), best.begin() + nrSlices)->second;
+				if (assigned(pivot))
+					return;
+
+				//a plain load first, most edges lead to vertices claimed already
+				auto claim = [this](std::uint32_t v, std::uint32_t from, std::uint32_t to) {
+					return m_component[v].load(std::memory_order_relaxed) == from
+						&& m_component[v].compare_exchange_strong(from, to, std::memory_order_relaxed);
+				};
+				m_component[pivot].store(Reached, std::memory_order_relaxed);
+				bfs(pivot, m_offsets, m_targets, [&](std::uint32_t v) { return claim(v, ComponentLabels::NoComponent, Reached); });
+				m_component[pivot].store(pivot, std::memory_order_relaxed);
+				bfs(pivot, m_reverse.offsets.data(), m_reverse.targets.data(), [&](std::uint32_t v) { return claim(v, Reached, pivot); });
+				parallel_for(m_nrVertices, threads_for(m_nrVertices), [&](std::size_t v) {
+					auto none = Reached;
+					m_component[v].compare_exchange_strong(none, ComponentLabels::NoComponent, std::memory_order_relaxed);
+				});
+			}
+
+			//Tarjan over the vertices not assigned yet, with an explicit stack of (vertex, next edge).
+			//edges into assigned vertices are skipped: those vertices form complete components already.
+			void tarjan()
+			{
+				constexpr auto Unvisited = std::numeric_limits<std::uint32_t>::max();
+				std::vector<std::uint32_t> index;
+				std::vector<std::uint32_t> low;
+				std::vector<std::uint32_t> open;
+				std::vector<std::pair<std::uint32_t, std::uint64_t>> calls;
+				auto nrVisited = std::uint32_t{ 0 };
+				auto visit = [&](std::uint32_t v) {
+					index[v] = low[v] = nrVisited++;
+					open.push_back(v);
+					calls.emplace_back(v, m_offsets[v]);
+				};
+				for (std::uint32_t root = 0; root < m_nrVertices; ++root) {
+					if (assigned(root) || (!index.empty() && index[root] != Unvisited))
+						continue;
+					if (index.empty()) {
+						index.assign(m_nrVertices, Unvisited);
+						low.resize(m_nrVertices);
+					}
+					visit(root);
+					while (!calls.empty()) {
+						auto& [v, e] = calls.back();
+						if (e < m_offsets[v + 1]) {
+							auto w = m_targets[e++];
+							if (assigned(w))
+								continue;
+							if (index[w] == Unvisited)
+								visit(w);
+							else
+								low[v] = std::min(low[v], index[w]);
+							continue;
+						}
+						auto finished = v;
+						calls.pop_back();
+						if (!calls.empty())
+							low[calls.back().first] = std::min(low[calls.back().first], low[finished]);
+						if (low[finished] != index[finished])
+							continue;
+						for (auto w = open.back();; w = open.back()) {
+							open.pop_back();
+							m_component[w].store(finished, std::memory_order_relaxed);
+							if (w == finished)
+								break;
+						}
+					}
+				}
+			}
+
+			std::size_t m_nrVertices;
+			const std::uint64_t* m_offsets;
+			const std::uint32_t* m_targets;
+			unsigned m_nrThreads;
+			CsrStorage m_reverse;
+			std::unique_ptr<std::atomic<std::uint32_t>[]> m_component;
+		};
+
+		inline ComponentLabels strongly_connected_rows(std::size_t nrVertices, const std::uint64_t* offsets,
+			const std::uint32_t* targets, unsigned nrThreads)
+		{
+			check_component_vertices(nrVertices);
+			nrThreads = nrThreads == 0 ? default_thread_count() : nrThreads;
+			return StrongComponentSearch{ nrVertices, offsets, targets, nrThreads }.run();
+		}
+	}
+
+	//strongly connected components of a CsrGraph, see detail::StrongComponentSearch. nrThreads 0 uses
+	//all cores.
+	inline ComponentLabels strongly_connected_components(const CsrGraph& g, unsigned nrThreads = 0)
+	{
+		auto& a = g.arrays();
+		return detail::strongly_connected_rows(a.nrVertices, a.offsets, a.targets, nrThreads);
+	}
+
+	//Dag and the other graphs with vertices numbered 0..n-1 are copied into CSR rows first, the
+	//searches make several passes over the out-edges
+	template <class Graph>
+	ComponentLabels strongly_connected_components(const Graph& g, unsigned nrThreads = 0)
+	{
+		auto rows = make_csr_topology(g, nrThreads);
+		return detail::strongly_connected_rows(rows.offsets.size() - 1, rows.offsets.data(), rows.targets.data(), nrThreads);
+	}
+
+	//weakly connected components of a CsrGraph: one lock-free union per edge, the edges split evenly
+	//over the threads whatever the degrees
+	inline ComponentLabels weakly_connected_components(const CsrGraph& g, unsigned nrThreads = 0)
+	{
+		auto& a = g.arrays();
+		detail::check_component_vertices(a.nrVertices);
+		nrThreads = nrThreads == 0 ? default_thread_count() : nrThreads;
+		auto sets = detail::ConcurrentUnionFind{ a.nrVertices, nrThreads };
+		parallel_chunks(a.nrEdges, a.nrEdges < (1 << 16) ? 1u : nrThreads, [&](unsigned, std::size_t begin, std::size_t end) {
+			if (begin == end)
+				return;
+			auto source = static_cast<std::size_t>(std::upper_bound(a.offsets, a.offsets + a.nrVertices + 1, begin) - a.offsets - 1);
+			for (auto e = begin; e < end; ++e) {
+				while (a.offsets[source + 1] <= e)
+					++source;
+				sets.unite(static_cast<std::uint32_t>(source), a.targets[e]);
+			}
+		});
+		return sets.labels(nrThreads);
+	}
+
+	//one pass over the out-edges straight from the graph, split by vertices; needs vertices numbered
+	//0..n-1 (vecS)
+	template <class Graph>
+	ComponentLabels weakly_connected_components(const Graph& g, unsigned nrThreads = 0)
+	{
+		auto nrVertices = static_cast<std::size_t>(boost::num_vertices(g));
+		detail::check_component_vertices(nrVertices);
+		nrThreads = nrThreads == 0 ? default_thread_count() : nrThreads;
+		auto index = get(boost::vertex_index, g);
+		auto sets = detail::ConcurrentUnionFind{ nrVertices, nrThreads };
+		parallel_for(nrVertices, nrVertices < (1 << 14) ? 1u : nrThreads, [&](std::size_t v) {
+			auto vertex = static_cast<typename boost::graph_traits<Graph>::vertex_descriptor>(v);
+			for (auto [e, eEnd] = boost::out_edges(vertex, g); e != eEnd; ++e)
+				sets.unite(static_cast<std::uint32_t>(v), static_cast<std::uint32_t>(get(index, boost::target(*e, g))));
+		});
+		return sets.labels(nrThreads);
+	}
+
+	//true when all edges of g lie in one component of labels (weak or strong); a graph without edges
+	//counts as connected
+	template <class Graph>
+	bool edges_in_one_component(const Graph& g, const ComponentLabels& labels)
+	{
+		auto index = get(boost::vertex_index, g);
+		auto component = ComponentLabels::NoComponent;
+		for (auto [v, vEnd] = boost::vertices(g); v != vEnd; ++v) {
+			if (boost::out_degree(*v, g) == 0)
+				continue;
+			auto c = labels.component[get(index, *v)];
+			if (component == ComponentLabels::NoComponent)
+				component = c;
+			else if (c != component)
+				return false;
+			for (auto [e, eEnd] = boost::out_edges(*v, g); e != eEnd; ++e) {
+				if (labels.component[get(index, boost::target(*e, g))] != component)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	//the full condition for an Euler circuit or trail: check_euler_degrees, then all edges in one weak
+	//component. weak components are enough: when every vertex is balanced each edge lies on a cycle,
+	//so weakly connected edges are strongly connected, and a trail only needs them weakly connected.
+	//balance is None when either part fails.
+	template <class Graph>
+	EulerDegreeCheck<Graph> check_euler_graph(const Graph& g, unsigned nrThreads = 0)
+	{
+		auto check = check_euler_degrees(g);
+		if (check.balance == EulerBalance::None || edges_in_one_component(g, weakly_connected_components(g, nrThreads)))
+			return check;
+		return {};
+	}
+}
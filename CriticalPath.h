@@ -0,0 +1,230 @@
+#pragma once
+#include "CsrGraph.h"
+#include "Parallel.h"
+#include "TopologicalSort.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace bglx::test
+{
+	//weights as structure of arrays: vertex[v] is the duration of v and edge[e] the delay on edge e,
+	//by edge index (for a Dag: the e-th out-edge met walking vertices() and out_edges() in order).
+	//either may be left empty, which counts as zero.
+	struct DagWeights
+	{
+		std::vector<double> vertex;
+		std::vector<double> edge;
+	};
+
+	struct DagLongestPath
+	{
+		//largest earliest finish, the total weight of path
+		double length = 0;
+		//vertices of one longest path, from a source to a sink (unless negative weights make stopping
+		//early the longest)
+		std::vector<std::uint32_t> path;
+	};
+
+	//longest path plus the schedule around it. earliest[v] is the earliest start of v after all its
+	//predecessors finished, latest[v] the latest start that does not delay the end; vertices without
+	//slack are critical.
+	struct DagSchedule : DagLongestPath
+	{
+		std::vector<double> earliest;
+		std::vector<double> latest;
+
+		double slack(std::size_t v) const { return latest[v] - earliest[v]; }
+	};
+
+	namespace detail
+	{
+		//the passes go level by level over topological_levels, so a vertex only reads vertices of other
+		//levels and nothing recurses. with several threads both passes pull, the forward pass over in-edges
+		//(the rows reversed once) and the backward pass over out-edges, and a wide level is split by its
+		//vertices: every vertex writes only itself. one thread pushes forward along the out-edges instead,
+		//and ties go to the lowest predecessor either way, so the result does not depend on the thread count.
+		class LevelSchedule
+		{
+		public:
+			LevelSchedule(const CsrGraph& g, const DagWeights& weights, unsigned nrThreads)
+				: m_g(g), m_weights(weights)
+			{
+				auto n = g.nr_vertices();
+				if (!weights.vertex.empty() && weights.vertex.size() != n)
+					throw std::invalid_argument("There must be one vertex weight per vertex.");
+				if (!weights.edge.empty() && weights.edge.size() != g.nr_edges())
+					throw std::invalid_argument("There must be one edge weight per edge.");
+				m_nrThreads = nrThreads == 0 ? default_thread_count() : nrThreads;
+				m_levels = topological_levels(g, m_nrThreads);
+				if (!m_levels.is_acyclic())
+					throw std::invalid_argument("Longest paths need an acyclic graph.");
+			}
+
+			//earliest starts and, for every vertex, the predecessor that decided it: itself for sources, the
+			//lowest id among predecessors that tie
+			void forward(std::vector<double>& earliest, std::vector<std::uint32_t>& from) const
+			{
+				auto& a = m_g.arrays();
+				auto n = a.nrVertices;
+				earliest.assign(n, 0.0);
+				from.resize(n);
+				for (std::uint32_t v = 0; v < n; ++v)
+					from[v] = v;
+				//one thread pushes along the out-edges, which needs no reversed rows
+				if (m_nrThreads == 1 || a.nrEdges < (1 << 16)) {
+					for_each_level_forward([&](std::uint32_t u) {
+						auto finish = earliest[u] + vertex_weight(u);
+						for (auto e = a.offsets[u]; e < a.offsets[u + 1]; ++e) {
+							auto v = a.targets[e];
+							auto start = finish + edge_weight(e);
+							if (from[v] == v || start > earliest[v] || (start == earliest[v] && u < from[v])) {
+								earliest[v] = start;
+								from[v] = u;
+							}
+						}
+					}, 1);
+					return;
+				}
+
+				//in-edges by target, sources ascending, with the weight of the edge so a pull reads them in order
+				struct InEdge
+				{
+					std::uint32_t source;
+					double weight;
+				};
+				std::vector<std::uint64_t> inOffsets;
+				auto inEdges = scatter_rows_by_owner<InEdge>(n, m_nrThreads, [&](std::size_t c, auto&& emit) {
+					for_each_row_edge(n, a.offsets, a.nrEdges * c / m_nrThreads, a.nrEdges * (c + 1) / m_nrThreads,
+						[&](std::size_t u, std::uint64_t e) { emit(a.targets[e], InEdge{ static_cast<std::uint32_t>(u), edge_weight(e) }); });
+				}, m_nrThreads, inOffsets);
+				//earliest finish, one read per in-edge
+				std::vector<double> finish(n);
+				for_each_level_forward([&](std::uint32_t v) {
+					for (auto i = inOffsets[v]; i < inOffsets[v + 1]; ++i) {
+						auto start = finish[inEdges[i].source] + inEdges[i].weight;
+						if (from[v] == v || start > earliest[v]) {
+							earliest[v] = start;
+							from[v] = inEdges[i].source;
+						}
+					}
+					finish[v] = earliest[v] + vertex_weight(v);
+				}, m_nrThreads);
+			}
+
+			//latest starts for a schedule that ends at length
+			void backward(double length, std::vector<double>& latest) const
+			{
+				auto& a = m_g.arrays();
+				latest.assign(m_g.nr_vertices(), 0);
+				for_each_level_backward([&](std::uint32_t v) {
+					auto finish = length;
+					for (auto e = a.offsets[v]; e < a.offsets[v + 1]; ++e)
+						finish = std::min(finish, latest[a.targets[e]] - edge_weight(e));
+					latest[v] = finish - vertex_weight(v);
+				});
+			}
+
+			//longest path ending at the vertex with the largest earliest finish. a vertex finishes with its
+			//successor only over zero weights, among equal finishes a sink wins
+			DagLongestPath path(const std::vector<double>& earliest, const std::vector<std::uint32_t>& from) const
+			{
+				auto result = DagLongestPath{};
+				if (earliest.empty())
+					return result;
+				auto& a = m_g.arrays();
+				auto isSink = [&a](std::uint32_t v) { return a.offsets[v + 1] == a.offsets[v]; };
+				auto last = std::uint32_t{ 0 };
+				for (std::uint32_t v = 0; v < earliest.size(); ++v) {
+					auto finish = earliest[v] + vertex_weight(v);
+					auto best = earliest[last] + vertex_weight(last);
+					if (finish > best || (finish == best && isSink(v) && !isSink(last)))
+						last = v;
+				}
+				result.length = earliest[last] + vertex_weight(last);
+				for (auto v = last;; v = from[v]) {
+					result.path.push_back(v);
+					if (from[v] == v)
+						break;
+				}
+				std::reverse(result.path.begin(), result.path.end());
+				return result;
+			}
+
+		private:
+			double vertex_weight(std::size_t v) const { return m_weights.vertex.empty() ? 0.0 : m_weights.vertex[v]; }
+			double edge_weight(std::size_t e) const { return m_weights.edge.empty() ? 0.0 : m_weights.edge[e]; }
+
+			//levels from the first to the last, fn(v) for every vertex
+			template <class Fn>
+			void for_each_level_forward(Fn&& fn, unsigned nrThreads) const
+			{
+				for (std::size_t level = 0; level < m_levels.nr_levels(); ++level)
+					for_each_in_level(level, fn, nrThreads);
+			}
+
+			//levels from the last to the first
+			template <class Fn>
+			void for_each_level_backward(Fn&& fn) const
+			{
+				for (auto level = m_levels.nr_levels(); level-- > 0;)
+					for_each_in_level(level, fn, m_nrThreads);
+			}
+
+			template <class Fn>
+			void for_each_in_level(std::size_t level, Fn& fn, unsigned nrThreads) const
+			{
+				constexpr std::size_t MinParallel = 1 << 14;
+				auto begin = m_levels.levelOffsets[level];
+				auto size = m_levels.levelOffsets[level + 1] - begin;
+				parallel_chunks(size, size < MinParallel ? 1u : nrThreads, [&](unsigned, std::size_t first, std::size_t end) {
+					for (auto j = begin + first; j < begin + end; ++j)
+						fn(m_levels.order[j]);
+				});
+			}
+
+			const CsrGraph& m_g;
+			const DagWeights& m_weights;
+			unsigned m_nrThreads = 1;
+			TopologicalLevels m_levels;
+		};
+	}
+
+	//longest weighted path of an acyclic CsrGraph, one forward pass. nrThreads 0 uses all cores.
+	//throws std::invalid_argument on a cycle or when the weights do not match the graph.
+	static DagLongestPath dag_longest_path(const CsrGraph& g, const DagWeights& weights, unsigned nrThreads = 0)
+	{
+		auto schedule = detail::LevelSchedule{ g, weights, nrThreads };
+		std::vector<double> earliest;
+		std::vector<std::uint32_t> from;
+		schedule.forward(earliest, from);
+		return schedule.path(earliest, from);
+	}
+
+	//longest path with earliest and latest start times, one pass each way
+	static DagSchedule dag_critical_path(const CsrGraph& g, const DagWeights& weights, unsigned nrThreads = 0)
+	{
+		auto schedule = detail::LevelSchedule{ g, weights, nrThreads };
+		auto result = DagSchedule{};
+		std::vector<std::uint32_t> from;
+		schedule.forward(result.earliest, from);
+		static_cast<DagLongestPath&>(result) = schedule.path(result.earliest, from);
+		schedule.backward(result.length, result.latest);
+		return result;
+	}
+
+	//Dag and the other vecS graphs go through their CSR rows, which keep the out-edge order
+	template <class Graph>
+	DagLongestPath dag_longest_path(const Graph& g, const DagWeights& weights, unsigned nrThreads = 0)
+	{
+		return dag_longest_path(CsrGraph{ make_csr_topology(g, nrThreads) }, weights, nrThreads);
+	}
+
+	template <class Graph>
+	DagSchedule dag_critical_path(const Graph& g, const DagWeights& weights, unsigned nrThreads = 0)
+	{
+		return dag_critical_path(CsrGraph{ make_csr_topology(g, nrThreads) }, weights, nrThreads);
+	}
+}
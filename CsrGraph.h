@@ -0,0 +1,467 @@
+#pragma once
+#include "NamedDag.h"
+#include "Parallel.h"
+#include <boost/graph/graph_traits.hpp>
+#include <boost/graph/properties.hpp>
+#include <boost/iterator/counting_iterator.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/property_map/property_map.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bglx::test
+{
+	struct CsrEdge
+	{
+		std::size_t source;
+		//position in the target array, doubles as the edge index
+		std::size_t index;
+
+		bool operator==(const CsrEdge& other) const { return index == other.index; }
+		bool operator!=(const CsrEdge& other) const { return index != other.index; }
+		bool operator<(const CsrEdge& other) const { return index < other.index; }
+	};
+
+	//vectors behind an in-memory CsrGraph, also what the builders fill in.
+	//name offsets are either empty (no names) or have one more entry than there are vertices/edges.
+	struct CsrStorage
+	{
+		std::vector<std::uint64_t> offsets{ 0 };
+		std::vector<std::uint32_t> targets;
+		std::vector<std::uint64_t> vertexNameOffsets;
+		std::string vertexNames;
+		std::vector<std::uint64_t> edgeNameOffsets;
+		std::string edgeNames;
+	};
+
+	//read-only compressed sparse row digraph over arrays it does not own. the arrays are kept alive by
+	//a shared owner, which is a CsrStorage for graphs built in memory or the mapping of a snapshot file.
+	//models IncidenceGraph, VertexListGraph and EdgeListGraph with vertices numbered 0..n-1.
+	class CsrGraph
+	{
+	public:
+		struct Arrays
+		{
+			std::size_t nrVertices = 0;
+			std::size_t nrEdges = 0;
+			const std::uint64_t* offsets = nullptr;
+			const std::uint32_t* targets = nullptr;
+			const std::uint64_t* vertexNameOffsets = nullptr;
+			const char* vertexNames = nullptr;
+			const std::uint64_t* edgeNameOffsets = nullptr;
+			const char* edgeNames = nullptr;
+		};
+
+		CsrGraph() : CsrGraph(CsrStorage{}) { }
+
+		explicit CsrGraph(CsrStorage storage)
+		{
+			auto owner = std::make_shared<const CsrStorage>(std::move(storage));
+			auto& s = *owner;
+			m_arrays.nrVertices = s.offsets.size() - 1;
+			m_arrays.nrEdges = s.targets.size();
+			m_arrays.offsets = s.offsets.data();
+			m_arrays.targets = s.targets.data();
+			if (!s.vertexNameOffsets.empty()) {
+				m_arrays.vertexNameOffsets = s.vertexNameOffsets.data();
+				m_arrays.vertexNames = s.vertexNames.data();
+			}
+			if (!s.edgeNameOffsets.empty()) {
+				m_arrays.edgeNameOffsets = s.edgeNameOffsets.data();
+				m_arrays.edgeNames = s.edgeNames.data();
+			}
+			m_owner = std::move(owner);
+		}
+
+		CsrGraph(const Arrays& arrays, std::shared_ptr<const void> owner)
+			: m_arrays(arrays), m_owner(std::move(owner)) { }
+
+		const Arrays& arrays() const { return m_arrays; }
+		std::size_t nr_vertices() const { return m_arrays.nrVertices; }
+		std::size_t nr_edges() const { return m_arrays.nrEdges; }
+		std::size_t out_begin(std::size_t v) const { return static_cast<std::size_t>(m_arrays.offsets[v]); }
+		std::size_t out_end(std::size_t v) const { return static_cast<std::size_t>(m_arrays.offsets[v + 1]); }
+		std::size_t target_at(std::size_t edgeIndex) const { return m_arrays.targets[edgeIndex]; }
+
+		bool has_vertex_names() const { return m_arrays.vertexNameOffsets != nullptr; }
+		bool has_edge_names() const { return m_arrays.edgeNameOffsets != nullptr; }
+
+		std::string_view vertex_name(std::size_t v) const
+		{
+			auto beg = m_arrays.vertexNameOffsets[v];
+			return { m_arrays.vertexNames + beg, static_cast<std::size_t>(m_arrays.vertexNameOffsets[v + 1] - beg) };
+		}
+
+		std::string_view edge_name(const CsrEdge& e) const
+		{
+			auto beg = m_arrays.edgeNameOffsets[e.index];
+			return { m_arrays.edgeNames + beg, static_cast<std::size_t>(m_arrays.edgeNameOffsets[e.index + 1] - beg) };
+		}
+
+	private:
+		Arrays m_arrays;
+		std::shared_ptr<const void> m_owner;
+	};
+
+	class CsrOutEdgeIterator
+		: public boost::iterator_facade<CsrOutEdgeIterator, CsrEdge, std::random_access_iterator_tag, CsrEdge>
+	{
+	public:
+		CsrOutEdgeIterator() = default;
+		CsrOutEdgeIterator(std::size_t source, std::size_t index) : m_source(source), m_index(index) { }
+
+	private:
+		friend class boost::iterator_core_access;
+		CsrEdge dereference() const { return { m_source, m_index }; }
+		bool equal(const CsrOutEdgeIterator& other) const { return m_index == other.m_index; }
+		void increment() { ++m_index; }
+		void decrement() { --m_index; }
+		void advance(std::ptrdiff_t n) { m_index += n; }
+		std::ptrdiff_t distance_to(const CsrOutEdgeIterator& other) const
+		{
+			return static_cast<std::ptrdiff_t>(other.m_index) - static_cast<std::ptrdiff_t>(m_index);
+		}
+
+		std::size_t m_source = 0;
+		std::size_t m_index = 0;
+	};
+
+	//walks all edges in index order, tracking the source vertex as it crosses the row offsets
+	class CsrEdgeIterator
+		: public boost::iterator_facade<CsrEdgeIterator, CsrEdge, std::forward_iterator_tag, CsrEdge>
+	{
+	public:
+		CsrEdgeIterator() = default;
+		CsrEdgeIterator(const CsrGraph* g, std::size_t index) : m_g(g), m_index(index) { skip_empty_rows(); }
+
+	private:
+		friend class boost::iterator_core_access;
+		CsrEdge dereference() const { return { m_source, m_index }; }
+		bool equal(const CsrEdgeIterator& other) const { return m_index == other.m_index; }
+		void increment()
+		{
+			++m_index;
+			skip_empty_rows();
+		}
+		void skip_empty_rows()
+		{
+			while (m_source < m_g->nr_vertices() && m_g->out_end(m_source) <= m_index)
+				++m_source;
+		}
+
+		const CsrGraph* m_g = nullptr;
+		std::size_t m_source = 0;
+		std::size_t m_index = 0;
+	};
+
+	//edge index map of a CsrGraph, the position of the edge in the target array
+	struct CsrEdgeIndexMap
+	{
+		using key_type = CsrEdge;
+		using value_type = std::size_t;
+		using reference = std::size_t;
+		using category = boost::readable_property_map_tag;
+	};
+
+	inline std::size_t get(CsrEdgeIndexMap, const CsrEdge& e) { return e.index; }
+
+	inline std::pair<boost::counting_iterator<std::size_t>, boost::counting_iterator<std::size_t>>
+		vertices(const CsrGraph& g)
+	{
+		return { boost::counting_iterator<std::size_t>(0), boost::counting_iterator<std::size_t>(g.nr_vertices()) };
+	}
+
+	inline std::size_t num_vertices(const CsrGraph& g) { return g.nr_vertices(); }
+	inline std::size_t num_edges(const CsrGraph& g) { return g.nr_edges(); }
+
+	inline std::pair<CsrOutEdgeIterator, CsrOutEdgeIterator> out_edges(std::size_t v, const CsrGraph& g)
+	{
+		return { CsrOutEdgeIterator(v, g.out_begin(v)), CsrOutEdgeIterator(v, g.out_end(v)) };
+	}
+
+	inline std::size_t out_degree(std::size_t v, const CsrGraph& g) { return g.out_end(v) - g.out_begin(v); }
+
+	inline std::pair<CsrEdgeIterator, CsrEdgeIterator> edges(const CsrGraph& g)
+	{
+		return { CsrEdgeIterator(&g, 0), CsrEdgeIterator(&g, g.nr_edges()) };
+	}
+
+	inline std::size_t source(const CsrEdge& e, const CsrGraph&) { return e.source; }
+	inline std::size_t target(const CsrEdge& e, const CsrGraph& g) { return g.target_at(e.index); }
+
+	inline boost::typed_identity_property_map<std::size_t> get(boost::vertex_index_t, const CsrGraph&) { return {}; }
+	inline CsrEdgeIndexMap get(boost::edge_index_t, const CsrGraph&) { return {}; }
+
+	//copies a Dag (topology and names) into CSR form, out-edges keep their setS order
+	static CsrGraph make_csr_graph(const Dag& dag)
+	{
+		auto nrVertices = boost::num_vertices(dag);
+		if (nrVertices > std::numeric_limits<std::uint32_t>::max())
+			throw std::invalid_argument("CSR rows support up to 2^32 - 1 vertices.");
+		auto storage = CsrStorage{};
+		storage.offsets.reserve(nrVertices + 1);
+		storage.targets.reserve(boost::num_edges(dag));
+		storage.vertexNameOffsets.reserve(nrVertices + 1);
+		storage.vertexNameOffsets.push_back(0);
+		storage.edgeNameOffsets.reserve(boost::num_edges(dag) + 1);
+		storage.edgeNameOffsets.push_back(0);
+		for (auto v : boost::make_iterator_range(boost::vertices(dag))) {
+			for (auto e : boost::make_iterator_range(boost::out_edges(v, dag))) {
+				storage.targets.push_back(static_cast<std::uint32_t>(boost::target(e, dag)));
+				storage.edgeNames += dag[e].name;
+				storage.edgeNameOffsets.push_back(storage.edgeNames.size());
+			}
+			storage.offsets.push_back(storage.targets.size());
+			storage.vertexNames += dag[v].name;
+			storage.vertexNameOffsets.push_back(storage.vertexNames.size());
+		}
+		return CsrGraph{ std::move(storage) };
+	}
+}
+
+namespace boost
+{
+	template <>
+	struct graph_traits<bglx::test::CsrGraph>
+	{
+		using vertex_descriptor = std::size_t;
+		using edge_descriptor = bglx::test::CsrEdge;
+		using directed_category = directed_tag;
+		using edge_parallel_category = allow_parallel_edge_tag;
+		struct traversal_category
+			: incidence_graph_tag, vertex_list_graph_tag, edge_list_graph_tag { };
+		using vertex_iterator = counting_iterator<std::size_t>;
+		using out_edge_iterator = bglx::test::CsrOutEdgeIterator;
+		using edge_iterator = bglx::test::CsrEdgeIterator;
+		using vertices_size_type = std::size_t;
+		using edges_size_type = std::size_t;
+		using degree_size_type = std::size_t;
+		static vertex_descriptor null_vertex() { return std::numeric_limits<std::size_t>::max(); }
+	};
+
+	template <>
+	struct property_map<bglx::test::CsrGraph, vertex_index_t>
+	{
+		using type = typed_identity_property_map<std::size_t>;
+		using const_type = type;
+	};
+
+	template <>
+	struct property_map<bglx::test::CsrGraph, edge_index_t>
+	{
+		using type = bglx::test::CsrEdgeIndexMap;
+		using const_type = type;
+	};
+
+	//so that boost::num_vertices(csr) and friends work like they do for Dag
+	using bglx::test::vertices;
+	using bglx::test::num_vertices;
+	using bglx::test::num_edges;
+	using bglx::test::out_edges;
+	using bglx::test::out_degree;
+	using bglx::test::edges;
+	using bglx::test::source;
+	using bglx::test::target;
+	using bglx::test::get;
+}
+
+namespace bglx::test
+{
+	//copies a CsrGraph into a Dag; parallel edges collapse onto the first one, as setS does.
+	//vertices without a stored name are named by their index.
+	static Dag make_dag(const CsrGraph& csr)
+	{
+		auto dag = Dag{ boost::num_vertices(csr) };
+		for (auto v : boost::make_iterator_range(boost::vertices(csr))) {
+			dag[v].name = csr.has_vertex_names() ? std::string{ csr.vertex_name(v) } : std::to_string(v);
+			for (auto e : boost::make_iterator_range(boost::out_edges(v, csr))) {
+				auto [dagE, added] = boost::add_edge(v, boost::target(e, csr), dag);
+				if (added && csr.has_edge_names())
+					dag[dagE].name = csr.edge_name(e);
+			}
+		}
+		return dag;
+	}
+
+	//copies only the out-edges of a graph with vertices numbered 0..n-1 (vecS, CsrGraph) into CSR rows,
+	//without names. rows are filled in parallel once their offsets are known.
+	template <class Graph>
+	static CsrStorage make_csr_topology(const Graph& g, unsigned nrThreads = 0)
+	{
+		auto nrVertices = static_cast<std::size_t>(boost::num_vertices(g));
+		if (nrVertices > std::numeric_limits<std::uint32_t>::max())
+			throw std::invalid_argument("CSR rows support up to 2^32 - 1 vertices.");
+		nrThreads = nrThreads == 0 ? default_thread_count() : nrThreads;
+		auto vertex = [](std::size_t i) { return static_cast<typename boost::graph_traits<Graph>::vertex_descriptor>(i); };
+		auto index = get(boost::vertex_index, g);
+
+		auto storage = CsrStorage{};
+		storage.offsets.assign(nrVertices + 1, 0);
+		for (std::size_t v = 0; v < nrVertices; ++v)
+			storage.offsets[v + 1] = storage.offsets[v] + boost::out_degree(vertex(v), g);
+		storage.targets.resize(storage.offsets[nrVertices]);
+		parallel_for(nrVertices, nrVertices < (1 << 14) ? 1u : nrThreads, [&](std::size_t v) {
+			auto row = storage.offsets[v];
+			for (auto [e, eEnd] = boost::out_edges(vertex(v), g); e != eEnd; ++e)
+				storage.targets[row++] = static_cast<std::uint32_t>(get(index, boost::target(*e, g)));
+		});
+		return storage;
+	}
+
+	namespace detail
+	{
+		//rows [0, nrRows) split into nrOwners ranges of rowsPerOwner rows, the last one may be shorter
+		struct OwnerRanges
+		{
+			OwnerRanges(std::size_t rows, unsigned nrThreads)
+				: nrRows(rows),
+				rowsPerOwner(std::max<std::size_t>(1, (rows + std::max(1u, nrThreads) - 1) / std::max(1u, nrThreads))),
+				nrOwners(static_cast<unsigned>(std::max<std::size_t>(1, (rows + rowsPerOwner - 1) / rowsPerOwner))) { }
+
+			unsigned owner(std::size_t row) const { return static_cast<unsigned>(row / rowsPerOwner); }
+			std::size_t begin(unsigned o) const { return std::min(o * rowsPerOwner, nrRows); }
+			std::size_t end(unsigned o) const { return begin(o + 1); }
+
+			std::size_t nrRows;
+			std::size_t rowsPerOwner;
+			unsigned nrOwners;
+		};
+
+		//regroups the items of nrChunks chunks by the owner of their row in two passes: every chunk
+		//counts its items per owner, a prefix sum over (owner, chunk) hands every chunk its slots, then
+		//every chunk writes its own items. forEachItem(c, emit) calls emit(row, item) for the items of
+		//chunk c, the same ones in the same order on both calls. owner o gets [ownerOffsets[o],
+		//ownerOffsets[o + 1]), its items in chunk order and in emit order within a chunk.
+		template <class Item, class ForEachItem>
+		std::vector<Item> partition_by_owner(const OwnerRanges& owners, std::size_t nrChunks, ForEachItem&& forEachItem,
+			unsigned nrThreads, std::vector<std::uint64_t>& ownerOffsets)
+		{
+			auto nrOwners = owners.nrOwners;
+			std::vector<std::uint64_t> slots(nrChunks * nrOwners, 0);
+			parallel_for(nrChunks, nrThreads, [&](std::size_t c) {
+				auto count = slots.data() + c * nrOwners;
+				forEachItem(c, [&](std::size_t row, const Item&) { ++count[owners.owner(row)]; });
+			});
+			ownerOffsets.assign(nrOwners + 1, 0);
+			auto nrItems = std::uint64_t{ 0 };
+			for (unsigned o = 0; o < nrOwners; ++o) {
+				ownerOffsets[o] = nrItems;
+				for (std::size_t c = 0; c < nrChunks; ++c)
+					nrItems += std::exchange(slots[c * nrOwners + o], nrItems);
+			}
+			ownerOffsets[nrOwners] = nrItems;
+			std::vector<Item> items(nrItems);
+			parallel_for(nrChunks, nrThreads, [&](std::size_t c) {
+				auto next = slots.data() + c * nrOwners;
+				forEachItem(c, [&](std::size_t row, const Item& item) { items[next[owners.owner(row)]++] = item; });
+			});
+			return items;
+		}
+
+		//CSR rows from edges spread over several chunks (parse buffers, producers, slices of a graph).
+		//forEachEdge(c, emit) calls emit(row, value) for every edge of chunk c, the same edges in the
+		//same order on every call. returns the values row by row, every row in chunk order and in emit
+		//order within a chunk, and sets offsets to the nrRows + 1 row starts. the edges are regrouped by
+		//the thread that owns their row first, so every thread only counts and places its own edges:
+		//O(E) work for any thread count and no atomics.
+		template <class Value, class ForEachEdge>
+		std::vector<Value> scatter_rows_by_owner(std::size_t nrRows, std::size_t nrChunks, ForEachEdge&& forEachEdge,
+			unsigned nrThreads, std::vector<std::uint64_t>& offsets)
+		{
+			auto owners = OwnerRanges{ nrRows, nrThreads };
+			offsets.assign(nrRows + 1, 0);
+			std::vector<Value> rows;
+			if (owners.nrOwners == 1) {
+				for (std::size_t c = 0; c < nrChunks; ++c)
+					forEachEdge(c, [&](std::size_t row, const Value&) { ++offsets[row + 1]; });
+				for (std::size_t row = 0; row < nrRows; ++row)
+					offsets[row + 1] += offsets[row];
+				rows.resize(offsets[nrRows]);
+				std::vector<std::uint64_t> cursor(offsets.begin(), offsets.end() - 1);
+				for (std::size_t c = 0; c < nrChunks; ++c)
+					forEachEdge(c, [&](std::size_t row, const Value& value) { rows[cursor[row]++] = value; });
+				return rows;
+			}
+
+			struct RowValue
+			{
+				std::uint32_t row;
+				Value value;
+			};
+			std::vector<std::uint64_t> ownerOffsets;
+			auto items = partition_by_owner<RowValue>(owners, nrChunks, [&](std::size_t c, auto&& emit) {
+				forEachEdge(c, [&](std::size_t row, const Value& value) { emit(row, RowValue{ static_cast<std::uint32_t>(row), value }); });
+			}, nrThreads, ownerOffsets);
+			rows.resize(items.size());
+			parallel_for(owners.nrOwners, owners.nrOwners, [&](std::size_t o) {
+				auto rowBegin = owners.begin(static_cast<unsigned>(o));
+				auto rowEnd = owners.end(static_cast<unsigned>(o));
+				std::vector<std::uint64_t> cursor(rowEnd - rowBegin + 1, 0);
+				cursor[0] = ownerOffsets[o];
+				for (auto i = ownerOffsets[o]; i < ownerOffsets[o + 1]; ++i)
+					++cursor[items[i].row - rowBegin + 1];
+				for (std::size_t row = rowBegin; row < rowEnd; ++row) {
+					cursor[row - rowBegin + 1] += cursor[row - rowBegin];
+					offsets[row] = cursor[row - rowBegin];
+				}
+				for (auto i = ownerOffsets[o]; i < ownerOffsets[o + 1]; ++i)
+					rows[cursor[items[i].row - rowBegin]++] = items[i].value;
+			});
+			offsets[nrRows] = items.size();
+			return rows;
+		}
+
+		//fn(u, e) for the edges [eBegin, eEnd) of CSR rows, u the row (source) of edge e
+		template <class Fn>
+		void for_each_row_edge(std::size_t nrVertices, const std::uint64_t* offsets, std::uint64_t eBegin, std::uint64_t eEnd, Fn&& fn)
+		{
+			auto u = static_cast<std::size_t>(std::upper_bound(offsets, offsets + nrVertices + 1, eBegin) - offsets - 1);
+			for (auto e = eBegin; e < eEnd; ++e) {
+				while (offsets[u + 1] <= e)
+					++u;
+				fn(u, e);
+			}
+		}
+
+		//edges reversed into CSR rows, each row sorted by source. the edges are cut into one chunk per
+		//thread of about equal size, in source order.
+		inline CsrStorage reverse_rows(std::size_t nrVertices, const std::uint64_t* offsets,
+			const std::uint32_t* targets, unsigned nrThreads)
+		{
+			auto nrEdges = offsets[nrVertices];
+			auto threads = nrEdges < (1 << 16) ? 1u : nrThreads;
+			auto reversed = CsrStorage{};
+			reversed.targets = scatter_rows_by_owner<std::uint32_t>(nrVertices, threads, [&](std::size_t c, auto&& emit) {
+				for_each_row_edge(nrVertices, offsets, nrEdges * c / threads, nrEdges * (c + 1) / threads, [&](std::size_t u, std::uint64_t e) {
+					emit(targets[e], static_cast<std::uint32_t>(u));
+				});
+			}, threads, reversed.offsets);
+			return reversed;
+		}
+	}
+
+	//CSR rows from an edge list over vertices 0..nrVertices-1, without names. every row keeps the
+	//order of its edges in the list, parallel edges included.
+	static CsrGraph make_csr_graph(std::size_t nrVertices, const std::vector<std::pair<std::uint32_t, std::uint32_t>>& edges)
+	{
+		if (nrVertices > std::numeric_limits<std::uint32_t>::max())
+			throw std::invalid_argument("CSR rows support up to 2^32 - 1 vertices.");
+		for (auto [u, v] : edges) {
+			if (u >= nrVertices || v >= nrVertices)
+				throw std::invalid_argument("CSR edge endpoint out of range.");
+		}
+		auto storage = CsrStorage{};
+		storage.targets = detail::scatter_rows_by_owner<std::uint32_t>(nrVertices, 1, [&edges](std::size_t, auto&& emit) {
+			for (auto [u, v] : edges)
+				emit(u, v);
+		}, 1, storage.offsets);
+		return CsrGraph{ std::move(storage) };
+	}
+}
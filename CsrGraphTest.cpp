@@ -0,0 +1,659 @@
+#define _SILENCE_CXX17_ITERATOR_BASE_CLASS_DEPRECATION_WARNING
+#include "ConcurrentGraphBuilder.h"
+#include "CsrGraph.h"
+#include "EdgeListLoader.h"
+#include "GraphReorder.h"
+#include "GraphSnapshot.h"
+#include "RandomEulerGraph.h"
+#include <BoostGraphX/euler_graph.h>
+#include <boost/graph/breadth_first_search.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <catch.hpp>
+#include "Make_De_Bruijn_Euler_Digraph.h"
+#include "Timer.h"
+
+namespace bglx::test {
+	static std::string temp_file(const std::string& name)
+	{
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	static void require_same_graph(const CsrGraph& csr, const Dag& dag)
+	{
+		REQUIRE(boost::num_vertices(csr) == boost::num_vertices(dag));
+		REQUIRE(boost::num_edges(csr) == boost::num_edges(dag));
+		for (auto v : boost::make_iterator_range(boost::vertices(dag))) {
+			REQUIRE(csr.vertex_name(v) == dag[v].name);
+			REQUIRE(boost::out_degree(v, csr) == boost::out_degree(v, dag));
+			auto csrE = boost::out_edges(v, csr).first;
+			for (auto e : boost::make_iterator_range(boost::out_edges(v, dag))) {
+				REQUIRE(boost::source(*csrE, csr) == v);
+				REQUIRE(boost::target(*csrE, csr) == boost::target(e, dag));
+				REQUIRE(csr.edge_name(*csrE) == dag[e].name);
+				++csrE;
+			}
+		}
+	}
+
+	static void require_euler_cycle(const CsrGraph& csr)
+	{
+		auto cycle = bglx::find_one_directed_euler_cycle_hierholzer(csr, 0);
+		REQUIRE(cycle.size() == boost::num_edges(csr));
+		auto prev_v = std::size_t{ 0 };
+		for (auto e : cycle) {
+			REQUIRE(boost::source(e, csr) == prev_v);
+			prev_v = boost::target(e, csr);
+		}
+		REQUIRE(prev_v == 0);
+	}
+
+	TEST_CASE("Csr graph")
+	{
+		SECTION("Csr graph from Dag")
+		{
+			auto dag = make_De_Bruigin_graph(5);
+			auto csr = make_csr_graph(dag);
+			require_same_graph(csr, dag);
+			auto nrEdges = std::size_t{ 0 };
+			for (auto e : boost::make_iterator_range(boost::edges(csr))) {
+				REQUIRE(get(get(boost::edge_index, csr), e) == nrEdges);
+				REQUIRE(boost::edge(boost::source(e, csr), boost::target(e, csr), dag).second);
+				++nrEdges;
+			}
+			REQUIRE(nrEdges == boost::num_edges(dag));
+			require_euler_cycle(csr);
+		}
+
+		SECTION("Csr graph from edge pairs")
+		{
+			auto csr = make_csr_graph(4, { { 2, 0 }, { 0, 3 }, { 2, 1 }, { 0, 1 } });
+			REQUIRE(boost::num_edges(csr) == 4);
+			REQUIRE(boost::out_degree(0, csr) == 2);
+			REQUIRE(boost::out_degree(1, csr) == 0);
+			REQUIRE(boost::target(*boost::out_edges(0, csr).first, csr) == 3);
+			REQUIRE(boost::target(*boost::out_edges(2, csr).first, csr) == 0);
+			//ids beyond 32 bits are rejected before anything is allocated, as for Dags that large
+			REQUIRE_THROWS_AS(make_csr_graph(std::size_t{ 1 } << 32, {}), std::invalid_argument);
+			REQUIRE_THROWS_AS(make_csr_graph(4, { { 0, 4 } }), std::invalid_argument);
+		}
+
+		SECTION("Rows by owner")
+		{
+			//value c * 1000 + i is the i-th edge of chunk c, rows keep chunk order and then emit order
+			auto rng = std::mt19937_64{ 5 };
+			std::vector<std::vector<std::pair<std::uint32_t, std::uint32_t>>> chunks(5);
+			for (std::uint32_t c = 0; c < chunks.size(); ++c) {
+				for (std::uint32_t i = 0; i < 200 * c; ++i)
+					chunks[c].emplace_back(static_cast<std::uint32_t>(rng() % 37), c * 1000 + i);
+			}
+			std::vector<std::vector<std::uint32_t>> expected(37);
+			for (auto& chunk : chunks) {
+				for (auto [row, value] : chunk)
+					expected[row].push_back(value);
+			}
+			for (unsigned nrThreads : { 1u, 3u, 8u, 64u }) {
+				std::vector<std::uint64_t> offsets;
+				auto rows = detail::scatter_rows_by_owner<std::uint32_t>(expected.size(), chunks.size(), [&](std::size_t c, auto&& emit) {
+					for (auto [row, value] : chunks[c])
+						emit(row, value);
+				}, nrThreads, offsets);
+				REQUIRE(offsets.size() == expected.size() + 1);
+				for (std::size_t row = 0; row < expected.size(); ++row)
+					REQUIRE(std::vector<std::uint32_t>(rows.begin() + offsets[row], rows.begin() + offsets[row + 1]) == expected[row]);
+			}
+
+			auto csr = make_random_euler_csr({ 5000, 200000 });
+			auto& a = csr.arrays();
+			auto reversed = detail::reverse_rows(a.nrVertices, a.offsets, a.targets, 1);
+			REQUIRE(reversed.targets.size() == a.nrEdges);
+			REQUIRE(detail::reverse_rows(a.nrVertices, a.offsets, a.targets, 5).targets == reversed.targets);
+			auto dag = make_dag(csr);
+			for (std::uint32_t v = 0; v < a.nrVertices; ++v) {
+				REQUIRE(std::is_sorted(reversed.targets.begin() + reversed.offsets[v], reversed.targets.begin() + reversed.offsets[v + 1]));
+				for (auto e = reversed.offsets[v]; e < reversed.offsets[v + 1]; ++e)
+					REQUIRE(boost::edge(reversed.targets[e], v, dag).second);
+			}
+		}
+
+		SECTION("Snapshot round trip")
+		{
+			auto dag = make_De_Bruigin_graph(6);
+			auto path = temp_file("bglx_roundtrip.snapshot");
+			write_snapshot(dag, path);
+			{
+				auto csr = load_snapshot(path);
+				auto& a = csr.arrays();
+				REQUIRE(reinterpret_cast<std::uintptr_t>(a.offsets) % SnapshotAlignment == 0);
+				REQUIRE(reinterpret_cast<std::uintptr_t>(a.targets) % SnapshotAlignment == 0);
+				require_same_graph(csr, dag);
+				require_euler_cycle(csr);
+			}
+			std::filesystem::remove(path);
+		}
+
+		SECTION("Snapshot without names")
+		{
+			auto storage = CsrStorage{};
+			storage.offsets = { 0, 1, 2, 2 };
+			storage.targets = { 1, 0 };
+			auto path = temp_file("bglx_unnamed.snapshot");
+			write_snapshot(CsrGraph{ storage }, path);
+			{
+				auto csr = load_snapshot(path);
+				REQUIRE(!csr.has_vertex_names());
+				REQUIRE(!csr.has_edge_names());
+				REQUIRE(boost::num_vertices(csr) == 3);
+				REQUIRE(boost::out_degree(2, csr) == 0);
+				REQUIRE(boost::target(*boost::out_edges(1, csr).first, csr) == 0);
+			}
+			std::filesystem::remove(path);
+		}
+
+		SECTION("Snapshot rejects other files")
+		{
+			auto path = temp_file("bglx_garbage.snapshot");
+			{
+				auto out = std::ofstream(path, std::ios::binary);
+				out << std::string(256, 'x');
+			}
+			REQUIRE_THROWS(load_snapshot(path));
+			write_snapshot(make_De_Bruigin_graph(2), path);
+			std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+			REQUIRE_THROWS(load_snapshot(path));
+			std::filesystem::remove(path);
+		}
+
+		SECTION("Snapshot rejects corrupt rows")
+		{
+			auto path = temp_file("bglx_corrupt.snapshot");
+			auto patch = [&path](std::uint64_t at, auto value) {
+				auto file = std::fstream(path, std::ios::binary | std::ios::in | std::ios::out);
+				file.seekp(static_cast<std::streamoff>(at));
+				file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+			};
+			auto rewrite = [&] {
+				write_snapshot(make_De_Bruigin_graph(4), path);
+				return load_snapshot(path).arrays();
+			};
+			auto a = rewrite();
+			auto offsetsAt = [&] {
+				SnapshotHeader header;
+				std::ifstream(path, std::ios::binary).read(reinterpret_cast<char*>(&header), sizeof(header));
+				return header.sections[SnapshotOffsets].offset;
+			}();
+			auto targetsAt = offsetsAt + detail::align_up((a.nrVertices + 1) * sizeof(std::uint64_t));
+
+			//(n + 1) * 8 wraps around to the real offsets section size
+			patch(offsetof(SnapshotHeader, nrVertices), std::uint64_t{ a.nrVertices } + (std::uint64_t{ 1 } << 61));
+			REQUIRE_THROWS_AS(load_snapshot(path, SnapshotValidation::Trusted), std::runtime_error);
+			rewrite();
+			patch(offsetof(SnapshotHeader, nrEdges), std::uint64_t{ a.nrEdges } + (std::uint64_t{ 1 } << 62));
+			REQUIRE_THROWS_AS(load_snapshot(path, SnapshotValidation::Trusted), std::runtime_error);
+
+			//rows that keep the first and last offset only fail the full check
+			rewrite();
+			patch(targetsAt + 5 * sizeof(std::uint32_t), static_cast<std::uint32_t>(a.nrVertices));
+			REQUIRE_THROWS_AS(load_snapshot(path), std::runtime_error);
+			REQUIRE(load_snapshot(path, SnapshotValidation::Trusted).nr_edges() == a.nrEdges);
+			rewrite();
+			patch(offsetsAt + 3 * sizeof(std::uint64_t), a.nrEdges + 1);
+			REQUIRE_THROWS_AS(load_snapshot(path), std::runtime_error);
+			REQUIRE(load_snapshot(path, SnapshotValidation::Trusted).nr_vertices() == a.nrVertices);
+			std::filesystem::remove(path);
+		}
+	}
+
+	static void write_text_file(const std::string& path, const std::string& text)
+	{
+		auto out = std::ofstream(path, std::ios::binary | std::ios::trunc);
+		out << text;
+	}
+
+	static void require_same_csr(const CsrGraph& a, const CsrGraph& b)
+	{
+		REQUIRE(boost::num_vertices(a) == boost::num_vertices(b));
+		REQUIRE(boost::num_edges(a) == boost::num_edges(b));
+		REQUIRE(a.has_edge_names() == b.has_edge_names());
+		for (auto e : boost::make_iterator_range(boost::edges(a))) {
+			auto other = CsrEdge{ e.source, e.index };
+			REQUIRE(boost::source(e, a) == boost::source(other, b));
+			REQUIRE(boost::target(e, a) == boost::target(other, b));
+			if (a.has_edge_names())
+				REQUIRE(a.edge_name(e) == b.edge_name(other));
+		}
+	}
+
+	TEST_CASE("Edge list loader")
+	{
+		SECTION("Edge list with comments, names and parallel edges")
+		{
+			auto path = temp_file("bglx_edges.txt");
+			write_text_file(path,
+				"# a comment\n"
+				"2 0 two-zero\r\n"
+				"0 1\n"
+				"\n"
+				"  0\t2   zero two  \n"
+				"0 1 again\n"
+				"123456789 0 far\n"
+				"1 123456789");
+			auto csr = load_edge_list_csr(path);
+			REQUIRE(boost::num_vertices(csr) == 123456790);
+			REQUIRE(boost::num_edges(csr) == 6);
+			REQUIRE(csr.has_edge_names());
+			auto row0 = boost::out_edges(0, csr).first;
+			REQUIRE(boost::target(row0[0], csr) == 1);
+			REQUIRE(csr.edge_name(row0[0]) == "");
+			REQUIRE(boost::target(row0[1], csr) == 1);
+			REQUIRE(csr.edge_name(row0[1]) == "again");
+			REQUIRE(boost::target(row0[2], csr) == 2);
+			REQUIRE(csr.edge_name(row0[2]) == "zero two");
+			REQUIRE(boost::target(*boost::out_edges(1, csr).first, csr) == 123456789);
+			REQUIRE(csr.edge_name(*boost::out_edges(2, csr).first) == "two-zero");
+			REQUIRE(csr.edge_name(*boost::out_edges(123456789, csr).first) == "far");
+
+			auto options = EdgeListLoadOptions{};
+			options.removeParallelEdges = true;
+			options.keepNames = false;
+			auto unique = load_edge_list_csr(path, options);
+			REQUIRE(boost::num_edges(unique) == 5);
+			REQUIRE(boost::out_degree(0, unique) == 2);
+			REQUIRE(!unique.has_edge_names());
+			std::filesystem::remove(path);
+		}
+
+		SECTION("Edge list matches the written edges for any thread count")
+		{
+			auto rng = std::mt19937{ 3 };
+			auto digits = std::uniform_int_distribution<int>{ 1, 10 };
+			auto text = std::string{};
+			auto expected = std::vector<std::pair<std::uint32_t, std::uint32_t>>{};
+			for (int i = 0; i < 20000; ++i) {
+				auto id = [&] {
+					auto limit = std::uint64_t{ 1 };
+					for (int d = digits(rng); d > 1; --d)
+						limit *= 10;
+					return static_cast<std::uint32_t>(std::min<std::uint64_t>(rng() % (limit * 9) + 1, 5000000));
+				};
+				auto u = id();
+				auto v = id();
+				expected.emplace_back(u, v);
+				text += std::to_string(u) + (i % 3 ? " " : "\t ") + std::to_string(v);
+				text += i % 5 ? "\n" : " e" + std::to_string(i) + "\n";
+			}
+			auto path = temp_file("bglx_random_edges.txt");
+			write_text_file(path, text);
+
+			auto options = EdgeListLoadOptions{};
+			options.nrThreads = 1;
+			auto reference = load_edge_list_csr(path, options);
+			REQUIRE(boost::num_edges(reference) == expected.size());
+			std::sort(expected.begin(), expected.end());
+			auto loaded = std::vector<std::pair<std::uint32_t, std::uint32_t>>{};
+			for (auto e : boost::make_iterator_range(boost::edges(reference)))
+				loaded.emplace_back(boost::source(e, reference), boost::target(e, reference));
+			REQUIRE(loaded == expected);
+
+			for (unsigned nrThreads : { 2u, 3u, 8u }) {
+				options.nrThreads = nrThreads;
+				require_same_csr(load_edge_list_csr(path, options), reference);
+			}
+			std::filesystem::remove(path);
+		}
+
+		SECTION("Edge list into Dag")
+		{
+			auto path = temp_file("bglx_dag_edges.txt");
+			write_text_file(path, "0 1 a\n1 2 b\n2 0 c\n0 1 dup\n");
+			auto dag = load_edge_list_dag(path);
+			REQUIRE(boost::num_vertices(dag) == 3);
+			REQUIRE(boost::num_edges(dag) == 3);
+			REQUIRE(dag[1].name == "1");
+			auto [e, found] = boost::edge(0, 1, dag);
+			REQUIRE(found);
+			REQUIRE(dag[e].name == "a");
+			std::filesystem::remove(path);
+		}
+
+		SECTION("Malformed edge lists are rejected")
+		{
+			auto path = temp_file("bglx_bad_edges.txt");
+			for (auto text : { "0 1\nx 2\n", "0\n", "0 1x\n", "0 99999999999\n", "-1 2\n" }) {
+				write_text_file(path, text);
+				REQUIRE_THROWS(load_edge_list_csr(path));
+			}
+			std::filesystem::remove(path);
+		}
+	}
+
+	TEST_CASE("Concurrent graph builder")
+	{
+		constexpr unsigned nrProducers = 4;
+		constexpr std::uint32_t nrVertices = 5000;
+		//every producer adds its own random edges, many of them parallel to those of other producers
+		auto fill = [](ConcurrentGraphBuilder& builder, std::size_t nrEdges) {
+			parallel_chunks(builder.nr_producers(), builder.nr_producers(), [&](unsigned p, std::size_t, std::size_t) {
+				auto rng = std::mt19937{ p };
+				auto pick = std::uniform_int_distribution<std::uint32_t>{ 0, nrVertices - 1 };
+				auto& producer = builder.producer(p);
+				producer.reserve(nrEdges);
+				for (std::size_t i = 0; i < nrEdges; ++i) {
+					auto u = pick(rng);
+					auto v = pick(rng) % 64;
+					producer.add_edge(u, v, std::to_string(p) + ":" + std::to_string(i));
+				}
+			});
+		};
+
+		SECTION("Same Dag as adding the edges one by one")
+		{
+			auto builder = ConcurrentGraphBuilder{ nrProducers };
+			fill(builder, 20000);
+			//the one by one order that finish_dag follows: producer by producer
+			auto expected = Dag{ nrVertices };
+			for (unsigned p = 0; p < nrProducers; ++p) {
+				auto rng = std::mt19937{ p };
+				auto pick = std::uniform_int_distribution<std::uint32_t>{ 0, nrVertices - 1 };
+				for (std::size_t i = 0; i < 20000; ++i) {
+					auto u = pick(rng);
+					auto v = pick(rng) % 64;
+					boost::add_edge(u, v, EdgeProperty{ std::to_string(p) + ":" + std::to_string(i) }, expected);
+				}
+			}
+			for (auto v : boost::make_iterator_range(boost::vertices(expected)))
+				expected[v].name = std::to_string(v);
+			auto dag = builder.finish_dag();
+			REQUIRE(boost::num_edges(dag) < nrProducers * 20000);
+			require_same_graph(make_csr_graph(dag), expected);
+		}
+
+		SECTION("Parallel edges in producer order")
+		{
+			auto builder = ConcurrentGraphBuilder{ 2 };
+			builder.producer(1).add_edge(0, 1, "late");
+			builder.producer(0).add_edge(0, 2);
+			builder.producer(0).add_edge(0, 1, "early");
+			builder.producer(1).add_edge(0, 1, "later");
+			auto options = ConcurrentBuildOptions{};
+			options.nrVertices = 10;
+			auto csr = builder.finish_csr(options);
+			REQUIRE(boost::num_vertices(csr) == 10);
+			REQUIRE(boost::num_edges(csr) == 4);
+			auto e = boost::out_edges(0, csr).first;
+			for (auto name : { "early", "late", "later", "" }) {
+				REQUIRE(csr.edge_name(*e) == name);
+				++e;
+			}
+			options.removeParallelEdges = true;
+			auto unique = builder.finish_csr(options);
+			REQUIRE(boost::num_edges(unique) == 2);
+			REQUIRE(unique.edge_name(*boost::out_edges(0, unique).first) == "early");
+			REQUIRE(builder.finish_dag()[*boost::edges(builder.finish_dag()).first].name == "early");
+		}
+
+		SECTION("Same rows on any number of threads")
+		{
+			auto builder = ConcurrentGraphBuilder{ nrProducers };
+			fill(builder, 50000);
+			auto options = ConcurrentBuildOptions{};
+			options.nrThreads = 1;
+			auto reference = builder.finish_csr(options);
+			REQUIRE(boost::num_edges(reference) == nrProducers * 50000);
+			for (unsigned nrThreads : { 3u, 8u }) {
+				options.nrThreads = nrThreads;
+				auto csr = builder.finish_csr(options);
+				auto& a = csr.arrays();
+				auto& r = reference.arrays();
+				REQUIRE(std::equal(a.offsets, a.offsets + a.nrVertices + 1, r.offsets));
+				REQUIRE(std::equal(a.targets, a.targets + a.nrEdges, r.targets));
+				REQUIRE(std::equal(a.edgeNameOffsets, a.edgeNameOffsets + a.nrEdges + 1, r.edgeNameOffsets));
+			}
+		}
+
+		SECTION("Producers on their own cache lines")
+		{
+			auto builder = ConcurrentGraphBuilder{ 3 };
+			auto first = reinterpret_cast<std::uintptr_t>(&builder.producer(0));
+			auto second = reinterpret_cast<std::uintptr_t>(&builder.producer(1));
+			REQUIRE(first % CacheLineSize == 0);
+			REQUIRE(second - first >= CacheLineSize);
+			REQUIRE(builder.finish_csr().nr_vertices() == 0);
+		}
+	}
+
+	//g with its vertices in random order, the way ids come out of a file
+	static ReorderedCsr shuffled(const CsrGraph& g, unsigned seed)
+	{
+		std::vector<std::uint32_t> order(g.nr_vertices());
+		std::iota(order.begin(), order.end(), 0);
+		std::shuffle(order.begin(), order.end(), std::mt19937{ seed });
+		return permute_csr(g, std::move(order));
+	}
+
+	//largest difference between the ids at both ends of an edge
+	static std::size_t bandwidth(const CsrGraph& g)
+	{
+		auto result = std::size_t{ 0 };
+		for (auto e : boost::make_iterator_range(boost::edges(g))) {
+			auto u = boost::source(e, g);
+			auto v = boost::target(e, g);
+			result = std::max(result, u < v ? v - u : u - v);
+		}
+		return result;
+	}
+
+	TEST_CASE("Graph reordering")
+	{
+		const auto orders = { VertexOrder::Bfs, VertexOrder::ReverseCuthillMcKee, VertexOrder::DegreeDescending };
+
+		SECTION("Every order keeps the edges, their order and the names")
+		{
+			auto csr = make_csr_graph(make_De_Bruigin_graph(8));
+			for (auto order : orders) {
+				auto reordered = reorder_csr(csr, order, 3);
+				auto& g = reordered.graph;
+				REQUIRE(boost::num_vertices(g) == boost::num_vertices(csr));
+				REQUIRE(boost::num_edges(g) == boost::num_edges(csr));
+				for (std::uint32_t i = 0; i < g.nr_vertices(); ++i) {
+					auto old = reordered.oldId[i];
+					REQUIRE(reordered.newId[old] == i);
+					REQUIRE(g.vertex_name(i) == csr.vertex_name(old));
+					REQUIRE(boost::out_degree(i, g) == boost::out_degree(old, csr));
+					auto oldE = boost::out_edges(old, csr).first;
+					for (auto e : boost::make_iterator_range(boost::out_edges(i, g))) {
+						REQUIRE(boost::target(e, g) == reordered.newId[boost::target(*oldE, csr)]);
+						REQUIRE(g.edge_name(e) == csr.edge_name(*oldE));
+						++oldE;
+					}
+				}
+				require_euler_cycle(g);
+			}
+		}
+
+		SECTION("Breadth-first order")
+		{
+			//0 -> 2 -> 1, 0 -> 3, 4 -> 3
+			auto builder = ConcurrentGraphBuilder{ 1 };
+			for (auto [u, v] : { std::pair{ 0u, 2u }, { 0u, 3u }, { 2u, 1u }, { 4u, 3u } })
+				builder.producer(0).add_edge(u, v);
+			auto csr = builder.finish_csr();
+			REQUIRE(vertex_order(csr, VertexOrder::Bfs) == std::vector<std::uint32_t>{ 0, 2, 3, 1, 4 });
+			//1 and 4 have the lowest degree, then 2 before 0 and 3 (reversed at the end)
+			REQUIRE(vertex_order(csr, VertexOrder::ReverseCuthillMcKee) == std::vector<std::uint32_t>{ 4, 3, 0, 2, 1 });
+			REQUIRE(vertex_order(csr, VertexOrder::DegreeDescending) == std::vector<std::uint32_t>{ 0, 2, 3, 1, 4 });
+		}
+
+		SECTION("Reverse Cuthill-McKee shrinks the bandwidth of a shuffled grid")
+		{
+			//200 x 200 grid, edges to the right and down
+			constexpr std::uint32_t side = 200;
+			auto builder = ConcurrentGraphBuilder{ 1 };
+			for (std::uint32_t v = 0; v < side * side; ++v) {
+				if (v % side + 1 < side)
+					builder.producer(0).add_edge(v, v + 1);
+				if (v + side < side * side)
+					builder.producer(0).add_edge(v, v + side);
+			}
+			auto grid = shuffled(builder.finish_csr(), 1);
+			REQUIRE(bandwidth(grid.graph) > side * side / 2);
+			auto rcm = reorder_csr(grid.graph, VertexOrder::ReverseCuthillMcKee);
+			REQUIRE(bandwidth(rcm.graph) <= 2 * side);
+		}
+
+		SECTION("Degree order puts hubs first")
+		{
+			auto options = RandomEulerOptions{};
+			options.distribution = DegreeDistribution::PowerLaw;
+			options.nrVertices = 5000;
+			options.nrEdges = 40000;
+			auto reordered = reorder_csr(make_random_euler_csr(options), VertexOrder::DegreeDescending);
+			auto& g = reordered.graph;
+			//Euler graphs have in-degree = out-degree
+			for (std::size_t v = 1; v < g.nr_vertices(); ++v)
+				REQUIRE(boost::out_degree(v - 1, g) >= boost::out_degree(v, g));
+		}
+
+		SECTION("Orders that are no permutation")
+		{
+			auto csr = make_csr_graph(make_De_Bruigin_graph(3));
+			std::vector<std::uint32_t> order(csr.nr_vertices(), 0);
+			REQUIRE_THROWS_AS(permute_csr(csr, order), std::invalid_argument);
+			order.pop_back();
+			REQUIRE_THROWS_AS(permute_csr(csr, order), std::invalid_argument);
+		}
+	}
+
+	//run explicitly with: BGLTest "[benchmark]"
+	TEST_CASE("Edge list loader throughput", "[.][benchmark]")
+	{
+		auto path = temp_file("bglx_bench_edges.txt");
+		{
+			auto rng = std::mt19937{ 5 };
+			//average out-degree 8
+			auto pick = std::uniform_int_distribution<std::uint32_t>{ 0, 2500000 };
+			auto out = std::ofstream(path, std::ios::binary | std::ios::trunc);
+			auto line = std::string{};
+			for (int i = 0; i < 20000000; ++i) {
+				line = std::to_string(pick(rng));
+				line += ' ';
+				line += std::to_string(pick(rng));
+				line += '\n';
+				out << line;
+			}
+		}
+		auto bytes = std::filesystem::file_size(path);
+		auto beg = std::chrono::steady_clock::now();
+		auto csr = load_edge_list_csr(path);
+		auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - beg).count();
+		std::cout << "Edge list loader: " << bytes / 1e6 << " MB, " << boost::num_edges(csr) << " edges in "
+			<< seconds * 1000 << " ms, " << bytes / 1e9 / seconds << " GB/s on "
+			<< default_thread_count() << " threads\n" << std::endl;
+		std::filesystem::remove(path);
+	}
+
+	//run explicitly with: BGLTest "[benchmark]"
+	TEST_CASE("Concurrent graph builder vs mutex and add_edge", "[.][benchmark]")
+	{
+		constexpr std::size_t nrEdges = 1 << 24;
+		constexpr std::uint32_t nrVertices = 1 << 21;
+		auto nrThreads = default_thread_count();
+		auto forEdges = [&](unsigned t, std::size_t begin, std::size_t end, auto&& add) {
+			auto rng = std::mt19937{ t };
+			auto pick = std::uniform_int_distribution<std::uint32_t>{ 0, nrVertices - 1 };
+			for (auto i = begin; i < end; ++i) {
+				auto u = pick(rng);
+				add(u, pick(rng));
+			}
+		};
+		for (auto threads : { 1u, nrThreads }) {
+			auto suffix = ", threads " + std::to_string(threads);
+			auto builder = ConcurrentGraphBuilder{ threads };
+			{
+				AutoProfiler timer{ "ConcurrentGraphBuilder add_edge" + suffix, ProfileWallTime, nrEdges };
+				parallel_chunks(nrEdges, threads, [&](unsigned t, std::size_t begin, std::size_t end) {
+					auto& producer = builder.producer(t);
+					forEdges(t, begin, end, [&](std::uint32_t u, std::uint32_t v) { producer.add_edge(u, v); });
+				});
+			}
+			auto options = ConcurrentBuildOptions{};
+			options.nrThreads = threads;
+			options.removeParallelEdges = true;
+			{
+				AutoProfiler timer{ "ConcurrentGraphBuilder finish_csr" + suffix, ProfileWallTime, nrEdges };
+				REQUIRE(builder.finish_csr(options).nr_vertices() == nrVertices);
+			}
+			{
+				AutoProfiler timer{ "ConcurrentGraphBuilder finish_dag" + suffix, ProfileWallTime, nrEdges };
+				REQUIRE(boost::num_vertices(builder.finish_dag(options)) == nrVertices);
+			}
+			auto dag = Dag{ nrVertices };
+			auto lock = std::mutex{};
+			AutoProfiler timer{ "mutex and boost::add_edge" + suffix, ProfileWallTime, nrEdges };
+			parallel_chunks(nrEdges, threads, [&](unsigned t, std::size_t begin, std::size_t end) {
+				forEdges(t, begin, end, [&](std::uint32_t u, std::uint32_t v) {
+					auto guard = std::lock_guard{ lock };
+					boost::add_edge(u, v, dag);
+				});
+			});
+		}
+	}
+
+	//run explicitly with: BGLTest "[benchmark]"
+	TEST_CASE("Graph reordering for Euler walks and BFS", "[.][benchmark]")
+	{
+		auto deBruijn = make_csr_graph(make_De_Bruigin_graph(21));
+		auto fileOrder = shuffled(deBruijn, 7).graph;
+		auto walk = [](const CsrGraph& g, const std::string& name) {
+			{
+				AutoProfiler timer{ name + " breadth_first_search", ProfileWallTime, g.nr_edges() };
+				boost::breadth_first_search(g, 0, boost::visitor(boost::default_bfs_visitor{}));
+			}
+			AutoProfiler timer{ name + " Euler cycle", ProfileWallTime, g.nr_edges() };
+			REQUIRE(bglx::find_one_directed_euler_cycle_hierholzer(g, 0).size() == g.nr_edges());
+		};
+		walk(deBruijn, "De Bruigin build order");
+		walk(fileOrder, "shuffled");
+		for (auto [order, name] : { std::pair{ VertexOrder::Bfs, "BFS" }, { VertexOrder::ReverseCuthillMcKee, "RCM" },
+			{ VertexOrder::DegreeDescending, "degree" } }) {
+			auto reordered = std::optional<ReorderedCsr>{};
+			{
+				AutoProfiler timer{ std::string{ name } + " reorder", ProfileWallTime, fileOrder.nr_edges() };
+				reordered = reorder_csr(fileOrder, order);
+			}
+			walk(reordered->graph, name);
+		}
+	}
+
+	//run explicitly with: BGLTest "[benchmark]"
+	TEST_CASE("Snapshot load vs De Bruigin rebuild", "[.][benchmark]")
+	{
+		constexpr int order = 20;
+		auto path = temp_file("bglx_bench.snapshot");
+		{
+			auto dag = std::optional<Dag>{};
+			{
+				AutoProfiler timer{ "Dag De Bruigin rebuild takes time: " };
+				dag = make_De_Bruigin_graph(order);
+			}
+			AutoProfiler timer{ "Snapshot write takes time: " };
+			write_snapshot(*dag, path);
+		}
+		{
+			AutoProfiler timer{ "Snapshot map and out-edge scan takes time: " };
+			auto csr = load_snapshot(path);
+			auto sum = std::size_t{ 0 };
+			for (auto v : boost::make_iterator_range(boost::vertices(csr))) {
+				for (auto e : boost::make_iterator_range(boost::out_edges(v, csr)))
+					sum += boost::target(e, csr);
+			}
+			REQUIRE(sum > 0);
+		}
+		std::filesystem::remove(path);
+	}
+}
@@ -0,0 +1,632 @@
+#define _SILENCE_CXX17_ITERATOR_BASE_CLASS_DEPRECATION_WARNING
+#include "NamedDag.h"
+#include "CsrGraph.h"
+#include "TopologicalSort.h"
+#include "DynamicDag.h"
+#include "ReachabilityIndex.h"
+#include "TransitiveClosure.h"
+#include "CriticalPath.h"
+#include "Timer.h"
+#include <boost/graph/topological_sort.hpp>
+#include <boost/graph/transitive_closure.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <set>
+#include <catch.hpp>
+
+namespace bglx::test {
+	//edges u -> v with u < v in a shuffled numbering, so the vertex ids say nothing about the order
+	static std::vector<std::pair<std::uint32_t, std::uint32_t>> random_dag_edges(
+		std::size_t nrVertices, std::size_t nrEdges, std::uint64_t seed)
+	{
+		auto rng = std::mt19937_64{ seed };
+		std::vector<std::uint32_t> label(nrVertices);
+		std::iota(label.begin(), label.end(), 0);
+		std::shuffle(label.begin(), label.end(), rng);
+		auto pick = std::uniform_int_distribution<std::size_t>{ 0, nrVertices - 1 };
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> edges;
+		edges.reserve(nrEdges);
+		while (edges.size() < nrEdges) {
+			auto u = pick(rng);
+			auto v = pick(rng);
+			if (u != v)
+				edges.emplace_back(label[std::min(u, v)], label[std::max(u, v)]);
+		}
+		return edges;
+	}
+
+	static Dag make_dag_from_edges(std::size_t nrVertices, const std::vector<std::pair<std::uint32_t, std::uint32_t>>& edges)
+	{
+		auto dag = Dag{ nrVertices };
+		for (auto [u, v] : edges)
+			boost::add_edge(u, v, dag);
+		return dag;
+	}
+
+	//every edge goes up at least one level and every vertex above level 0 has an in-edge from the level below
+	template <class Graph>
+	static void require_levels(const Graph& g, const TopologicalLevels& levels)
+	{
+		REQUIRE(levels.is_acyclic());
+		std::vector<std::size_t> position(boost::num_vertices(g));
+		for (std::size_t i = 0; i < levels.order.size(); ++i)
+			position[levels.order[i]] = i;
+		std::vector<char> supported(boost::num_vertices(g), 0);
+		for (auto e : boost::make_iterator_range(boost::edges(g))) {
+			auto u = boost::source(e, g);
+			auto v = boost::target(e, g);
+			REQUIRE(position[u] < position[v]);
+			REQUIRE(levels.level[u] < levels.level[v]);
+			if (levels.level[u] + 1 == levels.level[v])
+				supported[v] = 1;
+		}
+		for (std::size_t l = 0; l < levels.nr_levels(); ++l) {
+			for (auto i = levels.levelOffsets[l]; i < levels.levelOffsets[l + 1]; ++i) {
+				REQUIRE(levels.level[levels.order[i]] == l);
+				REQUIRE((l == 0) != (supported[levels.order[i]] != 0));
+			}
+		}
+	}
+
+	TEST_CASE("Topological levels")
+	{
+		SECTION("Levels are longest path lengths")
+		{
+			//0 -> 1 -> 3, 0 -> 2 -> 3 -> 4, 0 -> 4, 5 alone
+			auto dag = make_dag_from_edges(6, { { 0, 1 }, { 1, 3 }, { 0, 2 }, { 2, 3 }, { 3, 4 }, { 0, 4 } });
+			auto levels = topological_levels(dag);
+			REQUIRE(levels.level == std::vector<std::uint32_t>{ 0, 1, 1, 2, 3, 0 });
+			REQUIRE(levels.order == std::vector<std::uint32_t>{ 0, 5, 1, 2, 3, 4 });
+			REQUIRE(levels.levelOffsets == std::vector<std::size_t>{ 0, 2, 4, 5, 6 });
+			REQUIRE(topological_levels(Dag{}).order.empty());
+		}
+
+		SECTION("Random Dags on any number of threads")
+		{
+			auto edges = random_dag_edges(100000, 400000, 3);
+			auto dag = make_dag_from_edges(100000, edges);
+			auto levels = topological_levels(dag, 1);
+			require_levels(dag, levels);
+			auto csr = make_csr_graph(100000, edges);
+			auto parallelLevels = topological_levels(csr, 4);
+			require_levels(csr, parallelLevels);
+			REQUIRE(parallelLevels.level == levels.level);
+		}
+
+		SECTION("Cycles and what they reach are left out")
+		{
+			//3 -> 0 -> 1 -> 2 -> 0, 2 -> 5, 4 alone
+			auto dag = make_dag_from_edges(6, { { 3, 0 }, { 0, 1 }, { 1, 2 }, { 2, 0 }, { 2, 5 } });
+			auto levels = topological_levels(dag);
+			REQUIRE(!levels.is_acyclic());
+			REQUIRE(levels.order == std::vector<std::uint32_t>{ 3, 4 });
+			REQUIRE(levels.level[5] == TopologicalLevels::NoLevel);
+		}
+
+		SECTION("Million-deep chain")
+		{
+			//v -> v - 1, so the order is the reverse of the numbering
+			constexpr std::size_t nrVertices = 1 << 20;
+			std::vector<std::pair<std::uint32_t, std::uint32_t>> edges;
+			for (std::uint32_t v = 1; v < nrVertices; ++v)
+				edges.emplace_back(v, v - 1);
+			auto levels = topological_levels(make_csr_graph(nrVertices, edges), 4);
+			REQUIRE(levels.nr_levels() == nrVertices);
+			REQUIRE(levels.order.front() == nrVertices - 1);
+			REQUIRE(levels.level[0] == nrVertices - 1);
+		}
+	}
+
+	//run explicitly with: BGLTest "[benchmark]"
+	TEST_CASE("Topological levels vs boost::topological_sort", "[.][benchmark]")
+	{
+		constexpr std::size_t nrVertices = 2000000;
+		auto edges = random_dag_edges(nrVertices, 10 * nrVertices, 1);
+		auto csr = make_csr_graph(nrVertices, edges);
+		auto dag = make_dag_from_edges(nrVertices, edges);
+		for (unsigned nrThreads : { 1u, default_thread_count() }) {
+			AutoProfiler timer{ "topological_levels CsrGraph, threads " + std::to_string(nrThreads), ProfileWallTime, edges.size() };
+			REQUIRE(topological_levels(csr, nrThreads).is_acyclic());
+		}
+		{
+			AutoProfiler timer{ "topological_levels Dag", ProfileWallTime, edges.size() };
+			REQUIRE(topological_levels(dag).is_acyclic());
+		}
+		{
+			AutoProfiler timer{ "boost::topological_sort Dag", ProfileWallTime, edges.size() };
+			std::vector<Vertex> order;
+			order.reserve(nrVertices);
+			boost::topological_sort(dag, std::back_inserter(order));
+			REQUIRE(order.size() == nrVertices);
+		}
+	}
+
+	//the order is a permutation that every edge goes forward in
+	static void require_order(const DynamicDag& dynamic)
+	{
+		auto& g = dynamic.graph();
+		REQUIRE(dynamic.order().size() == boost::num_vertices(g));
+		for (std::size_t i = 0; i < dynamic.order().size(); ++i)
+			REQUIRE(dynamic.position(dynamic.order()[i]) == i);
+		for (auto e : boost::make_iterator_range(boost::edges(g)))
+			REQUIRE(dynamic.position(boost::source(e, g)) < dynamic.position(boost::target(e, g)));
+	}
+
+	TEST_CASE("Dynamic Dag")
+	{
+		SECTION("Cycles are rejected with a witness")
+		{
+			auto dynamic = DynamicDag{};
+			for (int i = 0; i < 4; ++i)
+				dynamic.add_vertex();
+			REQUIRE(dynamic.add_edge(2, 1).inserted);
+			REQUIRE(dynamic.add_edge(1, 0).inserted);
+			REQUIRE(dynamic.add_edge(0, 3).inserted);
+			require_order(dynamic);
+			REQUIRE(!dynamic.add_edge(2, 1).inserted);
+			REQUIRE(!dynamic.add_edge(2, 1).creates_cycle());
+
+			auto rejected = dynamic.add_edge(3, 2);
+			REQUIRE(!rejected.inserted);
+			REQUIRE(rejected.cycle == std::vector<Vertex>{ 2, 1, 0, 3 });
+			REQUIRE(dynamic.add_edge(3, 3).cycle == std::vector<Vertex>{ 3 });
+			REQUIRE(boost::num_edges(dynamic.graph()) == 3);
+
+			REQUIRE(dynamic.remove_edge(1, 0));
+			REQUIRE(!dynamic.remove_edge(1, 0));
+			REQUIRE(dynamic.add_edge(3, 2).inserted);
+			REQUIRE(dynamic.add_edge(0, 1).inserted);
+			require_order(dynamic);
+		}
+
+		SECTION("Existing graphs")
+		{
+			auto dynamic = DynamicDag{ make_dag_from_edges(3, { { 2, 0 }, { 0, 1 } }) };
+			REQUIRE(dynamic.order() == std::vector<Vertex>{ 2, 0, 1 });
+			REQUIRE(dynamic.add_edge(1, 2).cycle == std::vector<Vertex>{ 2, 0, 1 });
+			REQUIRE_THROWS_AS(DynamicDag{ make_dag_from_edges(2, { { 0, 1 }, { 1, 0 } }) }, std::invalid_argument);
+		}
+
+		SECTION("Random insertions")
+		{
+			constexpr std::size_t nrVertices = 2000;
+			auto rng = std::mt19937_64{ 7 };
+			auto pick = std::uniform_int_distribution<std::size_t>{ 0, nrVertices - 1 };
+			auto dynamic = DynamicDag{};
+			dynamic.reserve(nrVertices);
+			for (std::size_t v = 0; v < nrVertices; ++v)
+				dynamic.add_vertex();
+			auto nrRejected = 0;
+			for (int i = 0; i < 20000; ++i) {
+				auto u = pick(rng);
+				auto v = pick(rng);
+				auto insertion = dynamic.add_edge(u, v);
+				if (insertion.creates_cycle()) {
+					++nrRejected;
+					auto& cycle = insertion.cycle;
+					REQUIRE(cycle.front() == v);
+					REQUIRE(cycle.back() == u);
+					for (std::size_t j = 1; j < cycle.size(); ++j)
+						REQUIRE(boost::edge(cycle[j - 1], cycle[j], dynamic.graph()).second);
+				}
+				else {
+					REQUIRE(boost::edge(u, v, dynamic.graph()).second);
+					REQUIRE(dynamic.position(u) < dynamic.position(v));
+				}
+				if (i % 1000 == 0)
+					require_order(dynamic);
+			}
+			require_order(dynamic);
+			REQUIRE(nrRejected > 0);
+			REQUIRE(topological_levels(dynamic.graph()).is_acyclic());
+		}
+	}
+
+	//run explicitly with: BGLTest "[benchmark]"
+	TEST_CASE("Dynamic Dag insertions", "[.][benchmark]")
+	{
+		//edges of a random Dag in random order, so many of them go against the order kept so far
+		constexpr std::size_t nrVertices = 1000000;
+		for (std::size_t nrEdges : { nrVertices / 2, nrVertices, 2 * nrVertices }) {
+			auto stream = random_dag_edges(nrVertices, nrEdges, 1);
+			auto dynamic = DynamicDag{};
+			dynamic.reserve(nrVertices);
+			for (std::size_t v = 0; v < nrVertices; ++v)
+				dynamic.add_vertex();
+			{
+				AutoProfiler timer{ "DynamicDag::add_edge, edges " + std::to_string(nrEdges), ProfileWallTime, nrEdges };
+				for (auto [u, v] : stream)
+					REQUIRE(!dynamic.add_edge(u, v).creates_cycle());
+			}
+			AutoProfiler timer{ "topological_levels once, edges " + std::to_string(nrEdges), ProfileWallTime, nrEdges };
+			REQUIRE(topological_levels(dynamic.graph()).is_acyclic());
+		}
+	}
+
+	//everything reachable from u, by breadth-first search
+	template <class Graph>
+	static std::vector<char> reachable_from(const Graph& g, std::size_t u)
+	{
+		std::vector<char> seen(boost::num_vertices(g), 0);
+		std::vector<std::size_t> queue{ u };
+		seen[u] = 1;
+		for (std::size_t i = 0; i < queue.size(); ++i) {
+			for (auto e : boost::make_iterator_range(boost::out_edges(queue[i], g))) {
+				auto v = boost::target(e, g);
+				if (!seen[v]) {
+					seen[v] = 1;
+					queue.push_back(v);
+				}
+			}
+		}
+		return seen;
+	}
+
+	template <class Graph>
+	static void require_reachability(const Graph& g, const ReachabilityIndex& index)
+	{
+		auto search = ReachabilitySearch{};
+		for (std::size_t u = 0; u < boost::num_vertices(g); ++u) {
+			auto expected = reachable_from(g, u);
+			for (std::size_t v = 0; v < expected.size(); ++v) {
+				REQUIRE(index.reachable(u, v, search) == (expected[v] != 0));
+				if (expected[v])
+					REQUIRE(index.may_reach(u, v) == (u != v));
+			}
+		}
+	}
+
+	TEST_CASE("Reachability index")
+	{
+		SECTION("Exact on random Dags")
+		{
+			for (std::uint64_t seed : { 1, 2, 3 }) {
+				auto edges = random_dag_edges(400, 300 * seed, seed);
+				auto dag = make_dag_from_edges(400, edges);
+				auto options = ReachabilityOptions{};
+				options.nrLabels = static_cast<unsigned>(seed);
+				options.nrThreads = 2;
+				require_reachability(dag, make_reachability_index(dag, options));
+				auto csr = make_csr_graph(400, edges);
+				auto index = make_reachability_index(csr, options);
+				REQUIRE(index.graph().arrays().targets == csr.arrays().targets);
+				require_reachability(csr, index);
+			}
+		}
+
+		SECTION("Mapped from a file")
+		{
+			auto dag = make_dag_from_edges(300, random_dag_edges(300, 900, 4));
+			auto index = make_reachability_index(dag);
+			auto path = (std::filesystem::temp_directory_path() / "bglx_reachability.index").string();
+			write_reachability_index(index, path);
+			{
+				auto mapped = load_reachability_index(path);
+				REQUIRE(reinterpret_cast<std::uintptr_t>(mapped.arrays().intervals) % SnapshotAlignment == 0);
+				REQUIRE(mapped.memory_bytes() == index.memory_bytes());
+				require_reachability(dag, mapped);
+			}
+			write_snapshot(dag, path);
+			REQUIRE_THROWS_AS(load_reachability_index(path), std::runtime_error);
+
+			auto patch = [&](std::uint64_t at, auto value) {
+				write_reachability_index(index, path);
+				auto file = std::fstream(path, std::ios::binary | std::ios::in | std::ios::out);
+				file.seekp(static_cast<std::streamoff>(at));
+				file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+			};
+			//counts whose sizes wrap around to the real section sizes, in 32 and in 64 bits
+			patch(offsetof(ReachabilityHeader, nrLabels), static_cast<std::uint32_t>((1u << 31) + index.arrays().nrLabels));
+			REQUIRE_THROWS_AS(load_reachability_index(path, SnapshotValidation::Trusted), std::runtime_error);
+			patch(offsetof(ReachabilityHeader, nrVertices), std::uint64_t{ 300 } + (std::uint64_t{ 1 } << 61));
+			REQUIRE_THROWS_AS(load_reachability_index(path, SnapshotValidation::Trusted), std::runtime_error);
+			//a target past the last vertex
+			SnapshotSection targets;
+			std::ifstream(path, std::ios::binary).seekg(offsetof(ReachabilityHeader, sections) + ReachabilityTargets * sizeof(targets))
+				.read(reinterpret_cast<char*>(&targets), sizeof(targets));
+			patch(targets.offset + 7 * sizeof(std::uint32_t), std::uint32_t{ 300 });
+			REQUIRE_THROWS_AS(load_reachability_index(path), std::runtime_error);
+			std::filesystem::remove(path);
+		}
+
+		SECTION("Cycles and chains")
+		{
+			REQUIRE_THROWS_AS(make_reachability_index(make_dag_from_edges(3, { { 0, 1 }, { 1, 2 }, { 2, 0 } })),
+				std::invalid_argument);
+			REQUIRE(make_reachability_index(Dag{}).memory_bytes() == sizeof(std::uint64_t));
+
+			constexpr std::size_t nrVertices = 1 << 20;
+			std::vector<std::pair<std::uint32_t, std::uint32_t>> edges;
+			for (std::uint32_t v = 1; v < nrVertices; ++v)
+				edges.emplace_back(v, v - 1);
+			auto index = make_reachability_index(make_csr_graph(nrVertices, edges));
+			REQUIRE(index.reachable(nrVertices - 1, 0));
+			REQUIRE(!index.reachable(0, nrVertices - 1));
+			REQUIRE(!index.may_reach(nrVertices / 2, nrVertices / 2 + 1));
+		}
+	}
+
+	//run explicitly with: BGLTest "[benchmark]"
+	TEST_CASE("Reachability index queries", "[.][benchmark]")
+	{
+		constexpr std::size_t nrVertices = 1000000;
+		constexpr std::size_t nrQueries = 1000000;
+		auto edges = random_dag_edges(nrVertices, 4 * nrVertices, 1);
+		auto dag = make_dag_from_edges(nrVertices, edges);
+		auto index = ReachabilityIndex{};
+		for (unsigned nrThreads : { 1u, default_thread_count() }) {
+			auto options = ReachabilityOptions{};
+			options.nrThreads = nrThreads;
+			AutoProfiler timer{ "make_reachability_index Dag, threads " + std::to_string(nrThreads), ProfileWallTime, edges.size() };
+			index = make_reachability_index(dag, options);
+		}
+		std::cout << "index memory: " << index.memory_bytes() / (1024 * 1024) << " MB for "
+			<< nrVertices << " vertices, " << edges.size() << " edges" << std::endl;
+
+		auto rng = std::mt19937_64{ 2 };
+		auto pick = std::uniform_int_distribution<std::size_t>{ 0, nrVertices - 1 };
+		std::vector<std::pair<std::size_t, std::size_t>> queries(nrQueries);
+		for (auto& [u, v] : queries) {
+			u = pick(rng);
+			v = pick(rng);
+		}
+		auto nrReachable = std::size_t{ 0 };
+		auto nrSearched = std::size_t{ 0 };
+		{
+			AutoProfiler timer{ "ReachabilityIndex::reachable, random pairs", ProfileWallTime, nrQueries };
+			for (auto [u, v] : queries) {
+				nrSearched += index.may_reach(u, v);
+				nrReachable += index.reachable(u, v);
+			}
+		}
+		std::cout << nrReachable << " of " << nrQueries << " reachable, " << nrSearched << " needed a search" << std::endl;
+		{
+			constexpr std::size_t nrSearches = 100;
+			AutoProfiler timer{ "breadth-first search per query", ProfileWallTime, nrSearches };
+			for (std::size_t i = 0; i < nrSearches; ++i)
+				REQUIRE((reachable_from(dag, queries[i].first)[queries[i].second] != 0) == index.reachable(queries[i].first, queries[i].second));
+		}
+	}
+
+	TEST_CASE("Transitive closure and reduction")
+	{
+		auto small = TransitiveOptions{};
+		//one 64-bit column per block, so even small graphs are split into many blocks
+		small.maxBitsetBytes = 1;
+		small.nrThreads = 4;
+
+		SECTION("Closure is reachability")
+		{
+			for (std::uint64_t seed : { 1, 2 }) {
+				auto edges = random_dag_edges(500, 700 * seed, seed);
+				auto csr = make_csr_graph(500, edges);
+				for (auto& options : { TransitiveOptions{}, small }) {
+					auto closure = transitive_closure(csr, options);
+					for (std::size_t u = 0; u < 500; ++u) {
+						auto expected = reachable_from(csr, u);
+						expected[u] = 0;
+						std::vector<char> found(500, 0);
+						for (auto e : boost::make_iterator_range(boost::out_edges(u, closure)))
+							found[boost::target(e, closure)] = 1;
+						REQUIRE(found == expected);
+						REQUIRE(boost::out_degree(u, closure) == static_cast<std::size_t>(std::count(found.begin(), found.end(), 1)));
+					}
+				}
+			}
+		}
+
+		SECTION("Reduction keeps exactly the edges without a detour")
+		{
+			auto edges = random_dag_edges(400, 2000, 3);
+			//a parallel edge, only the first copy stays
+			edges.push_back(edges.front());
+			auto csr = make_csr_graph(400, edges);
+			auto keep = transitive_reduction_mask(csr);
+			REQUIRE(transitive_reduction_mask(csr, small) == keep);
+			std::vector<std::vector<char>> reach;
+			for (std::size_t u = 0; u < 400; ++u)
+				reach.push_back(reachable_from(csr, u));
+			std::vector<std::set<std::size_t>> kept(400);
+			for (auto e : boost::make_iterator_range(boost::edges(csr))) {
+				auto u = boost::source(e, csr);
+				auto v = boost::target(e, csr);
+				auto detour = false;
+				for (auto other : boost::make_iterator_range(boost::out_edges(u, csr)))
+					detour |= boost::target(other, csr) != v && reach[boost::target(other, csr)][v];
+				REQUIRE(keep[e.index] == (!detour && kept[u].insert(v).second));
+			}
+		}
+
+		SECTION("Dag results keep names")
+		{
+			//0 -> 1 -> 2 and the shortcut 0 -> 2
+			auto dag = make_dag_from_edges(3, { { 0, 1 }, { 1, 2 }, { 0, 2 } });
+			dag[0].name = "a";
+			dag[boost::edge(0, 1, dag).first].name = "a-b";
+			auto reduced = transitive_reduction(dag);
+			REQUIRE(boost::num_edges(reduced) == 2);
+			REQUIRE(!boost::edge(0, 2, reduced).second);
+			REQUIRE(reduced[0].name == "a");
+			REQUIRE(reduced[boost::edge(0, 1, reduced).first].name == "a-b");
+			auto closure = transitive_closure(reduced);
+			REQUIRE(boost::num_edges(closure) == 3);
+			REQUIRE(closure[boost::edge(0, 1, closure).first].name == "a-b");
+			REQUIRE(boost::num_edges(transitive_closure(Dag{})) == 0);
+			REQUIRE_THROWS_AS(transitive_reduction(make_dag_from_edges(2, { { 0, 1 }, { 1, 0 } })), std::invalid_argument);
+		}
+	}
+
+	//run explicitly with: BGLTest "[benchmark]"
+	TEST_CASE("Transitive reduction of large Dags", "[.][benchmark]")
+	{
+		{
+			constexpr std::size_t nrVertices = 5000;
+			auto dag = make_dag_from_edges(nrVertices, random_dag_edges(nrVertices, 5 * nrVertices, 2));
+			{
+				AutoProfiler timer{ "boost::transitive_closure, 5000 vertices", ProfileWallTime };
+				auto plain = boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS>{ nrVertices };
+				for (auto e : boost::make_iterator_range(boost::edges(dag)))
+					boost::add_edge(boost::source(e, dag), boost::target(e, dag), plain);
+				auto result = boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS>{};
+				boost::transitive_closure(plain, result);
+			}
+			{
+				AutoProfiler timer{ "transitive_closure CsrGraph, 5000 vertices", ProfileWallTime };
+				std::cout << transitive_closure(make_csr_graph(dag)).nr_edges() << " closure edges" << std::endl;
+			}
+			AutoProfiler timer{ "transitive_closure Dag, 5000 vertices", ProfileWallTime };
+			transitive_closure(dag);
+		}
+		constexpr std::size_t nrVertices = 100000;
+		auto edges = random_dag_edges(nrVertices, 10 * nrVertices, 1);
+		auto dag = make_dag_from_edges(nrVertices, edges);
+		for (unsigned nrThreads : { 1u, default_thread_count() }) {
+			auto options = TransitiveOptions{};
+			options.nrThreads = nrThreads;
+			AutoProfiler timer{ "transitive_reduction Dag 100000 vertices, threads " + std::to_string(nrThreads), ProfileWallTime, edges.size() };
+			auto reduced = transitive_reduction(dag, options);
+			std::cout << boost::num_edges(reduced) << " of " << boost::num_edges(dag) << " edges kept" << std::endl;
+		}
+	}
+
+	static DagWeights random_weights(const CsrGraph& g, std::uint64_t seed)
+	{
+		auto rng = std::mt19937_64{ seed };
+		auto weight = std::uniform_real_distribution<double>{ 0, 10 };
+		auto weights = DagWeights{};
+		for (std::size_t v = 0; v < g.nr_vertices(); ++v)
+			weights.vertex.push_back(weight(rng));
+		for (std::size_t e = 0; e < g.nr_edges(); ++e)
+			weights.edge.push_back(weight(rng));
+		return weights;
+	}
+
+	//sequential earliest/latest starts over boost::topological_sort, pushing along out-edges
+	static void require_schedule(const CsrGraph& g, const DagWeights& weights, const DagSchedule& schedule)
+	{
+		std::vector<std::size_t> reverseOrder;
+		boost::topological_sort(g, std::back_inserter(reverseOrder));
+		std::vector<double> earliest(g.nr_vertices(), 0);
+		for (auto it = reverseOrder.rbegin(); it != reverseOrder.rend(); ++it) {
+			for (auto e : boost::make_iterator_range(boost::out_edges(*it, g))) {
+				auto& start = earliest[boost::target(e, g)];
+				start = std::max(start, earliest[*it] + weights.vertex[*it] + weights.edge[e.index]);
+			}
+		}
+		REQUIRE(schedule.earliest == earliest);
+		auto length = 0.0;
+		for (std::size_t v = 0; v < g.nr_vertices(); ++v)
+			length = std::max(length, earliest[v] + weights.vertex[v]);
+		REQUIRE(schedule.length == length);
+
+		std::vector<double> latest(g.nr_vertices());
+		for (auto v : reverseOrder) {
+			auto finish = length;
+			for (auto e : boost::make_iterator_range(boost::out_edges(v, g)))
+				finish = std::min(finish, latest[boost::target(e, g)] - weights.edge[e.index]);
+			latest[v] = finish - weights.vertex[v];
+		}
+		REQUIRE(schedule.latest == latest);
+
+		//the path is made of edges, has no slack and adds up to the length
+		REQUIRE(!schedule.path.empty());
+		auto pathLength = schedule.earliest[schedule.path.front()];
+		REQUIRE(pathLength == 0);
+		for (std::size_t i = 0; i < schedule.path.size(); ++i) {
+			auto v = schedule.path[i];
+			REQUIRE(schedule.slack(v) == Approx(0).margin(1e-6));
+			pathLength += weights.vertex[v];
+			if (i + 1 < schedule.path.size()) {
+				auto next = schedule.path[i + 1];
+				auto [first, last] = boost::out_edges(v, g);
+				auto e = std::find_if(first, last, [&](const CsrEdge& e) { return boost::target(e, g) == next; });
+				REQUIRE(e != last);
+				pathLength += weights.edge[(*e).index];
+			}
+		}
+		REQUIRE(pathLength == Approx(length));
+	}
+
+	TEST_CASE("Longest and critical paths")
+	{
+		SECTION("Earliest and latest starts")
+		{
+			//0 -> 1 -> 3, 0 -> 2 -> 3 with a delay of 1 on 0 -> 2, and 4 alone
+			auto dag = make_dag_from_edges(5, { { 0, 1 }, { 0, 2 }, { 1, 3 }, { 2, 3 } });
+			auto weights = DagWeights{ { 2, 3, 1, 4, 1 }, { 0, 1, 0, 0 } };
+			auto schedule = dag_critical_path(dag, weights);
+			REQUIRE(schedule.length == 9);
+			REQUIRE(schedule.path == std::vector<std::uint32_t>{ 0, 1, 3 });
+			REQUIRE(schedule.earliest == std::vector<double>{ 0, 2, 3, 5, 0 });
+			REQUIRE(schedule.latest == std::vector<double>{ 0, 2, 4, 5, 8 });
+			REQUIRE(schedule.slack(2) == 1);
+
+			auto longest = dag_longest_path(dag, DagWeights{ {}, { 0, 1, 0, 0 } });
+			REQUIRE(longest.length == 1);
+			//2 -> 3 adds nothing, the path still goes on to the sink
+			REQUIRE(longest.path == std::vector<std::uint32_t>{ 0, 2, 3 });
+			REQUIRE(dag_longest_path(Dag{}, DagWeights{}).path.empty());
+			REQUIRE_THROWS_AS(dag_longest_path(dag, DagWeights{ { 1 }, {} }), std::invalid_argument);
+			REQUIRE_THROWS_AS(dag_longest_path(make_dag_from_edges(2, { { 0, 1 }, { 1, 0 } }), DagWeights{}),
+				std::invalid_argument);
+		}
+
+		SECTION("Random Dags on any number of threads")
+		{
+			auto csr = make_csr_graph(100000, random_dag_edges(100000, 500000, 5));
+			auto weights = random_weights(csr, 6);
+			auto schedule = dag_critical_path(csr, weights, 1);
+			require_schedule(csr, weights, schedule);
+			auto parallel = dag_critical_path(csr, weights, 4);
+			REQUIRE(parallel.earliest == schedule.earliest);
+			REQUIRE(parallel.latest == schedule.latest);
+			REQUIRE(parallel.path == schedule.path);
+		}
+
+		SECTION("Million-deep chain")
+		{
+			constexpr std::size_t nrVertices = 1 << 20;
+			std::vector<std::pair<std::uint32_t, std::uint32_t>> edges;
+			for (std::uint32_t v = 1; v < nrVertices; ++v)
+				edges.emplace_back(v, v - 1);
+			auto weights = DagWeights{ std::vector<double>(nrVertices, 1.0), {} };
+			auto longest = dag_longest_path(make_csr_graph(nrVertices, edges), weights);
+			REQUIRE(longest.length == nrVertices);
+			REQUIRE(longest.path.size() == nrVertices);
+			REQUIRE(longest.path.front() == nrVertices - 1);
+		}
+	}
+
+	//run explicitly with: BGLTest "[benchmark]"
+	TEST_CASE("Critical path of large Dags", "[.][benchmark]")
+	{
+		constexpr std::size_t nrVertices = 2000000;
+		auto csr = make_csr_graph(nrVertices, random_dag_edges(nrVertices, 10 * nrVertices, 1));
+		auto weights = random_weights(csr, 2);
+		for (unsigned nrThreads : { 1u, default_thread_count() }) {
+			AutoProfiler timer{ "dag_critical_path CsrGraph, threads " + std::to_string(nrThreads), ProfileWallTime, csr.nr_edges() };
+			dag_critical_path(csr, weights, nrThreads);
+		}
+		{
+			AutoProfiler timer{ "dag_longest_path CsrGraph", ProfileWallTime, csr.nr_edges() };
+			dag_longest_path(csr, weights);
+		}
+		//textbook sequential version: boost::topological_sort, then pushing along out-edges
+		AutoProfiler timer{ "boost::topological_sort and sequential relaxation", ProfileWallTime, csr.nr_edges() };
+		std::vector<std::size_t> reverseOrder;
+		reverseOrder.reserve(nrVertices);
+		boost::topological_sort(csr, std::back_inserter(reverseOrder));
+		std::vector<double> earliest(nrVertices, 0);
+		for (auto it = reverseOrder.rbegin(); it != reverseOrder.rend(); ++it) {
+			for (auto e : boost::make_iterator_range(boost::out_edges(*it, csr))) {
+				auto& start = earliest[boost::target(e, csr)];
+				start = std::max(start, earliest[*it] + weights.vertex[*it] + weights.edge[e.index]);
+			}
+		}
+	}
+}
@@ -0,0 +1,360 @@
+#define _SILENCE_CXX17_ITERATOR_BASE_CLASS_DEPRECATION_WARNING
+#include "NamedDag.h"
+#include "IndexedDag.h"
+#include <BoostGraphX/euler_graph.h>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <thread>
+#include <catch.hpp>
+#include "Make_De_Bruijn_Euler_Digraph.h"
+#include "Timer.h"
+
+namespace bglx::test {
+	TEST_CASE("Pmr Dag")
+	{
+		SECTION("Pmr Dag De Bruigin matches Dag")
+		{
+			boost::container::pmr::unsynchronized_pool_resource pool;
+			ScopedGraphResource scope{ &pool };
+			auto dag = make_De_Bruigin_graph(4);
+			auto pmrDag = make_De_Bruigin_graph<PmrDag>(4);
+			REQUIRE(boost::num_vertices(pmrDag) == boost::num_vertices(dag));
+			REQUIRE(boost::num_edges(pmrDag) == boost::num_edges(dag));
+			for (auto v : boost::make_iterator_range(boost::vertices(dag))) {
+				REQUIRE(pmrDag[v].name == dag[v].name.c_str());
+				auto [eBeg, eEnd] = boost::out_edges(v, dag);
+				auto [pmrBeg, pmrEnd] = boost::out_edges(v, pmrDag);
+				for (; eBeg != eEnd; ++eBeg, ++pmrBeg) {
+					REQUIRE(pmrBeg != pmrEnd);
+					REQUIRE(boost::target(*pmrBeg, pmrDag) == boost::target(*eBeg, dag));
+					REQUIRE(pmrDag[*pmrBeg].name == dag[*eBeg].name.c_str());
+				}
+			}
+		}
+
+		SECTION("Pmr Dag rejects parallel edges")
+		{
+			boost::container::pmr::unsynchronized_pool_resource pool;
+			ScopedGraphResource scope{ &pool };
+			PmrDag dag;
+			auto v0 = boost::add_vertex(dag);
+			auto v1 = boost::add_vertex(dag);
+			auto [e, ok] = boost::add_edge(v0, v1, dag);
+			auto [e2, ok2] = boost::add_edge(v0, v1, dag);
+			REQUIRE(ok);
+			REQUIRE(!ok2);
+			REQUIRE(boost::num_edges(dag) == 1);
+		}
+
+		SECTION("Euler Cycle De Bruigin on Pmr Dag")
+		{
+			boost::container::pmr::monotonic_buffer_resource arena;
+			ScopedGraphResource scope{ &arena };
+			auto dag = make_De_Bruigin_graph<PmrDag>(8);
+			auto start_v = *boost::vertices(dag).first;
+			auto cycle = bglx::find_one_directed_euler_cycle_hierholzer(dag, start_v);
+			REQUIRE(cycle.size() == boost::num_edges(dag));
+			auto prev_v = start_v;
+			for (auto e : cycle) {
+				REQUIRE(boost::source(e, dag) == prev_v);
+				prev_v = boost::target(e, dag);
+			}
+			REQUIRE(prev_v == start_v);
+		}
+
+		SECTION("Pmr Dag keeps its resource after the scope")
+		{
+			CountingResource counting;
+			std::optional<PmrDag> dag;
+			{
+				ScopedGraphResource scope{ &counting };
+				REQUIRE(boost::container::pmr::get_default_resource() == boost::container::pmr::new_delete_resource());
+				dag.emplace(4);
+			}
+			//vertex storage grows, the new name and out-edge set node come from counting as well
+			auto count = [&counting] { return counting.counters().totals().count; };
+			auto before = count();
+			auto v = boost::add_vertex(*dag);
+			REQUIRE(count() == before + 1);
+			(*dag)[v].name = "a vertex name that does not fit the small string buffer";
+			REQUIRE(count() == before + 2);
+			boost::add_edge(0, v, *dag);
+			REQUIRE(count() == before + 3);
+			dag.reset();
+			REQUIRE(counting.counters().live() == 0);
+		}
+
+		SECTION("Graph resources are per thread")
+		{
+			auto allocationsOfOrder = [](int order) {
+				CountingResource counting;
+				ScopedGraphResource scope{ &counting };
+				auto dag = make_De_Bruigin_graph<PmrDag>(order);
+				return counting.counters().totals().count;
+			};
+			auto alone = allocationsOfOrder(4);
+			CountingResource mainResource;
+			CountingResource otherResource;
+			std::size_t otherEdges = 0;
+			{
+				ScopedGraphResource scope{ &mainResource };
+				//a graph built on another thread meanwhile allocates from its own scope's resource only
+				std::thread other([&] {
+					ScopedGraphResource otherScope{ &otherResource };
+					otherEdges = boost::num_edges(make_De_Bruigin_graph<PmrDag>(6));
+				});
+				auto dag = make_De_Bruigin_graph<PmrDag>(4);
+				other.join();
+				REQUIRE(boost::num_edges(dag) == boost::num_edges(make_De_Bruigin_graph(4)));
+			}
+			REQUIRE(otherEdges == boost::num_edges(make_De_Bruigin_graph(6)));
+			REQUIRE(mainResource.counters().totals().count == alone);
+			REQUIRE(otherResource.counters().totals().count > 0);
+			REQUIRE(mainResource.counters().live() == 0);
+			REQUIRE(otherResource.counters().live() == 0);
+		}
+	}
+
+	TEST_CASE("Flat Dag")
+	{
+		SECTION("Flat Dag rejects parallel edges and keeps out-edges sorted")
+		{
+			FlatDag dag{ 4 };
+			REQUIRE(boost::add_edge(0, 3, dag).second);
+			REQUIRE(boost::add_edge(0, 1, dag).second);
+			REQUIRE(boost::add_edge(0, 2, dag).second);
+			REQUIRE(!boost::add_edge(0, 1, dag).second);
+			REQUIRE(boost::out_degree(0, dag) == 3);
+			auto targets = std::vector<Vertex>{};
+			for (auto e : boost::make_iterator_range(boost::out_edges(0, dag)))
+				targets.push_back(boost::target(e, dag));
+			REQUIRE(targets == std::vector<Vertex>{ 1, 2, 3 });
+			REQUIRE(boost::edge(0, 2, dag).second);
+			REQUIRE(!boost::edge(2, 0, dag).second);
+			boost::remove_edge(0, 2, dag);
+			REQUIRE(!boost::edge(0, 2, dag).second);
+			REQUIRE(boost::num_edges(dag) == 2);
+		}
+
+		SECTION("Bulk loaded Flat Dag matches Dag")
+		{
+			constexpr std::size_t nrVertices = 50;
+			auto rng = std::mt19937{ 7 };
+			auto pick = std::uniform_int_distribution<std::size_t>{ 0, nrVertices - 1 };
+			auto dag = Dag{ nrVertices };
+			auto flatDag = FlatDag{ nrVertices };
+			auto loader = BulkEdgeLoader<FlatDag>{ flatDag };
+			for (int i = 0; i < 2000; ++i) {
+				auto u = pick(rng);
+				auto v = pick(rng);
+				auto name = std::to_string(i);
+				auto [e, ok] = boost::add_edge(u, v, dag);
+				if (ok)
+					dag[e].name = name;
+				loader.add_edge(u, v, EdgeProperty{ name });
+			}
+			REQUIRE(boost::num_edges(flatDag) == 0);
+			REQUIRE(loader.freeze() == boost::num_edges(dag));
+			REQUIRE(boost::num_edges(flatDag) == boost::num_edges(dag));
+			for (auto e : boost::make_iterator_range(boost::edges(dag))) {
+				auto [flatE, found] = boost::edge(boost::source(e, dag), boost::target(e, dag), flatDag);
+				REQUIRE(found);
+				REQUIRE(flatDag[flatE].name == dag[e].name);
+			}
+		}
+
+		SECTION("Bulk loads merge into a Flat Dag that has edges")
+		{
+			constexpr std::size_t nrVertices = 50;
+			auto rng = std::mt19937{ 8 };
+			auto pick = std::uniform_int_distribution<std::size_t>{ 0, nrVertices - 1 };
+			auto dag = Dag{ nrVertices };
+			auto flatDag = FlatDag{ nrVertices };
+			for (int batch = 0; batch < 3; ++batch) {
+				auto loader = BulkEdgeLoader<FlatDag>{ flatDag };
+				auto nrBefore = boost::num_edges(dag);
+				for (int i = 0; i < 700; ++i) {
+					auto u = pick(rng);
+					auto v = pick(rng);
+					auto name = std::to_string(batch) + "/" + std::to_string(i);
+					auto [e, ok] = boost::add_edge(u, v, dag);
+					if (ok)
+						dag[e].name = name;
+					loader.add_edge(u, v, EdgeProperty{ name });
+				}
+				REQUIRE(loader.freeze() == boost::num_edges(dag) - nrBefore);
+				REQUIRE(boost::num_edges(flatDag) == boost::num_edges(dag));
+			}
+			for (auto v : boost::make_iterator_range(boost::vertices(flatDag))) {
+				auto [e, eEnd] = boost::out_edges(v, flatDag);
+				REQUIRE(std::is_sorted(e, eEnd, [&](auto a, auto b) { return boost::target(a, flatDag) < boost::target(b, flatDag); }));
+			}
+			//names of the first batch that added an edge survive the later ones
+			for (auto e : boost::make_iterator_range(boost::edges(dag))) {
+				auto [flatE, found] = boost::edge(boost::source(e, dag), boost::target(e, dag), flatDag);
+				REQUIRE(found);
+				REQUIRE(flatDag[flatE].name == dag[e].name);
+			}
+		}
+
+		SECTION("Euler Cycle De Bruigin on Flat Dag")
+		{
+			auto dag = make_De_Bruigin_graph<FlatDag>(8);
+			auto start_v = *boost::vertices(dag).first;
+			auto cycle = bglx::find_one_directed_euler_cycle_hierholzer(dag, start_v);
+			REQUIRE(cycle.size() == boost::num_edges(dag));
+			auto prev_v = start_v;
+			for (auto e : cycle) {
+				REQUIRE(boost::source(e, dag) == prev_v);
+				prev_v = boost::target(e, dag);
+			}
+			REQUIRE(prev_v == start_v);
+		}
+	}
+
+	TEST_CASE("Indexed Dag")
+	{
+		SECTION("Name index follows add, remove and clear")
+		{
+			auto dag = IndexedDag{};
+			std::vector<Vertex> vs;
+			for (int i = 0; i < 1000; ++i) {
+				auto [v, added] = dag.add_vertex("v" + std::to_string(i));
+				REQUIRE(added);
+				vs.push_back(v);
+			}
+			REQUIRE(!dag.add_vertex("v10").second);
+			REQUIRE(dag.add_vertex("v10").first == vs[10]);
+			boost::add_edge(vs[1], vs[2], dag.graph());
+			boost::add_edge(vs[2], vs[3], dag.graph());
+
+			dag.remove_vertex(vs[2]);
+			REQUIRE(!dag.vertex("v2").second);
+			REQUIRE(boost::num_vertices(dag.graph()) == 999);
+			REQUIRE(boost::num_edges(dag.graph()) == 0);
+			for (int i = 0; i < 1000; i += 7) {
+				if (i == 2)
+					continue;
+				auto name = "v" + std::to_string(i);
+				auto [v, found] = dag.vertex(name);
+				REQUIRE(found);
+				REQUIRE(dag.graph()[v].name == name);
+			}
+
+			dag.clear();
+			REQUIRE(!dag.vertex("v1").second);
+			REQUIRE(dag.add_vertex("v1").second);
+		}
+
+		SECTION("Name index survives many removals")
+		{
+			auto dag = IndexedDag{ make_De_Bruigin_graph(6) };
+			auto rng = std::mt19937{ 11 };
+			while (boost::num_vertices(dag.graph()) > 10) {
+				auto pick = std::uniform_int_distribution<Vertex>{ 0, boost::num_vertices(dag.graph()) - 1 };
+				dag.remove_vertex(pick(rng));
+			}
+			for (auto v : boost::make_iterator_range(boost::vertices(dag.graph()))) {
+				auto [found_v, found] = dag.vertex(dag.graph()[v].name);
+				REQUIRE(found);
+				REQUIRE(found_v == v);
+			}
+		}
+	}
+
+	//run explicitly with: BGLTest "[benchmark]"
+	TEST_CASE("Pmr Dag vs Dag De Bruigin build", "[.][benchmark]")
+	{
+		constexpr int order = 18;
+		{
+			std::optional<Dag> dag;
+			{
+				AutoProfiler timer{ "Dag De Bruigin build takes time: ", ProfileAllocations };
+				dag = make_De_Bruigin_graph(order);
+			}
+			AutoProfiler timer{ "Dag teardown takes time: " };
+			dag.reset();
+		}
+		{
+			boost::container::pmr::monotonic_buffer_resource arena;
+			ScopedGraphResource scope{ &arena };
+			std::optional<PmrDag> dag;
+			{
+				AutoProfiler timer{ "PmrDag (monotonic) De Bruigin build takes time: ", ProfileAllocations };
+				dag = make_De_Bruigin_graph<PmrDag>(order);
+			}
+			AutoProfiler timer{ "PmrDag (monotonic) teardown and arena release takes time: " };
+			dag.reset();
+			arena.release();
+		}
+		{
+			boost::container::pmr::unsynchronized_pool_resource pool;
+			ScopedGraphResource scope{ &pool };
+			std::optional<PmrDag> dag;
+			{
+				AutoProfiler timer{ "PmrDag (pool) De Bruigin build takes time: ", ProfileAllocations };
+				dag = make_De_Bruigin_graph<PmrDag>(order);
+			}
+			AutoProfiler timer{ "PmrDag (pool) teardown and pool release takes time: " };
+			dag.reset();
+			pool.release();
+		}
+	}
+
+	template <class Graph>
+	static std::size_t sum_out_edge_targets(const Graph& dag, int rounds)
+	{
+		auto sum = std::size_t{ 0 };
+		for (int i = 0; i < rounds; ++i) {
+			for (auto v : boost::make_iterator_range(boost::vertices(dag))) {
+				for (auto e : boost::make_iterator_range(boost::out_edges(v, dag)))
+					sum += boost::target(e, dag);
+			}
+		}
+		return sum;
+	}
+
+	TEST_CASE("Flat Dag vs Dag dense build and out-edge scan", "[.][benchmark]")
+	{
+		constexpr std::size_t nrVertices = 1000;
+		auto pairs = std::vector<std::pair<std::size_t, std::size_t>>{};
+		for (std::size_t u = 0; u < nrVertices; ++u) {
+			for (std::size_t v = 0; v < nrVertices; ++v)
+				pairs.emplace_back(u, v);
+		}
+		std::shuffle(pairs.begin(), pairs.end(), std::mt19937{ 7 });
+
+		auto dag = Dag{ nrVertices };
+		{
+			AutoProfiler timer{ "Dag (setS) add_edge build takes time: " };
+			for (auto [u, v] : pairs)
+				boost::add_edge(u, v, dag);
+		}
+		auto flatDag = FlatDag{ nrVertices };
+		{
+			AutoProfiler timer{ "FlatDag bulk load build takes time: " };
+			auto loader = BulkEdgeLoader<FlatDag>{ flatDag };
+			loader.reserve(pairs.size());
+			for (auto [u, v] : pairs)
+				loader.add_edge(u, v);
+			loader.freeze();
+		}
+		{
+			auto slowFlatDag = FlatDag{ nrVertices };
+			AutoProfiler timer{ "FlatDag add_edge build takes time: " };
+			for (auto [u, v] : pairs)
+				boost::add_edge(u, v, slowFlatDag);
+		}
+		std::size_t sum = 0, flatSum = 0;
+		{
+			AutoProfiler timer{ "Dag (setS) out-edge scan takes time: " };
+			sum = sum_out_edge_targets(dag, 10);
+		}
+		{
+			AutoProfiler timer{ "FlatDag out-edge scan takes time: " };
+			flatSum = sum_out_edge_targets(flatDag, 10);
+		}
+		REQUIRE(sum == flatSum);
+	}
+}
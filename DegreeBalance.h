@@ -0,0 +1,376 @@
+#pragma once
+#include "BitOps.h"
+#include "CsrGraph.h"
+#include "EulerDegrees.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#if defined(_M_X64) || defined(__x86_64__)
+#define BGLX_SIMD_X64 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#else
+#define BGLX_SIMD_X64 0
+#endif
+
+//msvc compiles any intrinsic without /arch flags; gcc and clang need the instruction set per function.
+//callers must check detected_simd_level() before running such a function.
+#if BGLX_SIMD_X64 && (defined(__GNUC__) || defined(__clang__))
+#define BGLX_TARGET_AVX2 __attribute__((target("avx2")))
+#define BGLX_TARGET_AVX512 __attribute__((target("avx512f,avx512cd")))
+#else
+#define BGLX_TARGET_AVX2
+#define BGLX_TARGET_AVX512
+#endif
+
+namespace bglx::test
+{
+	enum class SimdLevel
+	{
+		Scalar,
+		Avx2,
+		//AVX-512 F and CD, for the conflict detection
+		Avx512
+	};
+
+	//the widest level this cpu and operating system support, from cpuid once
+	inline SimdLevel detected_simd_level()
+	{
+		static const auto level = [] {
+#if BGLX_SIMD_X64
+#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7)
+				return SimdLevel::Scalar;
+			__cpuid(info, 1);
+			//the os has to save the vector registers (osxsave and the xcr0 bits) for them to be usable
+			if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+				return SimdLevel::Scalar;
+			auto xcr0 = _xgetbv(0);
+			__cpuidex(info, 7, 0);
+			if ((info[1] & (1 << 16)) != 0 && (info[1] & (1 << 28)) != 0 && (xcr0 & 0xE6) == 0xE6)
+				return SimdLevel::Avx512;
+			if ((info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6)
+				return SimdLevel::Avx2;
+#else
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512cd"))
+				return SimdLevel::Avx512;
+			if (__builtin_cpu_supports("avx2"))
+				return SimdLevel::Avx2;
+#endif
+#endif
+			return SimdLevel::Scalar;
+		}();
+		return level;
+	}
+
+	struct DegreeBalanceOptions
+	{
+		//0 means one thread per hardware thread
+		unsigned nrThreads = 0;
+		//kernels to use, lowered to detected_simd_level() if the cpu lacks them
+		SimdLevel simd = SimdLevel::Avx512;
+	};
+
+	namespace detail
+	{
+		//the kernels work on a vertex range [vBegin, vEnd): out-degrees into balance, every target of a
+		//slice that falls into the range subtracted, partial counts added up and the unbalanced vertices
+		//listed. counters are 32 bit and wrap, which is exact while no vertex has 2^31 edges or more.
+		struct BalanceKernels
+		{
+			void (*out_degrees)(const std::uint64_t* offsets, std::size_t vBegin, std::size_t vEnd, std::int32_t* balance);
+			//counters[v - vBegin] for the targets v in the range
+			void (*subtract_targets)(const std::uint32_t* targets, std::size_t nrEdges, std::size_t vBegin, std::size_t vEnd,
+				std::int32_t* counters);
+			//to[i] += from[i]
+			void (*add_counters)(const std::int32_t* from, std::size_t count, std::int32_t* to);
+			//appends v for every balance[v] != 0 in [vBegin, vEnd) to found, stops once it holds limit
+			void (*unbalanced)(const std::int32_t* balance, std::size_t vBegin, std::size_t vEnd,
+				std::vector<std::uint32_t>& found, std::size_t limit);
+		};
+
+		inline void out_degrees_scalar(const std::uint64_t* offsets, std::size_t vBegin, std::size_t vEnd, std::int32_t* balance)
+		{
+			for (auto v = vBegin; v < vEnd; ++v)
+				balance[v] = static_cast<std::int32_t>(offsets[v + 1] - offsets[v]);
+		}
+
+		inline void subtract_targets_scalar(const std::uint32_t* targets, std::size_t nrEdges, std::size_t vBegin,
+			std::size_t vEnd, std::int32_t* counters)
+		{
+			auto wrapping = reinterpret_cast<std::uint32_t*>(counters);
+			for (std::size_t e = 0; e < nrEdges; ++e) {
+				if (targets[e] - vBegin < vEnd - vBegin)
+					--wrapping[targets[e] - vBegin];
+			}
+		}
+
+		inline void add_counters_scalar(const std::int32_t* from, std::size_t count, std::int32_t* to)
+		{
+			auto wrapping = reinterpret_cast<std::uint32_t*>(to);
+			for (std::size_t i = 0; i < count; ++i)
+				wrapping[i] += static_cast<std::uint32_t>(from[i]);
+		}
+
+		inline void unbalanced_scalar(const std::int32_t* balance, std::size_t vBegin, std::size_t vEnd,
+			std::vector<std::uint32_t>& found, std::size_t limit)
+		{
+			for (auto v = vBegin; v < vEnd && found.size() < limit; ++v) {
+				if (balance[v] != 0)
+					found.push_back(static_cast<std::uint32_t>(v));
+			}
+		}
+
+#if BGLX_SIMD_X64
+		//the low halves of 8 64-bit differences, 4 from each register, in order
+		BGLX_TARGET_AVX2 inline void out_degrees_avx2(const std::uint64_t* offsets, std::size_t vBegin, std::size_t vEnd,
+			std::int32_t* balance)
+		{
+			const auto lowHalves = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+			auto v = vBegin;
+			for (; v + 8 <= vEnd; v += 8) {
+				auto first = _mm256_sub_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + v + 1)),
+					_mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + v)));
+				auto second = _mm256_sub_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + v + 5)),
+					_mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + v + 4)));
+				auto low = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(first, lowHalves));
+				auto high = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(second, lowHalves));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(balance + v), _mm256_set_m128i(high, low));
+			}
+			out_degrees_scalar(offsets, v, vEnd, balance);
+		}
+
+		//AVX2 has no scatter: 8 targets at a time are tested against the range, which skips the targets
+		//outside it at load speed, and the ones inside are decremented one by one
+		BGLX_TARGET_AVX2 inline void subtract_targets_avx2(const std::uint32_t* targets, std::size_t nrEdges,
+			std::size_t vBegin, std::size_t vEnd, std::int32_t* counters)
+		{
+			if (vBegin == vEnd)
+				return;
+			auto wrapping = reinterpret_cast<std::uint32_t*>(counters);
+			const auto first = _mm256_set1_epi32(static_cast<int>(vBegin));
+			const auto last = _mm256_set1_epi32(static_cast<int>(vEnd - vBegin - 1));
+			std::size_t e = 0;
+			for (; e + 8 <= nrEdges; e += 8) {
+				auto offset = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(targets + e)), first);
+				//unsigned offset <= last
+				auto owned = _mm256_cmpeq_epi32(_mm256_min_epu32(offset, last), offset);
+				auto lanes = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(owned)));
+				//all lanes owned is the common case with few threads
+				if (lanes == 0xFFu) {
+					for (auto i = e; i < e + 8; ++i)
+						--wrapping[targets[i] - vBegin];
+					continue;
+				}
+				for (; lanes != 0; lanes &= lanes - 1)
+					--wrapping[targets[e + count_trailing_zeros(lanes)] - vBegin];
+			}
+			subtract_targets_scalar(targets + e, nrEdges - e, vBegin, vEnd, counters);
+		}
+
+		BGLX_TARGET_AVX2 inline void add_counters_avx2(const std::int32_t* from, std::size_t count, std::int32_t* to)
+		{
+			std::size_t i = 0;
+			for (; i + 8 <= count; i += 8) {
+				auto sum = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(from + i)),
+					_mm256_loadu_si256(reinterpret_cast<const __m256i*>(to + i)));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(to + i), sum);
+			}
+			add_counters_scalar(from + i, count - i, to + i);
+		}
+
+		BGLX_TARGET_AVX2 inline void unbalanced_avx2(const std::int32_t* balance, std::size_t vBegin, std::size_t vEnd,
+			std::vector<std::uint32_t>& found, std::size_t limit)
+		{
+			auto v = vBegin;
+			for (; v + 8 <= vEnd && found.size() < limit; v += 8) {
+				auto values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(balance + v));
+				auto zero = _mm256_cmpeq_epi32(values, _mm256_setzero_si256());
+				auto lanes = ~static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(zero))) & 0xFFu;
+				for (; lanes != 0 && found.size() < limit; lanes &= lanes - 1)
+					found.push_back(static_cast<std::uint32_t>(v + count_trailing_zeros(lanes)));
+			}
+			unbalanced_scalar(balance, v, vEnd, found, limit);
+		}
+
+		BGLX_TARGET_AVX512 inline void out_degrees_avx512(const std::uint64_t* offsets, std::size_t vBegin, std::size_t vEnd,
+			std::int32_t* balance)
+		{
+			auto v = vBegin;
+			for (; v + 8 <= vEnd; v += 8) {
+				auto degrees = _mm512_sub_epi64(_mm512_loadu_si512(offsets + v + 1), _mm512_loadu_si512(offsets + v));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(balance + v), _mm512_cvtepi64_epi32(degrees));
+			}
+			out_degrees_scalar(offsets, v, vEnd, balance);
+		}
+
+		//16 targets at a time: lanes outside the range are masked off, the owned ones gathered,
+		//decremented and scattered back. lanes with the same target would lose updates in one scatter,
+		//so vpconflictd lists for every lane the earlier lanes with the same target and each round only
+		//writes the lanes that have no such lane left; one round unless a target repeats.
+		//gather and scatter take signed 32-bit indices, so they index by the offset into the range,
+		//and ranges wider than 2^31 - 1 vertices go to the scalar kernel.
+		BGLX_TARGET_AVX512 inline void subtract_targets_avx512(const std::uint32_t* targets, std::size_t nrEdges,
+			std::size_t vBegin, std::size_t vEnd, std::int32_t* counters)
+		{
+			if (vBegin == vEnd)
+				return;
+			if (vEnd - vBegin > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max())) {
+				subtract_targets_scalar(targets, nrEdges, vBegin, vEnd, counters);
+				return;
+			}
+			const auto first = _mm512_set1_epi32(static_cast<int>(vBegin));
+			const auto width = _mm512_set1_epi32(static_cast<int>(vEnd - vBegin));
+			const auto one = _mm512_set1_epi32(1);
+			std::size_t e = 0;
+			for (; e + 16 <= nrEdges; e += 16) {
+				auto index = _mm512_sub_epi32(_mm512_loadu_si512(targets + e), first);
+				__mmask16 todo = _mm512_cmplt_epu32_mask(index, width);
+				if (todo == 0)
+					continue;
+				auto conflicts = _mm512_maskz_conflict_epi32(todo, index);
+				while (todo != 0) {
+					auto waiting = _mm512_and_si512(conflicts, _mm512_set1_epi32(todo));
+					__mmask16 ready = _mm512_mask_testn_epi32_mask(todo, waiting, waiting);
+					auto values = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), ready, index, counters, 4);
+					_mm512_mask_i32scatter_epi32(counters, ready, index, _mm512_sub_epi32(values, one), 4);
+					todo = static_cast<__mmask16>(todo & ~ready);
+				}
+			}
+			subtract_targets_scalar(targets + e, nrEdges - e, vBegin, vEnd, counters);
+		}
+
+		BGLX_TARGET_AVX512 inline void add_counters_avx512(const std::int32_t* from, std::size_t count, std::int32_t* to)
+		{
+			std::size_t i = 0;
+			for (; i + 16 <= count; i += 16)
+				_mm512_storeu_si512(to + i, _mm512_add_epi32(_mm512_loadu_si512(from + i), _mm512_loadu_si512(to + i)));
+			add_counters_scalar(from + i, count - i, to + i);
+		}
+
+		BGLX_TARGET_AVX512 inline void unbalanced_avx512(const std::int32_t* balance, std::size_t vBegin, std::size_t vEnd,
+			std::vector<std::uint32_t>& found, std::size_t limit)
+		{
+			auto v = vBegin;
+			for (; v + 16 <= vEnd && found.size() < limit; v += 16) {
+				auto values = _mm512_loadu_si512(balance + v);
+				for (unsigned lanes = _mm512_test_epi32_mask(values, values); lanes != 0 && found.size() < limit; lanes &= lanes - 1)
+					found.push_back(static_cast<std::uint32_t>(v + count_trailing_zeros(lanes)));
+			}
+			unbalanced_scalar(balance, v, vEnd, found, limit);
+		}
+#endif
+
+		inline BalanceKernels balance_kernels(SimdLevel level)
+		{
+			level = std::min(level, detected_simd_level());
+#if BGLX_SIMD_X64
+			if (level == SimdLevel::Avx512)
+				return { out_degrees_avx512, subtract_targets_avx512, add_counters_avx512, unbalanced_avx512 };
+			if (level == SimdLevel::Avx2)
+				return { out_degrees_avx2, subtract_targets_avx2, add_counters_avx2, unbalanced_avx2 };
+#endif
+			return { out_degrees_scalar, subtract_targets_scalar, add_counters_scalar, unbalanced_scalar };
+		}
+	}
+
+	//out-degree minus in-degree of every vertex, by the widest kernels the cpu runs. the targets are
+	//split between the threads, and every thread counts its slice into counters of its own that are
+	//added up by vertex range afterwards. when the counters of all threads would take more memory than
+	//the graph, the targets are regrouped by vertex range first (partition_by_owner) and every thread
+	//counts those of its range instead. either way each target is read a fixed number of times.
+	static std::vector<std::int32_t> degree_balance(const CsrGraph& g, const DegreeBalanceOptions& options = {})
+	{
+		auto& a = g.arrays();
+		auto n = a.nrVertices;
+		auto kernels = detail::balance_kernels(options.simd);
+		auto nrThreads = a.nrEdges < (1 << 16) ? 1u : options.nrThreads == 0 ? default_thread_count() : options.nrThreads;
+		std::vector<std::int32_t> balance(n);
+		parallel_chunks(n, nrThreads, [&](unsigned, std::size_t vBegin, std::size_t vEnd) {
+			kernels.out_degrees(a.offsets, vBegin, vEnd, balance.data());
+		});
+		if (nrThreads == 1) {
+			kernels.subtract_targets(a.targets, a.nrEdges, 0, n, balance.data());
+			return balance;
+		}
+		//partial counters up to the size of the graph itself, offsets and targets
+		if (std::uint64_t{ nrThreads - 1 } * n <= 2 * std::uint64_t{ n } + a.nrEdges) {
+			//slice 0 counts into balance itself
+			std::vector<std::vector<std::int32_t>> partial(nrThreads - 1);
+			parallel_chunks(a.nrEdges, nrThreads, [&](unsigned t, std::size_t eBegin, std::size_t eEnd) {
+				auto counters = balance.data();
+				if (t != 0) {
+					partial[t - 1].assign(n, 0);
+					counters = partial[t - 1].data();
+				}
+				kernels.subtract_targets(a.targets + eBegin, eEnd - eBegin, 0, n, counters);
+			});
+			parallel_chunks(n, nrThreads, [&](unsigned, std::size_t vBegin, std::size_t vEnd) {
+				for (auto& counters : partial)
+					kernels.add_counters(counters.data() + vBegin, vEnd - vBegin, balance.data() + vBegin);
+			});
+			return balance;
+		}
+		auto owners = detail::OwnerRanges{ n, nrThreads };
+		std::vector<std::uint64_t> ownerOffsets;
+		auto owned = detail::partition_by_owner<std::uint32_t>(owners, nrThreads, [&](std::size_t c, auto&& emit) {
+			for (auto e = a.nrEdges * c / nrThreads; e < a.nrEdges * (c + 1) / nrThreads; ++e)
+				emit(a.targets[e], a.targets[e]);
+		}, nrThreads, ownerOffsets);
+		parallel_for(owners.nrOwners, owners.nrOwners, [&](std::size_t o) {
+			auto vBegin = owners.begin(static_cast<unsigned>(o));
+			kernels.subtract_targets(owned.data() + ownerOffsets[o], ownerOffsets[o + 1] - ownerOffsets[o], vBegin,
+				owners.end(static_cast<unsigned>(o)), balance.data() + vBegin);
+		});
+		return balance;
+	}
+
+	//check_euler_degrees for a CsrGraph on the balance kernels: the same result, but from a streaming
+	//pass over the arrays instead of one out-degree and one edge walk per vertex
+	static EulerDegreeCheck<CsrGraph> check_euler_balance(const CsrGraph& g, const DegreeBalanceOptions& options = {})
+	{
+		constexpr std::size_t Limit = 3;
+		auto& a = g.arrays();
+		auto kernels = detail::balance_kernels(options.simd);
+		auto nrThreads = options.nrThreads == 0 ? default_thread_count() : options.nrThreads;
+		auto balance = degree_balance(g, options);
+		auto nrSlices = a.nrVertices < (1 << 16) ? 1u : nrThreads;
+		std::vector<std::vector<std::uint32_t>> found(nrSlices);
+		parallel_chunks(a.nrVertices, nrSlices, [&](unsigned s, std::size_t vBegin, std::size_t vEnd) {
+			kernels.unbalanced(balance.data(), vBegin, vEnd, found[s], Limit);
+		});
+		std::vector<std::uint32_t> unbalanced;
+		for (auto& slice : found)
+			unbalanced.insert(unbalanced.end(), slice.begin(), slice.end());
+
+		auto result = EulerDegreeCheck<CsrGraph>{};
+		if (unbalanced.empty()) {
+			result.balance = EulerBalance::Circuit;
+			auto first = std::upper_bound(a.offsets, a.offsets + a.nrVertices + 1, std::uint64_t{ 0 });
+			if (a.nrEdges != 0)
+				result.start = result.last = static_cast<std::size_t>(first - a.offsets - 1);
+			return result;
+		}
+		if (unbalanced.size() != 2)
+			return result;
+		for (auto v : unbalanced) {
+			if (balance[v] == 1)
+				result.start = v;
+			else if (balance[v] == -1)
+				result.last = v;
+		}
+		if (result.start == boost::graph_traits<CsrGraph>::null_vertex() || result.last == boost::graph_traits<CsrGraph>::null_vertex())
+			return {};
+		result.balance = EulerBalance::Trail;
+		return result;
+	}
+}
@@ -0,0 +1,207 @@
+#pragma once
+#include "NamedDag.h"
+#include "TopologicalSort.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace bglx::test
+{
+	//outcome of DynamicDag::add_edge. a rejected edge u -> v leaves cycle as the path v, ..., u that
+	//already exists in the graph and that the edge would have closed ({ u } for a self-loop).
+	struct DagInsertion
+	{
+		Edge edge{};
+		bool inserted = false;
+		std::vector<Vertex> cycle;
+
+		bool creates_cycle() const { return !cycle.empty(); }
+	};
+
+	//a Dag that keeps a topological order while edges are added one by one (Pearce and Kelly, "A
+	//dynamic topological sort algorithm for directed acyclic graphs"). an edge u -> v that agrees with
+	//the order costs one set insertion; otherwise only the vertices ordered between v and u that are
+	//reachable from v or reach u are searched and moved. edges closing a cycle are rejected.
+	//vertices can only be added, and edges have to go through this wrapper so the order and the
+	//in-edges it keeps stay in sync, which is why graph() is read-only.
+	class DynamicDag
+	{
+	public:
+		DynamicDag() = default;
+
+		//takes over an acyclic graph and orders it once with topological_levels
+		explicit DynamicDag(Dag dag) : m_dag(std::move(dag))
+		{
+			auto nrVertices = boost::num_vertices(m_dag);
+			auto levels = topological_levels(m_dag);
+			if (!levels.is_acyclic())
+				throw std::invalid_argument("DynamicDag needs an acyclic graph.");
+			m_vertexAt.assign(levels.order.begin(), levels.order.end());
+			m_position.resize(nrVertices);
+			for (std::size_t i = 0; i < nrVertices; ++i)
+				m_position[m_vertexAt[i]] = static_cast<std::uint32_t>(i);
+			m_inEdges.resize(nrVertices);
+			for (auto e : boost::make_iterator_range(boost::edges(m_dag)))
+				m_inEdges[boost::target(e, m_dag)].push_back(boost::source(e, m_dag));
+			m_mark.assign(nrVertices, 0);
+			m_parent.resize(nrVertices);
+		}
+
+		const Dag& graph() const { return m_dag; }
+
+		//vertices in topological order, and where a vertex stands in it
+		const std::vector<Vertex>& order() const { return m_vertexAt; }
+		std::size_t position(Vertex v) const { return m_position[v]; }
+
+		void reserve(std::size_t nrVertices)
+		{
+			m_position.reserve(nrVertices);
+			m_vertexAt.reserve(nrVertices);
+			m_inEdges.reserve(nrVertices);
+			m_mark.reserve(nrVertices);
+			m_parent.reserve(nrVertices);
+		}
+
+		//new vertices go to the end of the order
+		Vertex add_vertex(VertexProperty property = {})
+		{
+			if (m_vertexAt.size() >= std::numeric_limits<std::uint32_t>::max())
+				throw std::length_error("DynamicDag supports up to 2^32 - 1 vertices.");
+			auto v = boost::add_vertex(std::move(property), m_dag);
+			m_position.push_back(static_cast<std::uint32_t>(m_vertexAt.size()));
+			m_vertexAt.push_back(v);
+			m_inEdges.emplace_back();
+			m_mark.push_back(0);
+			m_parent.emplace_back();
+			return v;
+		}
+
+		//an existing edge is returned with inserted false, as boost::add_edge on setS does
+		DagInsertion add_edge(Vertex u, Vertex v, EdgeProperty property = {})
+		{
+			auto result = DagInsertion{};
+			if (u == v) {
+				result.cycle.push_back(u);
+				return result;
+			}
+			auto [existing, found] = boost::edge(u, v, m_dag);
+			if (found) {
+				result.edge = existing;
+				return result;
+			}
+			if (m_position[u] > m_position[v] && !reorder(u, v, result.cycle))
+				return result;
+			result.edge = boost::add_edge(u, v, std::move(property), m_dag).first;
+			result.inserted = true;
+			m_inEdges[v].push_back(u);
+			return result;
+		}
+
+		//removing edges never invalidates the order
+		bool remove_edge(Vertex u, Vertex v)
+		{
+			auto [e, found] = boost::edge(u, v, m_dag);
+			if (!found)
+				return false;
+			boost::remove_edge(e, m_dag);
+			auto& in = m_inEdges[v];
+			*std::find(in.begin(), in.end(), u) = in.back();
+			in.pop_back();
+			return true;
+		}
+
+	private:
+		//u is ordered after v: finds the vertices reachable from v up to u's position (forward) and
+		//those reaching u down to v's position (backward), then hands the positions they hold to the
+		//backward set first and the forward set after it, each keeping its relative order. returns
+		//false with the path v .. u in cycle when the forward search reaches u.
+		bool reorder(Vertex u, Vertex v, std::vector<Vertex>& cycle)
+		{
+			auto lower = m_position[v];
+			auto upper = m_position[u];
+			next_epoch();
+
+			m_forward.clear();
+			m_stack.assign(1, v);
+			m_mark[v] = m_epoch;
+			while (!m_stack.empty()) {
+				auto x = m_stack.back();
+				m_stack.pop_back();
+				m_forward.push_back(x);
+				for (auto [e, eEnd] = boost::out_edges(x, m_dag); e != eEnd; ++e) {
+					auto y = boost::target(*e, m_dag);
+					if (y == u) {
+						for (cycle.push_back(u); x != v; x = m_parent[x])
+							cycle.push_back(x);
+						cycle.push_back(v);
+						std::reverse(cycle.begin(), cycle.end());
+						return false;
+					}
+					if (m_mark[y] != m_epoch && m_position[y] < upper) {
+						m_mark[y] = m_epoch;
+						m_parent[y] = x;
+						m_stack.push_back(y);
+					}
+				}
+			}
+
+			//the sets cannot overlap: a vertex in both would put u behind v already
+			m_backward.clear();
+			m_stack.assign(1, u);
+			m_mark[u] = m_epoch;
+			while (!m_stack.empty()) {
+				auto x = m_stack.back();
+				m_stack.pop_back();
+				m_backward.push_back(x);
+				for (auto y : m_inEdges[x]) {
+					if (m_mark[y] != m_epoch && m_position[y] > lower) {
+						m_mark[y] = m_epoch;
+						m_stack.push_back(y);
+					}
+				}
+			}
+
+			auto byPosition = [this](Vertex a, Vertex b) { return m_position[a] < m_position[b]; };
+			std::sort(m_forward.begin(), m_forward.end(), byPosition);
+			std::sort(m_backward.begin(), m_backward.end(), byPosition);
+			m_slots.clear();
+			for (auto x : m_backward)
+				m_slots.push_back(m_position[x]);
+			for (auto x : m_forward)
+				m_slots.push_back(m_position[x]);
+			std::inplace_merge(m_slots.begin(), m_slots.begin() + m_backward.size(), m_slots.end());
+			auto slot = m_slots.begin();
+			for (auto moved : { &m_backward, &m_forward }) {
+				for (auto x : *moved) {
+					m_vertexAt[*slot] = x;
+					m_position[x] = *slot++;
+				}
+			}
+			return true;
+		}
+
+		void next_epoch()
+		{
+			if (++m_epoch == 0) {
+				std::fill(m_mark.begin(), m_mark.end(), 0);
+				m_epoch = 1;
+			}
+		}
+
+		Dag m_dag;
+		std::vector<std::uint32_t> m_position;
+		std::vector<Vertex> m_vertexAt;
+		std::vector<std::vector<Vertex>> m_inEdges;
+		//search state, kept between insertions so that they do not allocate
+		std::vector<std::uint32_t> m_mark;
+		std::uint32_t m_epoch = 0;
+		std::vector<Vertex> m_parent;
+		std::vector<Vertex> m_stack;
+		std::vector<Vertex> m_forward;
+		std::vector<Vertex> m_backward;
+		std::vector<std::uint32_t> m_slots;
+	};
+}
@@ -0,0 +1,252 @@
+#pragma once
+#include "BitOps.h"
+#include "CsrGraph.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bglx::test
+{
+	struct EdgeListLoadOptions
+	{
+		//0 means one thread per hardware thread
+		unsigned nrThreads = 0;
+		//keep the optional third column as edge names
+		bool keepNames = true;
+		//keep only the first of several `u v` lines, like setS does
+		bool removeParallelEdges = false;
+	};
+
+	namespace detail
+	{
+		//one parsed `src dst [name]` line. line is the byte offset of the line in the file,
+		//it orders parallel edges by appearance and locates the name.
+		struct ParsedEdge
+		{
+			std::uint32_t source;
+			std::uint32_t target;
+			std::uint64_t line;
+			std::uint32_t nameBegin;
+			std::uint32_t nameLength;
+		};
+
+		//number of leading ASCII digits in the 8 bytes at p (little-endian load), without branching per byte
+		static unsigned leading_digits(std::uint64_t chunk)
+		{
+			auto x = chunk ^ 0x3030303030303030ull;
+			auto nonDigit = (x | (x + 0x0606060606060606ull)) & 0xF0F0F0F0F0F0F0F0ull;
+			return nonDigit == 0 ? 8 : count_trailing_zeros(nonDigit) / 8;
+		}
+
+		//value of the first `nrDigits` (1..8) ASCII digits in chunk, SWAR multiply-and-fold
+		static std::uint64_t fold_digits(std::uint64_t chunk, unsigned nrDigits)
+		{
+			chunk <<= 8 * (8 - nrDigits);
+			chunk = ((chunk & 0x0F0F0F0F0F0F0F0Full) * 2561) >> 8;
+			chunk = ((chunk & 0x00FF00FF00FF00FFull) * 6553601) >> 16;
+			return ((chunk & 0x0000FFFF0000FFFFull) * 42949672960001ull) >> 32;
+		}
+
+		constexpr std::uint64_t Pow10[9] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+
+		//parses an unsigned decimal at p. 8 digits at a time while at least 8 readable bytes remain,
+		//digit by digit near the end of the buffer. returns nullptr if there is no digit or it overflows.
+		static const char* parse_vertex_id(const char* p, const char* end, std::uint32_t& value)
+		{
+			auto acc = std::uint64_t{ 0 };
+			auto start = p;
+			while (end - p >= 8) {
+				std::uint64_t chunk;
+				std::memcpy(&chunk, p, 8);
+				auto nrDigits = leading_digits(chunk);
+				if (nrDigits == 0)
+					break;
+				acc = acc * Pow10[nrDigits] + fold_digits(chunk, nrDigits);
+				p += nrDigits;
+				if (nrDigits < 8 || acc > 0xFFFFFFFFull)
+					break;
+			}
+			while (p != end && static_cast<unsigned char>(*p - '0') < 10 && acc <= 0xFFFFFFFFull) {
+				acc = acc * 10 + static_cast<unsigned>(*p - '0');
+				++p;
+			}
+			if (p == start || acc > 0xFFFFFFFFull)
+				return nullptr;
+			value = static_cast<std::uint32_t>(acc);
+			return p;
+		}
+
+		//lines in [begin, end) estimated from the first 64 KiB, with some slack. reserving by bytes instead
+		//(a line per 8 bytes) would commit several times the file size before anything is parsed
+		static std::size_t estimate_lines(const char* data, std::size_t begin, std::size_t end)
+		{
+			constexpr std::size_t SampleSize = 1 << 16;
+			auto sampleEnd = std::min(end, begin + SampleSize);
+			auto nrLines = static_cast<double>(std::count(data + begin, data + sampleEnd, '\n') + 1);
+			if (sampleEnd == end)
+				return static_cast<std::size_t>(nrLines);
+			return static_cast<std::size_t>(nrLines * 1.1 * static_cast<double>(end - begin) / static_cast<double>(sampleEnd - begin));
+		}
+
+		static bool is_blank(char c) { return c == ' ' || c == '\t'; }
+
+		//parses every line that starts in [begin, end) of the file
+		static void parse_edge_lines(const char* data, std::size_t size, std::size_t begin, std::size_t end,
+			bool keepNames, std::vector<ParsedEdge>& edges, std::uint32_t& maxVertex)
+		{
+			auto fileEnd = data + size;
+			auto p = data + begin;
+			if (begin > 0) {
+				auto nl = static_cast<const char*>(std::memchr(p - 1, '\n', fileEnd - (p - 1)));
+				p = nl == nullptr ? fileEnd : nl + 1;
+			}
+			auto fail = [data](const char* at) {
+				throw std::runtime_error("Malformed edge line at byte " + std::to_string(at - data) + ".");
+			};
+			while (p < data + end) {
+				auto lineStart = p;
+				auto nl = static_cast<const char*>(std::memchr(p, '\n', fileEnd - p));
+				auto lineEnd = nl == nullptr ? fileEnd : nl;
+				auto next = nl == nullptr ? fileEnd : nl + 1;
+				if (lineEnd != p && lineEnd[-1] == '\r')
+					--lineEnd;
+				while (p != lineEnd && is_blank(*p))
+					++p;
+				if (p == lineEnd || *p == '#') {
+					p = next;
+					continue;
+				}
+				auto edge = ParsedEdge{ 0, 0, static_cast<std::uint64_t>(lineStart - data), 0, 0 };
+				//digits never run past the line break, so the parser may read ahead up to the file end
+				p = parse_vertex_id(p, fileEnd, edge.source);
+				if (p == nullptr || p == lineEnd || !is_blank(*p))
+					fail(lineStart);
+				while (p != lineEnd && is_blank(*p))
+					++p;
+				p = parse_vertex_id(p, fileEnd, edge.target);
+				if (p == nullptr || (p != lineEnd && !is_blank(*p)))
+					fail(lineStart);
+				while (p != lineEnd && is_blank(*p))
+					++p;
+				auto nameEnd = lineEnd;
+				while (nameEnd != p && is_blank(nameEnd[-1]))
+					--nameEnd;
+				if (keepNames && p != nameEnd) {
+					edge.nameBegin = static_cast<std::uint32_t>(p - lineStart);
+					edge.nameLength = static_cast<std::uint32_t>(nameEnd - p);
+				}
+				maxVertex = std::max({ maxVertex, edge.source, edge.target });
+				edges.push_back(edge);
+				p = next;
+			}
+		}
+	}
+
+	//loads a `src dst [name]` text edge list (one edge per line, blank lines and '#' comments allowed)
+	//into a CsrGraph. the file is mapped and split on line boundaries across threads, then every thread
+	//builds the rows of its own range of source vertices and sorts them, so each row lists its targets
+	//ascending and parallel edges in file order. vertices are 0..max id; names, if any, become edge names.
+	static CsrGraph load_edge_list_csr(const std::string& path, const EdgeListLoadOptions& options = {})
+	{
+		using detail::ParsedEdge;
+		auto nrThreads = options.nrThreads == 0 ? default_thread_count() : options.nrThreads;
+		auto file = MappedFile{ path };
+		file.advise_sequential();
+		auto data = file.data();
+
+		//parse
+		std::vector<std::vector<ParsedEdge>> parsed(nrThreads);
+		std::vector<std::uint32_t> maxVertex(nrThreads, 0);
+		std::vector<char> threadHasNames(nrThreads, 0);
+		parallel_chunks(file.size(), nrThreads, [&](unsigned t, std::size_t begin, std::size_t end) {
+			parsed[t].reserve(detail::estimate_lines(data, begin, end));
+			detail::parse_edge_lines(data, file.size(), begin, end, options.keepNames, parsed[t], maxVertex[t]);
+			threadHasNames[t] = std::any_of(parsed[t].begin(), parsed[t].end(),
+				[](const ParsedEdge& edge) { return edge.nameLength != 0; });
+		});
+		auto nrVertices = std::size_t{ 0 };
+		auto nrParsed = std::size_t{ 0 };
+		auto hasNames = false;
+		for (unsigned t = 0; t < nrThreads; ++t) {
+			if (!parsed[t].empty())
+				nrVertices = std::max<std::size_t>(nrVertices, maxVertex[t] + std::size_t{ 1 });
+			nrParsed += parsed[t].size();
+			hasNames |= threadHasNames[t] != 0;
+		}
+
+		//every edge into the row of its source, rows in file order (parse chunks are in file order)
+		std::vector<std::uint64_t> rowOffsets;
+		auto rows = detail::scatter_rows_by_owner<ParsedEdge>(nrVertices, parsed.size(), [&](std::size_t t, auto&& emit) {
+			for (auto& edge : parsed[t])
+				emit(edge.source, edge);
+		}, nrThreads, rowOffsets);
+		parsed.clear();
+		auto rowBegin = [&rowOffsets](std::size_t v) { return rowOffsets[v]; };
+		auto rowEnd = [&rowOffsets](std::size_t v) { return rowOffsets[v + 1]; };
+
+		//sort rows by (target, line) and keep the first of equal targets if asked to.
+		//offsets[v + 1] holds the kept out-degree of v until the prefix sum below
+		auto storage = CsrStorage{};
+		storage.offsets.assign(nrVertices + 1, 0);
+		parallel_chunks(nrVertices, nrThreads, [&](unsigned, std::size_t begin, std::size_t end) {
+			for (auto v = begin; v < end; ++v) {
+				auto first = rows.begin() + rowBegin(v);
+				auto last = rows.begin() + rowEnd(v);
+				std::sort(first, last, [](const ParsedEdge& a, const ParsedEdge& b) {
+					return a.target != b.target ? a.target < b.target : a.line < b.line;
+				});
+				if (options.removeParallelEdges) {
+					last = std::unique(first, last,
+						[](const ParsedEdge& a, const ParsedEdge& b) { return a.target == b.target; });
+				}
+				storage.offsets[v + 1] = last - first;
+			}
+		});
+		for (std::size_t v = 0; v < nrVertices; ++v)
+			storage.offsets[v + 1] += storage.offsets[v];
+		auto nrEdges = static_cast<std::size_t>(storage.offsets[nrVertices]);
+		storage.targets.resize(nrEdges);
+		if (hasNames)
+			storage.edgeNameOffsets.assign(nrEdges + 1, 0);
+		parallel_chunks(nrVertices, nrThreads, [&](unsigned, std::size_t begin, std::size_t end) {
+			for (auto v = begin; v < end; ++v) {
+				auto from = rowBegin(v);
+				for (auto i = storage.offsets[v]; i < storage.offsets[v + 1]; ++i, ++from) {
+					storage.targets[i] = rows[from].target;
+					if (hasNames)
+						storage.edgeNameOffsets[i + 1] = rows[from].nameLength;
+				}
+			}
+		});
+		if (hasNames) {
+			for (std::size_t i = 0; i < nrEdges; ++i)
+				storage.edgeNameOffsets[i + 1] += storage.edgeNameOffsets[i];
+			storage.edgeNames.resize(storage.edgeNameOffsets[nrEdges]);
+			parallel_chunks(nrVertices, nrThreads, [&](unsigned, std::size_t begin, std::size_t end) {
+				for (auto v = begin; v < end; ++v) {
+					auto from = rowBegin(v);
+					for (auto i = storage.offsets[v]; i < storage.offsets[v + 1]; ++i, ++from) {
+						auto& edge = rows[from];
+						std::memcpy(&storage.edgeNames[storage.edgeNameOffsets[i]],
+							data + edge.line + edge.nameBegin, edge.nameLength);
+					}
+				}
+			});
+		}
+		return CsrGraph{ std::move(storage) };
+	}
+
+	//same as load_edge_list_csr, then copied into a Dag (vertices named by their id, parallel edges dropped)
+	static Dag load_edge_list_dag(const std::string& path, EdgeListLoadOptions options = {})
+	{
+		options.removeParallelEdges = true;
+		return make_dag(load_edge_list_csr(path, options));
+	}
+}
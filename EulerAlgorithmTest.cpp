@@ -0,0 +1,812 @@
+#define _SILENCE_CXX17_ITERATOR_BASE_CLASS_DEPRECATION_WARNING
+#include "NamedDag.h"
+#include "IndexedDag.h"
+#include "CsrGraph.h"
+#include "Make_De_Bruijn_Euler_Digraph.h"
+#include "Timer.h"
+#include "HierholzerStats.h"
+#include "EulerVerify.h"
+#include "RandomEulerGraph.h"
+#include "EulerHarness.h"
+#include "EulerDegrees.h"
+#include "ConnectedComponents.h"
+#include "DegreeBalance.h"
+#include <BoostGraphX/euler_graph.h>
+#include <boost/graph/connected_components.hpp>
+#include <boost/graph/strong_components.hpp>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <catch.hpp>
+
+namespace bglx::test {
+	TEST_CASE("Euler circuit verifier")
+	{
+		//0 -> 1 -> 2 -> 0 and 0 -> 2 -> 1 -> 0
+		auto dag = Dag{ 3 };
+		auto e01 = boost::add_edge(0, 1, dag).first;
+		auto e12 = boost::add_edge(1, 2, dag).first;
+		auto e20 = boost::add_edge(2, 0, dag).first;
+		auto e02 = boost::add_edge(0, 2, dag).first;
+		auto e21 = boost::add_edge(2, 1, dag).first;
+		auto e10 = boost::add_edge(1, 0, dag).first;
+		auto require_error = [&](const std::vector<Edge>& walk, Vertex last, EulerCircuitError error, std::size_t position) {
+			auto check = verify_euler_circuit(dag, walk, 0, last);
+			REQUIRE(check.error == error);
+			REQUIRE(check.position == position);
+			REQUIRE(!check.message().empty());
+		};
+
+		SECTION("Valid cycle and trail")
+		{
+			REQUIRE(verify_euler_circuit(dag, std::list<Edge>{ e01, e12, e20, e02, e21, e10 }, 0, 0));
+			REQUIRE(verify_euler_circuit(Dag{ 1 }, std::vector<Edge>{}, 0, 0));
+			auto trail = std::vector<Edge>{ e01, e12, e20, e02, e21 };
+			boost::remove_edge(e10, dag);
+			REQUIRE(verify_euler_circuit(dag, trail, 0, 1));
+		}
+
+		SECTION("First offending position")
+		{
+			require_error({ e12, e20, e01, e12, e21, e10 }, 0, EulerCircuitError::WrongStart, 0);
+			require_error({ e01, e12, e21, e12, e20, e02 }, 0, EulerCircuitError::EdgeRepeated, 3);
+			require_error({ e01, e12, e20, e02, e10, e21 }, 0, EulerCircuitError::Discontinuous, 4);
+			require_error({ e01, e12, e20, e02, e21, e10 }, 1, EulerCircuitError::WrongEnd, 5);
+			require_error({ e01, e12, e20 }, 0, EulerCircuitError::EdgeMissing, 3);
+			auto other = Dag{ 3 };
+			auto foreign = boost::add_edge(0, 0, other).first;
+			require_error({ e01, e12, e20, foreign }, 0, EulerCircuitError::EdgeNotInGraph, 3);
+		}
+
+		SECTION("Parallel slices agree with one slice on large walks")
+		{
+			auto csr = make_csr_graph(make_De_Bruigin_graph(17));
+			auto cycle = bglx::find_one_directed_euler_cycle_hierholzer(csr, 0);
+			auto walk = std::vector<CsrEdge>(cycle.begin(), cycle.end());
+			REQUIRE(verify_euler_circuit(csr, walk, 0, 0, get(boost::edge_index, csr), 4));
+			REQUIRE(verify_euler_circuit(csr, cycle, 0, 0));
+			REQUIRE(verify_euler_circuit_by_endpoints(csr, walk, 0, 0, get(boost::vertex_index, csr), 4));
+			//repeat an edge of the last slice and break continuity in the second one
+			walk[walk.size() - 10] = walk[walk.size() - 20];
+			auto late = verify_euler_circuit(csr, walk, 0, 0, get(boost::edge_index, csr), 4);
+			REQUIRE(late.error == EulerCircuitError::Discontinuous);
+			REQUIRE(late.position == walk.size() - 10);
+			std::swap(walk[walk.size() / 3], walk[walk.size() / 3 + 1]);
+			auto early = verify_euler_circuit(csr, walk, 0, 0, get(boost::edge_index, csr), 4);
+			REQUIRE(early.error == EulerCircuitError::Discontinuous);
+			REQUIRE(early.position == walk.size() / 3);
+		}
+	}
+
+	//in-degree equals out-degree everywhere and one Hierholzer walk covers all edges
+	template <class Graph>
+	void require_eulerian(const Graph& g)
+	{
+		REQUIRE(check_euler_degrees(g).balance == EulerBalance::Circuit);
+		auto cycle = bglx::find_one_directed_euler_cycle_hierholzer(g, 0);
+		auto check = verify_euler_circuit(g, cycle, 0, 0);
+		INFO(check.message());
+		REQUIRE(check);
+	}
+
+	static std::size_t max_out_degree(const CsrGraph& g)
+	{
+		auto degree = std::size_t{ 0 };
+		for (auto v : boost::make_iterator_range(boost::vertices(g)))
+			degree = std::max<std::size_t>(degree, boost::out_degree(v, g));
+		return degree;
+	}
+
+	TEST_CASE("Random Euler graphs")
+	{
+		auto options = RandomEulerOptions{};
+		options.nrVertices = 20000;
+		options.nrEdges = 100000;
+
+		SECTION("Uniform degrees")
+		{
+			auto g = make_random_euler_csr(options);
+			REQUIRE(boost::num_vertices(g) == options.nrVertices);
+			REQUIRE(boost::num_edges(g) == options.nrEdges);
+			require_eulerian(g);
+			REQUIRE(max_out_degree(g) < 30);
+		}
+
+		SECTION("Same seed, same graph on any number of threads")
+		{
+			options.nrEdges = 3 << 20;
+			options.nrThreads = 1;
+			auto g1 = make_random_euler_csr(options);
+			options.nrThreads = 4;
+			auto g4 = make_random_euler_csr(options);
+			REQUIRE(std::equal(g1.arrays().targets, g1.arrays().targets + g1.arrays().nrEdges, g4.arrays().targets));
+			options.seed = 2;
+			auto other = make_random_euler_csr(options);
+			REQUIRE(!std::equal(g1.arrays().targets, g1.arrays().targets + g1.arrays().nrEdges, other.arrays().targets));
+		}
+
+		SECTION("Skewed degrees")
+		{
+			options.distribution = DegreeDistribution::PowerLaw;
+			auto powerLaw = make_random_euler_csr(options);
+			require_eulerian(powerLaw);
+			REQUIRE(max_out_degree(powerLaw) > 500);
+			options.distribution = DegreeDistribution::Hubs;
+			options.hubFraction = 0.0005;
+			auto hubs = make_random_euler_csr(options);
+			require_eulerian(hubs);
+			//half of the 80000 cycle edges start at one of the 10 hubs
+			REQUIRE(max_out_degree(hubs) > 2000);
+		}
+
+		SECTION("Simple graphs split parallel edges")
+		{
+			options.distribution = DegreeDistribution::Hubs;
+			options.hubFraction = 0.0001;
+			options.simple = true;
+			auto csr = make_random_euler_csr(options);
+			auto nrSplit = boost::num_vertices(csr) - options.nrVertices;
+			REQUIRE(nrSplit > 0);
+			REQUIRE(boost::num_edges(csr) == options.nrEdges + nrSplit);
+			auto dag = make_random_euler_dag(options);
+			REQUIRE(boost::num_edges(dag) == boost::num_edges(csr));
+			require_eulerian(dag);
+		}
+
+		SECTION("Edge counts that cannot be Eulerian")
+		{
+			options.nrEdges = options.nrVertices - 1;
+			REQUIRE_THROWS_AS(make_random_euler_csr(options), std::invalid_argument);
+			options.nrEdges = options.nrVertices + 1;
+			REQUIRE_THROWS_AS(make_random_euler_csr(options), std::invalid_argument);
+			options.nrEdges = options.nrVertices;
+			REQUIRE(boost::num_edges(make_random_euler_csr(options)) == options.nrVertices);
+			//one and two vertices only have the Hamiltonian cycle, also with fewer vertices than hubs
+			options.distribution = DegreeDistribution::Hubs;
+			for (std::size_t n : { 1, 2 }) {
+				options.nrVertices = options.nrEdges = n;
+				auto tiny = make_random_euler_csr(options);
+				REQUIRE(boost::num_vertices(tiny) == n);
+				REQUIRE(boost::num_edges(tiny) == n);
+				options.nrEdges = n + 2;
+				REQUIRE_THROWS_AS(make_random_euler_csr(options), std::invalid_argument);
+			}
+		}
+
+		SECTION("Power law exponents close to 1")
+		{
+			options.distribution = DegreeDistribution::PowerLaw;
+			options.powerLawExponent = 1.0;
+			REQUIRE_THROWS_AS(make_random_euler_csr(options), std::invalid_argument);
+			//nearly every draw hits the same vertex, cycles still close
+			options.powerLawExponent = 1.02;
+			options.nrVertices = 1000;
+			options.nrEdges = 3000;
+			auto g = make_random_euler_csr(options);
+			REQUIRE(boost::num_edges(g) == options.nrEdges);
+			require_eulerian(g);
+		}
+	}
+
+	TEST_CASE("Euler finders agree on random graphs")
+	{
+		auto engines = euler_engines();
+
+		SECTION("Every engine finds a valid walk")
+		{
+			auto rng = std::mt19937_64{ 20190601 };
+			for (int i = 0; i < 1000; ++i) {
+				auto c = random_euler_case(rng, 40);
+				for (auto& engine : engines) {
+					auto failure = engine.run(c);
+					if (!failure.empty()) {
+						auto small = shrink_euler_case(c, [&engine](const EulerCase& c) { return !engine.run(c).empty(); });
+						FAIL(engine.name << " failed case " << i << ": " << failure << "\nshrunk: " << describe(small)
+							<< "\nresult: " << engine.run(small));
+					}
+				}
+			}
+		}
+
+		SECTION("Every engine rejects near-Eulerian graphs")
+		{
+			auto rng = std::mt19937_64{ 20190602 };
+			for (int i = 0; i < 400; ++i) {
+				auto c = mutate_euler_case(random_euler_case(rng, 40), static_cast<EulerMutation>(i % 4), rng);
+				REQUIRE(!c.eulerian());
+				for (auto& engine : engines) {
+					auto failure = engine.run(c);
+					if (!failure.empty()) {
+						auto small = shrink_euler_case(c, [&engine](const EulerCase& c) { return !engine.run(c).empty(); });
+						FAIL(engine.name << " failed case " << i << ": " << failure << "\nshrunk: " << describe(small)
+							<< "\nresult: " << engine.run(small));
+					}
+				}
+			}
+		}
+
+		SECTION("Near-Eulerian cases shrink to near-Eulerian ones")
+		{
+			auto rng = std::mt19937_64{ 11 };
+			for (int i = 0; i < 20; ++i) {
+				auto c = mutate_euler_case(random_euler_case(rng, 60), static_cast<EulerMutation>(i % 4), rng);
+				auto small = shrink_euler_case(c, [](const EulerCase&) { return true; });
+				INFO(describe(small));
+				REQUIRE(!small.eulerian());
+				REQUIRE(small.edges.size() <= c.edges.size());
+				REQUIRE(small.start() < small.nrVertices);
+				//every engine still has to reject it
+				for (auto& engine : engines)
+					REQUIRE(engine.run(small).empty());
+			}
+		}
+
+		SECTION("Failing cases shrink to small valid graphs")
+		{
+			//breaks as soon as some vertex has three out-edges, the smallest such graph has six edges
+			auto fails = [](const EulerCase& c) {
+				std::vector<int> degree(c.nrVertices, 0);
+				for (auto [u, v] : c.graph_edges()) {
+					if (++degree[u] == 3)
+						return true;
+				}
+				return false;
+			};
+			auto rng = std::mt19937_64{ 7 };
+			for (int i = 0; i < 20; ++i) {
+				auto c = random_euler_case(rng, 60);
+				if (!fails(c))
+					continue;
+				auto small = shrink_euler_case(c, fails);
+				INFO(describe(small));
+				REQUIRE(fails(small));
+				REQUIRE(small.edges.size() <= c.edges.size());
+				REQUIRE(!small.openEdge);
+				REQUIRE(std::all_of(small.edges.begin(), small.edges.end(),
+					[&](const auto& e) { return e.first < small.nrVertices && e.second < small.nrVertices; }));
+				//still Eulerian: one engine accepts it
+				REQUIRE(engines.front().run(small).empty());
+				//no cycle can go without losing the failure
+				for (std::size_t first = 0; first < small.edges.size(); ++first) {
+					auto cycle = detail::cycle_from(small, first);
+					if (!cycle.empty() && cycle.size() < small.edges.size())
+						REQUIRE(!(detail::is_connected(detail::without_edges(small, cycle)) && fails(detail::without_edges(small, cycle))));
+				}
+			}
+		}
+	}
+
+	TEST_CASE("Instrumented Hierholzer")
+	{
+		SECTION("Counters of a spliced cycle")
+		{
+			//0 <-> 1 <-> 2: the first walk 0 1 0 gets stuck, the splice backs up to 1 and walks 1 2 1
+			auto dag = Dag{ 3 };
+			auto[e01, ok01] = boost::add_edge(0, 1, dag);
+			auto[e10, ok10] = boost::add_edge(1, 0, dag);
+			auto[e12, ok12] = boost::add_edge(1, 2, dag);
+			auto[e21, ok21] = boost::add_edge(2, 1, dag);
+			auto stats = HierholzerStats{};
+			auto cycle = instrumented_euler_cycle(dag, 0, get(boost::vertex_index, dag), stats);
+			auto cycleRight = cycle == std::list<Edge>{ e01, e12, e21, e10 };
+			REQUIRE(cycleRight);
+			REQUIRE(stats.edgesTraversed == 4);
+			REQUIRE(stats.subCircuits == 1);
+			REQUIRE(stats.maxStackDepth == 3);
+			REQUIRE(stats.cursorRescans == 5);
+			REQUIRE(instrumented_euler_cycle(dag, 0) == cycle);
+		}
+
+		SECTION("Graphs without an Euler walk throw")
+		{
+			//0 <-> 1 and 0 -> 2: the walk takes every edge but ends at 2
+			auto unbalanced = Dag{ 3 };
+			boost::add_edge(0, 1, unbalanced);
+			boost::add_edge(1, 0, unbalanced);
+			boost::add_edge(0, 2, unbalanced);
+			REQUIRE_THROWS_AS(instrumented_euler_cycle(unbalanced, 0), std::runtime_error);
+			//0 -> 1 -> 2 and 0 -> 2: the sub-circuit from 0 gets stuck at 2 instead of 0
+			auto stuck = Dag{ 3 };
+			boost::add_edge(0, 1, stuck);
+			boost::add_edge(1, 2, stuck);
+			boost::add_edge(0, 2, stuck);
+			REQUIRE_THROWS_AS(instrumented_euler_trail(stuck, 0, 2), std::runtime_error);
+			//0 <-> 1 and 2 <-> 3: the second cycle is out of reach
+			auto split = Dag{ 4 };
+			boost::add_edge(0, 1, split);
+			boost::add_edge(1, 0, split);
+			boost::add_edge(2, 3, split);
+			boost::add_edge(3, 2, split);
+			REQUIRE_THROWS_AS(instrumented_euler_cycle(split, 0), std::runtime_error);
+		}
+
+		SECTION("Trail with property map")
+		{
+			Dag_VSet dag;
+			auto v0 = boost::add_vertex(dag);
+			auto v1 = boost::add_vertex(dag);
+			auto v2 = boost::add_vertex(dag);
+			auto[e12, ok12] = boost::add_edge(v1, v2, dag);
+			auto[e20, ok20] = boost::add_edge(v2, v0, dag);
+			std::unordered_map<Dag_VSet::vertex_descriptor, size_t> vMap = { {v0, 1}, {v1, 2}, {v2, 0} };
+			auto iMap = boost::associative_property_map<std::unordered_map<Dag_VSet::vertex_descriptor, size_t>>(vMap);
+			auto stats = HierholzerStats{};
+			auto trail = instrumented_euler_trail(dag, v1, v0, iMap, stats);
+			auto trailRight = trail == std::list<Dag_VSet::edge_descriptor>{ e12, e20 };
+			REQUIRE(trailRight);
+			REQUIRE(stats.subCircuits == 0);
+			REQUIRE_THROWS(instrumented_euler_trail(dag, v1, v2, iMap, stats));
+		}
+
+		SECTION("De Bruigin cycle with counters")
+		{
+			auto dag = make_De_Bruigin_graph(16);
+			auto start_v = *boost::vertices(dag).first;
+			auto stats = HierholzerStats{};
+			auto cycle = instrumented_euler_cycle(dag, start_v, get(boost::vertex_index, dag), stats);
+			REQUIRE(verify_euler_circuit(dag, cycle, start_v, start_v));
+			REQUIRE(stats.edgesTraversed == boost::num_edges(dag));
+			REQUIRE(stats.cursorRescans == boost::num_edges(dag) + 1);
+			REQUIRE(stats.maxStackDepth <= boost::num_edges(dag));
+			std::cout << "Instrumented Hierholzer: " << format_hierholzer_stats(stats) << "\n\n";
+			REQUIRE(bglx::find_one_directed_euler_cycle_hierholzer(dag, start_v).size() == cycle.size());
+		}
+	}
+
+	//same vertices and edges in another adjacency_list type
+	template <class Target, class Source>
+	static Target copy_edges(const Source& g)
+	{
+		auto copy = Target{ boost::num_vertices(g) };
+		for (auto e : boost::make_iterator_range(boost::edges(g)))
+			boost::add_edge(boost::source(e, g), boost::target(e, g), copy);
+		return copy;
+	}
+
+	TEST_CASE("Euler degree balance")
+	{
+		static_assert(is_bidirectional_graph_v<BidirectionalDag>);
+		static_assert(!is_bidirectional_graph_v<Dag>);
+		static_assert(!is_bidirectional_graph_v<CsrGraph>);
+
+		auto options = RandomEulerOptions{};
+		options.nrVertices = 2000;
+		options.nrEdges = 10000;
+		auto dag = make_random_euler_dag(options);
+		auto bidirectional = copy_edges<BidirectionalDag>(dag);
+		auto requireBoth = [&](EulerBalance balance, Vertex start, Vertex last) {
+			auto directed = check_euler_degrees(dag);
+			auto fast = check_euler_degrees(bidirectional);
+			REQUIRE(directed.balance == balance);
+			REQUIRE(fast.balance == balance);
+			REQUIRE(directed.start == start);
+			REQUIRE(fast.start == start);
+			REQUIRE(directed.last == last);
+			REQUIRE(fast.last == last);
+		};
+		REQUIRE(in_degrees(dag) == in_degrees(bidirectional));
+		REQUIRE(in_degrees(dag) == in_degrees(make_csr_graph(dag)));
+
+		SECTION("Circuit")
+		{
+			requireBoth(EulerBalance::Circuit, 0, 0);
+			auto empty = check_euler_degrees(Dag{ 3 });
+			REQUIRE(empty.balance == EulerBalance::Circuit);
+			REQUIRE(empty.start == boost::graph_traits<Dag>::null_vertex());
+		}
+
+		SECTION("Trail endpoints")
+		{
+			//without u -> v the walk has to start at v and end at u
+			auto [u, v] = std::pair{ Vertex{ 7 }, *boost::adjacent_vertices(7, dag).first };
+			boost::remove_edge(u, v, dag);
+			boost::remove_edge(u, v, bidirectional);
+			requireBoth(EulerBalance::Trail, v, u);
+			auto trail = bglx::find_one_directed_euler_trail_hierholzer(dag, v, u);
+			REQUIRE(verify_euler_circuit(dag, trail, v, u));
+		}
+
+		SECTION("Unbalanced")
+		{
+			for (Vertex u : { 3, 9 }) {
+				auto v = *boost::adjacent_vertices(u, dag).first;
+				boost::remove_edge(u, v, dag);
+				boost::remove_edge(u, v, bidirectional);
+			}
+			auto none = boost::graph_traits<Dag>::null_vertex();
+			requireBoth(EulerBalance::None, none, none);
+		}
+	}
+
+	template <class Graph>
+	static void run_degree_benchmark(const CsrGraph& csr, const std::string& name)
+	{
+		auto g = std::optional<Graph>{};
+		{
+			AutoProfiler timer{ name + " build", ProfileWallTime, csr.nr_edges() };
+			g.emplace(boost::num_vertices(csr));
+			for (auto e : boost::make_iterator_range(boost::edges(csr)))
+				boost::add_edge(boost::source(e, csr), boost::target(e, csr), *g);
+		}
+		{
+			AutoProfiler timer{ name + " check_euler_degrees", ProfileWallTime, csr.nr_edges() };
+			REQUIRE(check_euler_degrees(*g).balance == EulerBalance::Circuit);
+		}
+		{
+			AutoProfiler timer{ name + " in_degrees", ProfileWallTime, csr.nr_edges() };
+			REQUIRE(in_degrees(*g).size() == csr.nr_vertices());
+		}
+		AutoProfiler timer{ name + " destroy", ProfileWallTime, csr.nr_edges() };
+		g.reset();
+	}
+
+	//run explicitly with: BGLTest "[benchmark]"
+	TEST_CASE("Euler degree balance bidirectionalS vs directedS", "[.][benchmark]")
+	{
+		auto options = RandomEulerOptions{};
+		options.nrVertices = 1 << 20;
+		options.nrEdges = 8 << 20;
+		options.simple = true;
+		auto csr = make_random_euler_csr(options);
+		run_degree_benchmark<Dag>(csr, "setS directedS");
+		run_degree_benchmark<BidirectionalDag>(csr, "setS bidirectionalS");
+		run_degree_benchmark<boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS>>(csr, "vecS directedS");
+		run_degree_benchmark<boost::adjacency_list<boost::vecS, boost::vecS, boost::bidirectionalS>>(csr, "vecS bidirectionalS");
+	}
+
+	using EdgePairs = std::vector<std::pair<std::uint32_t, std::uint32_t>>;
+
+	//uniform random edges; with about as many edges as vertices there are many small strong
+	//components next to a large one
+	static EdgePairs random_edge_pairs(std::size_t nrVertices, std::size_t nrEdges, std::uint64_t seed)
+	{
+		auto rng = std::mt19937_64{ seed };
+		auto vertex = std::uniform_int_distribution<std::uint32_t>{ 0, static_cast<std::uint32_t>(nrVertices - 1) };
+		EdgePairs edges(nrEdges);
+		for (auto& [u, v] : edges)
+			u = vertex(rng), v = vertex(rng);
+		return edges;
+	}
+
+	//boost's component numbers renumbered in the order of their smallest vertex, as in ComponentLabels
+	static std::vector<std::uint32_t> by_first_vertex(const std::vector<int>& component)
+	{
+		std::vector<std::uint32_t> result(component.size());
+		std::vector<std::uint32_t> number(component.size(), ComponentLabels::NoComponent);
+		auto nrComponents = std::uint32_t{ 0 };
+		for (std::size_t v = 0; v < component.size(); ++v) {
+			auto& id = number[component[v]];
+			if (id == ComponentLabels::NoComponent)
+				id = nrComponents++;
+			result[v] = id;
+		}
+		return result;
+	}
+
+	TEST_CASE("Connected components")
+	{
+		struct Case
+		{
+			std::size_t nrVertices;
+			std::size_t nrEdges;
+		};
+
+		SECTION("Strong components match boost::strong_components")
+		{
+			auto seed = std::uint64_t{ 0 };
+			for (auto c : { Case{ 1000, 900 }, Case{ 1000, 1200 }, Case{ 5000, 20000 }, Case{ 100000, 120000 } }) {
+				auto csr = make_csr_graph(c.nrVertices, random_edge_pairs(c.nrVertices, c.nrEdges, ++seed));
+				auto dag = make_dag(csr);
+				std::vector<int> component(c.nrVertices);
+				auto nrComponents = boost::strong_components(dag, boost::make_iterator_property_map(component.begin(), get(boost::vertex_index, dag)));
+				auto expected = by_first_vertex(component);
+				for (unsigned nrThreads : { 1u, 4u }) {
+					auto labels = strongly_connected_components(csr, nrThreads);
+					REQUIRE(labels.nrComponents == static_cast<std::size_t>(nrComponents));
+					REQUIRE(labels.component == expected);
+				}
+				REQUIRE(strongly_connected_components(dag, 4).component == expected);
+			}
+		}
+
+		SECTION("Weak components match boost::connected_components")
+		{
+			auto seed = std::uint64_t{ 100 };
+			for (auto c : { Case{ 1000, 400 }, Case{ 1000, 600 }, Case{ 100000, 60000 }, Case{ 100000, 200000 } }) {
+				auto edges = random_edge_pairs(c.nrVertices, c.nrEdges, ++seed);
+				auto csr = make_csr_graph(c.nrVertices, edges);
+				auto undirected = boost::adjacency_list<boost::vecS, boost::vecS, boost::undirectedS>{ c.nrVertices };
+				for (auto [u, v] : edges)
+					boost::add_edge(u, v, undirected);
+				std::vector<int> component(c.nrVertices);
+				auto nrComponents = boost::connected_components(undirected, component.data());
+				auto expected = by_first_vertex(component);
+				for (unsigned nrThreads : { 1u, 4u }) {
+					auto labels = weakly_connected_components(csr, nrThreads);
+					REQUIRE(labels.nrComponents == static_cast<std::size_t>(nrComponents));
+					REQUIRE(labels.component == expected);
+				}
+				REQUIRE(weakly_connected_components(make_dag(csr), 4).component == expected);
+			}
+		}
+
+		SECTION("Every vertex of an acyclic graph is a component")
+		{
+			//u -> v only for u < v
+			auto edges = random_edge_pairs(20000, 100000, 7);
+			for (auto& [u, v] : edges) {
+				if (u > v)
+					std::swap(u, v);
+				if (u == v)
+					++v;
+			}
+			auto labels = strongly_connected_components(make_csr_graph(20001, edges), 4);
+			REQUIRE(labels.nrComponents == 20001);
+			for (std::uint32_t v = 0; v < labels.component.size(); ++v)
+				REQUIRE(labels.component[v] == v);
+		}
+
+		SECTION("Million-vertex cycle and chain of small cycles")
+		{
+			constexpr std::uint32_t nrVertices = 1 << 20;
+			EdgePairs cycle;
+			for (std::uint32_t v = 0; v < nrVertices; ++v)
+				cycle.emplace_back(v, (v + 1) % nrVertices);
+			auto labels = strongly_connected_components(make_csr_graph(nrVertices, cycle), 4);
+			REQUIRE(labels.nrComponents == 1);
+
+			//2k <-> 2k + 1 -> 2k + 2: all but one pair are left to Tarjan, one path deep
+			EdgePairs chain;
+			for (std::uint32_t v = 0; v < nrVertices; v += 2) {
+				chain.emplace_back(v, v + 1);
+				chain.emplace_back(v + 1, v);
+				if (v + 2 < nrVertices)
+					chain.emplace_back(v + 1, v + 2);
+			}
+			labels = strongly_connected_components(make_csr_graph(nrVertices, chain), 4);
+			REQUIRE(labels.nrComponents == nrVertices / 2);
+			for (std::uint32_t v = 0; v < nrVertices; ++v)
+				REQUIRE(labels.component[v] == v / 2);
+			REQUIRE(weakly_connected_components(make_csr_graph(nrVertices, chain), 4).nrComponents == 1);
+		}
+
+		SECTION("Euler preconditions")
+		{
+			auto options = RandomEulerOptions{};
+			options.nrVertices = 20000;
+			options.nrEdges = 100000;
+			auto csr = make_random_euler_csr(options);
+			REQUIRE(strongly_connected_components(csr).nrComponents == 1);
+			REQUIRE(check_euler_graph(csr).balance == EulerBalance::Circuit);
+
+			//two copies side by side are balanced but not connected
+			EdgePairs twice;
+			for (auto e : boost::make_iterator_range(boost::edges(csr))) {
+				auto u = static_cast<std::uint32_t>(boost::source(e, csr));
+				auto v = static_cast<std::uint32_t>(boost::target(e, csr));
+				twice.emplace_back(u, v);
+				twice.emplace_back(u + 20000, v + 20000);
+			}
+			auto split = make_csr_graph(40000, twice);
+			REQUIRE(check_euler_degrees(split).balance == EulerBalance::Circuit);
+			REQUIRE(check_euler_graph(split).balance == EulerBalance::None);
+			REQUIRE(weakly_connected_components(split).nrComponents == 2);
+
+			options.nrVertices = 2000;
+			options.nrEdges = 10000;
+			auto dag = make_random_euler_dag(options);
+			auto v = *boost::adjacent_vertices(7, dag).first;
+			boost::remove_edge(7, v, dag);
+			auto trail = check_euler_graph(dag);
+			REQUIRE(trail.balance == EulerBalance::Trail);
+			REQUIRE(trail.start == v);
+			//vertices without edges do not count
+			boost::add_vertex(dag);
+			REQUIRE(check_euler_graph(dag).balance == EulerBalance::Trail);
+		}
+	}
+
+	//run explicitly with: BGLTest "[benchmark]"
+	TEST_CASE("Connected components of large Euler graphs", "[.][benchmark]")
+	{
+		auto options = RandomEulerOptions{};
+		options.nrVertices = 1 << 22;
+		options.nrEdges = 1 << 25;
+		auto csr = make_random_euler_csr(options);
+		{
+			AutoProfiler timer{ "boost::strong_components", ProfileWallTime, csr.nr_edges() };
+			std::vector<std::uint32_t> component(csr.nr_vertices());
+			REQUIRE(boost::strong_components(csr, boost::make_iterator_property_map(component.begin(), get(boost::vertex_index, csr))) == 1);
+		}
+		for (unsigned nrThreads : { 1u, default_thread_count() }) {
+			{
+				AutoProfiler timer{ "strongly_connected_components, threads " + std::to_string(nrThreads), ProfileWallTime, csr.nr_edges() };
+				REQUIRE(strongly_connected_components(csr, nrThreads).nrComponents == 1);
+			}
+			AutoProfiler timer{ "weakly_connected_components, threads " + std::to_string(nrThreads), ProfileWallTime, csr.nr_edges() };
+			REQUIRE(weakly_connected_components(csr, nrThreads).nrComponents == 1);
+		}
+	}
+
+	static std::vector<SimdLevel> supported_simd_levels()
+	{
+		std::vector<SimdLevel> levels{ SimdLevel::Scalar };
+		for (auto level : { SimdLevel::Avx2, SimdLevel::Avx512 }) {
+			if (level <= detected_simd_level())
+				levels.push_back(level);
+		}
+		return levels;
+	}
+
+	TEST_CASE("SIMD degree balance")
+	{
+		auto expectedBalance = [](const CsrGraph& g) {
+			auto in = in_degrees(g);
+			std::vector<std::int32_t> balance(g.nr_vertices());
+			for (std::size_t v = 0; v < balance.size(); ++v)
+				balance[v] = static_cast<std::int32_t>(boost::out_degree(v, g)) - static_cast<std::int32_t>(in[v]);
+			return balance;
+		};
+		auto requireSameCheck = [](const CsrGraph& g) {
+			auto expected = check_euler_degrees(g);
+			for (auto level : supported_simd_levels()) {
+				for (unsigned nrThreads : { 1u, 3u }) {
+					auto check = check_euler_balance(g, { nrThreads, level });
+					REQUIRE(check.balance == expected.balance);
+					REQUIRE(check.start == expected.start);
+					REQUIRE(check.last == expected.last);
+				}
+			}
+			return expected.balance;
+		};
+
+		SECTION("Every kernel matches the degrees")
+		{
+			//odd sizes leave scalar tails; the hubs put the same target into a vector many times. with 4
+			//threads the last two count into partial counters and regroup the targets by vertex range
+			struct Case { std::size_t nrVertices, nrEdges; };
+			auto seed = std::uint64_t{ 0 };
+			for (auto c : { Case{ 1, 5 }, Case{ 17, 33 }, Case{ 1001, 4099 }, Case{ 100003, 300007 }, Case{ 300007, 100003 } }) {
+				auto edges = random_edge_pairs(c.nrVertices, c.nrEdges, ++seed);
+				for (std::size_t i = 0; i < edges.size(); i += 3)
+					edges[i].second = static_cast<std::uint32_t>(i % 7 % c.nrVertices);
+				auto csr = make_csr_graph(c.nrVertices, edges);
+				auto expected = expectedBalance(csr);
+				for (auto level : supported_simd_levels()) {
+					for (unsigned nrThreads : { 1u, 4u })
+						REQUIRE(degree_balance(csr, { nrThreads, level }) == expected);
+				}
+			}
+			REQUIRE(degree_balance(CsrGraph{}).empty());
+		}
+
+		SECTION("Kernels count relative to the range")
+		{
+			//targets past 2^31 are negative as the signed indices of a gather; the counters start at vBegin
+			constexpr std::size_t vBegin = 3000000000u, width = 100;
+			std::vector<std::uint32_t> targets;
+			for (std::uint32_t i = 0; i < 1000; ++i)
+				targets.push_back(static_cast<std::uint32_t>(vBegin - 50 + i * 7 % 200));
+			for (std::uint32_t i = 0; i < 40; ++i)
+				targets.push_back(static_cast<std::uint32_t>(vBegin + 3));
+			std::vector<std::int32_t> expected(width, 0);
+			for (auto t : targets) {
+				if (t >= vBegin && t < vBegin + width)
+					--expected[t - vBegin];
+			}
+			for (auto level : supported_simd_levels()) {
+				auto kernels = detail::balance_kernels(level);
+				std::vector<std::int32_t> counters(width, 0);
+				kernels.subtract_targets(targets.data(), targets.size(), vBegin, vBegin + width, counters.data());
+				REQUIRE(counters == expected);
+				std::vector<std::int32_t> sum(width, 1);
+				kernels.add_counters(counters.data(), width, sum.data());
+				for (std::size_t i = 0; i < width; ++i)
+					REQUIRE(sum[i] == expected[i] + 1);
+			}
+		}
+
+		SECTION("Same result as check_euler_degrees")
+		{
+			auto options = RandomEulerOptions{};
+			options.nrVertices = 50000;
+			options.nrEdges = 200000;
+			options.distribution = DegreeDistribution::Hubs;
+			auto csr = make_random_euler_csr(options);
+			REQUIRE(requireSameCheck(csr) == EulerBalance::Circuit);
+			REQUIRE(requireSameCheck(CsrGraph{}) == EulerBalance::Circuit);
+			REQUIRE(requireSameCheck(make_csr_graph(5, {})) == EulerBalance::Circuit);
+			REQUIRE(requireSameCheck(make_csr_graph(5, { { 3, 4 }, { 4, 3 } })) == EulerBalance::Circuit);
+
+			//dropping edges: one gives a trail, two leave four unbalanced vertices or two off by two
+			EdgePairs edges;
+			for (auto e : boost::make_iterator_range(boost::edges(csr)))
+				edges.emplace_back(static_cast<std::uint32_t>(boost::source(e, csr)), static_cast<std::uint32_t>(boost::target(e, csr)));
+			auto without = [&](std::initializer_list<std::size_t> dropped) {
+				auto kept = edges;
+				for (auto i : dropped)
+					kept[i] = kept.back(), kept.pop_back();
+				return make_csr_graph(csr.nr_vertices(), kept);
+			};
+			REQUIRE(requireSameCheck(without({ 12345 })) == EulerBalance::Trail);
+			REQUIRE(requireSameCheck(without({ 0 })) == EulerBalance::Trail);
+			REQUIRE(requireSameCheck(without({ 12345, 777 })) == EulerBalance::None);
+			auto twice = edges;
+			twice.emplace_back(edges[42]);
+			twice.emplace_back(edges[42]);
+			REQUIRE(requireSameCheck(make_csr_graph(csr.nr_vertices(), twice)) == EulerBalance::None);
+		}
+	}
+
+	//run explicitly with: BGLTest "[benchmark]"
+	TEST_CASE("SIMD degree balance kernels", "[.][benchmark]")
+	{
+		auto options = RandomEulerOptions{};
+		options.nrVertices = 1 << 22;
+		options.nrEdges = 1 << 26;
+		auto csr = make_random_euler_csr(options);
+		{
+			AutoProfiler timer{ "check_euler_degrees", ProfileWallTime, csr.nr_edges() };
+			REQUIRE(check_euler_degrees(csr).balance == EulerBalance::Circuit);
+		}
+		const char* names[] = { "scalar", "avx2", "avx512" };
+		for (auto level : supported_simd_levels()) {
+			for (unsigned nrThreads : { 1u, default_thread_count() }) {
+				AutoProfiler timer{ std::string{ "check_euler_balance " } + names[static_cast<int>(level)] + ", threads " + std::to_string(nrThreads),
+					ProfileWallTime, csr.nr_edges() };
+				REQUIRE(check_euler_balance(csr, { nrThreads, level }).balance == EulerBalance::Circuit);
+			}
+		}
+	}
+
+	//run explicitly with: BGLTest "[benchmark]"
+	TEST_CASE("Euler circuit verifier throughput", "[.][benchmark]")
+	{
+		auto dag = make_De_Bruigin_graph(21);
+		auto csr = make_csr_graph(dag);
+		auto cycle = bglx::find_one_directed_euler_cycle_hierholzer(dag, 0);
+		auto csrCycle = bglx::find_one_directed_euler_cycle_hierholzer(csr, 0);
+		auto csrWalk = std::vector<CsrEdge>(csrCycle.begin(), csrCycle.end());
+		{
+			AutoProfiler timer{ "Dag list by end points", ProfileWallTime, boost::num_edges(dag) };
+			REQUIRE(verify_euler_circuit(dag, cycle, 0, 0));
+		}
+		{
+			AutoProfiler timer{ "CsrGraph list by edge index", ProfileWallTime, boost::num_edges(csr) };
+			REQUIRE(verify_euler_circuit(csr, csrCycle, 0, 0));
+		}
+		for (unsigned nrThreads : { 1u, default_thread_count() }) {
+			AutoProfiler timer{ "CsrGraph vector by edge index, threads " + std::to_string(nrThreads) };
+			REQUIRE(verify_euler_circuit(csr, csrWalk, 0, 0, get(boost::edge_index, csr), nrThreads));
+		}
+	}
+
+	//run explicitly with: BGLTest "[benchmark]"
+	TEST_CASE("Euler pipeline memory per phase", "[.][benchmark]")
+	{
+		constexpr int order = 20;
+		constexpr unsigned metrics = ProfileMemoryRollup | ProfileAllocations;
+		std::optional<Dag> built;
+		{
+			AutoProfiler timer{ "De Bruigin build", metrics };
+			built = make_De_Bruigin_graph(order);
+		}
+		std::optional<IndexedDag> named_dag;
+		{
+			AutoProfiler timer{ "Name index", metrics };
+			named_dag.emplace(std::move(*built));
+			built.reset();
+		}
+		auto& dag = named_dag->graph();
+		auto start_v = *boost::vertices(dag).first;
+		std::list<Edge> cycle;
+		{
+			AutoProfiler timer{ "Euler cycle traversal", metrics, boost::num_edges(dag) };
+			cycle = bglx::find_one_directed_euler_cycle_hierholzer(dag, start_v);
+		}
+		{
+			AutoProfiler timer{ "Euler cycle verification", metrics };
+			REQUIRE(verify_euler_circuit(dag, cycle, start_v, start_v));
+		}
+	}
+}
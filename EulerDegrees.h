@@ -0,0 +1,114 @@
+#pragma once
+#include <boost/graph/graph_traits.hpp>
+#include <boost/graph/properties.hpp>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace bglx::test
+{
+	//graphs that keep in-edges (bidirectionalS adjacency_list and the like) answer in_degree in O(1);
+	//plain directedS graphs only know their out-edges, so in-degrees cost a scan over all edges
+	template <class Graph>
+	constexpr bool is_bidirectional_graph_v = std::is_convertible_v<
+		typename boost::graph_traits<Graph>::traversal_category, boost::bidirectional_graph_tag>;
+
+	//in-degree of every vertex, by vertex index: O(V) with in_degree on bidirectional graphs, one
+	//pass over the edges otherwise
+	template <class Graph, class VertexIndexMap>
+	std::vector<std::size_t> in_degrees(const Graph& g, VertexIndexMap index)
+	{
+		std::vector<std::size_t> degrees(boost::num_vertices(g), 0);
+		if constexpr (is_bidirectional_graph_v<Graph>) {
+			for (auto [v, vEnd] = boost::vertices(g); v != vEnd; ++v)
+				degrees[get(index, *v)] = boost::in_degree(*v, g);
+		}
+		else {
+			for (auto [v, vEnd] = boost::vertices(g); v != vEnd; ++v) {
+				for (auto [e, eEnd] = boost::out_edges(*v, g); e != eEnd; ++e)
+					++degrees[get(index, boost::target(*e, g))];
+			}
+		}
+		return degrees;
+	}
+
+	template <class Graph>
+	std::vector<std::size_t> in_degrees(const Graph& g)
+	{
+		return in_degrees(g, get(boost::vertex_index, g));
+	}
+
+	enum class EulerBalance
+	{
+		//in-degree equals out-degree everywhere
+		Circuit,
+		//one vertex has one more out- than in-edge (the start), one the reverse (the last vertex)
+		Trail,
+		//anything else
+		None
+	};
+
+	//the degree condition for an Euler circuit or trail and where a walk has to start and end. whether
+	//all edges are connected is not checked. start and last are null_vertex() when there are no edges
+	//or no walk.
+	template <class Graph>
+	struct EulerDegreeCheck
+	{
+		using vertex_descriptor = typename boost::graph_traits<Graph>::vertex_descriptor;
+
+		EulerBalance balance = EulerBalance::None;
+		vertex_descriptor start = boost::graph_traits<Graph>::null_vertex();
+		vertex_descriptor last = boost::graph_traits<Graph>::null_vertex();
+	};
+
+	//checks in O(V) on bidirectional graphs, where every vertex compares in_degree with out_degree,
+	//and with one extra pass over the edges (balances by vertex index) otherwise
+	template <class Graph, class VertexIndexMap>
+	EulerDegreeCheck<Graph> check_euler_degrees(const Graph& g, VertexIndexMap index)
+	{
+		auto result = EulerDegreeCheck<Graph>{};
+		std::vector<std::int64_t> balance;
+		if constexpr (!is_bidirectional_graph_v<Graph>) {
+			balance.assign(boost::num_vertices(g), 0);
+			for (auto [v, vEnd] = boost::vertices(g); v != vEnd; ++v) {
+				for (auto [e, eEnd] = boost::out_edges(*v, g); e != eEnd; ++e)
+					--balance[get(index, boost::target(*e, g))];
+			}
+		}
+		auto nrUnbalanced = 0;
+		auto firstWithEdges = boost::graph_traits<Graph>::null_vertex();
+		for (auto [v, vEnd] = boost::vertices(g); v != vEnd; ++v) {
+			auto outDegree = static_cast<std::int64_t>(boost::out_degree(*v, g));
+			std::int64_t surplus;
+			if constexpr (is_bidirectional_graph_v<Graph>)
+				surplus = outDegree - static_cast<std::int64_t>(boost::in_degree(*v, g));
+			else
+				surplus = outDegree + balance[get(index, *v)];
+			if (outDegree != 0 && firstWithEdges == boost::graph_traits<Graph>::null_vertex())
+				firstWithEdges = *v;
+			if (surplus == 0)
+				continue;
+			if (++nrUnbalanced > 2 || (surplus != 1 && surplus != -1))
+				return {};
+			(surplus == 1 ? result.start : result.last) = *v;
+		}
+		if (nrUnbalanced == 0) {
+			result.balance = EulerBalance::Circuit;
+			result.start = result.last = firstWithEdges;
+		}
+		else if (result.start != boost::graph_traits<Graph>::null_vertex()
+			&& result.last != boost::graph_traits<Graph>::null_vertex()) {
+			result.balance = EulerBalance::Trail;
+		}
+		else {
+			return {};
+		}
+		return result;
+	}
+
+	template <class Graph>
+	EulerDegreeCheck<Graph> check_euler_degrees(const Graph& g)
+	{
+		return check_euler_degrees(g, get(boost::vertex_index, g));
+	}
+}
@@ -0,0 +1,421 @@
+#pragma once
+#include "NamedDag.h"
+#include "CsrGraph.h"
+#include "EulerVerify.h"
+#include "HierholzerStats.h"
+#include "RandomEulerGraph.h"
+#include <BoostGraphX/euler_graph.h>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace bglx::test
+{
+	//one case for the differential Euler tests: a balanced, connected edge list over vertices
+	//0..nrVertices-1 without parallel edges or self-loops, so that setS graphs hold it unchanged.
+	//with an open edge the case is the Euler trail of the graph without that edge, which runs from the
+	//target of the open edge to its source.
+	//the mutations of mutate_euler_case turn it into a near-Eulerian case without such a walk, which
+	//every engine has to reject: one of the edges reversed, extra edges after the Eulerian ones or a
+	//start vertex the walk cannot start from.
+	struct EulerCase
+	{
+		std::size_t nrVertices = 0;
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> edges;
+		std::optional<std::size_t> openEdge;
+		std::optional<std::size_t> reversedEdge;
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> extraEdges;
+		std::optional<std::uint32_t> wrongStart;
+
+		bool eulerian() const { return !reversedEdge && extraEdges.empty() && !wrongStart; }
+		std::uint32_t start() const
+		{
+			if (wrongStart)
+				return *wrongStart;
+			return openEdge ? edges[*openEdge].second : edges.front().first;
+		}
+		std::uint32_t last() const { return openEdge ? edges[*openEdge].first : start(); }
+
+		//edges of the graph handed to the engines, in insertion order
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> graph_edges() const
+		{
+			auto result = edges;
+			if (reversedEdge)
+				std::swap(result[*reversedEdge].first, result[*reversedEdge].second);
+			if (openEdge)
+				result.erase(result.begin() + *openEdge);
+			result.insert(result.end(), extraEdges.begin(), extraEdges.end());
+			return result;
+		}
+	};
+
+	static std::string describe(const EulerCase& c)
+	{
+		std::ostringstream text;
+		text << c.nrVertices << " vertices, " << (c.openEdge ? "trail" : "cycle") << " from " << c.start()
+			<< " to " << c.last();
+		if (c.reversedEdge)
+			text << ", reversed " << c.edges[*c.reversedEdge].second << "->" << c.edges[*c.reversedEdge].first;
+		if (!c.extraEdges.empty())
+			text << ", " << c.extraEdges.size() << " extra edges";
+		if (c.wrongStart)
+			text << ", wrong start";
+		text << ":";
+		for (auto [u, v] : c.graph_edges())
+			text << " " << u << "->" << v;
+		return text.str();
+	}
+
+	//an Euler finder on one graph type. run returns an empty string when the engine gets the case right,
+	//else what went wrong: an Eulerian case needs a walk that verifies, a near-Eulerian one an empty walk
+	//or an exception
+	struct EulerEngine
+	{
+		std::string name;
+		std::function<std::string(const EulerCase&)> run;
+	};
+
+	namespace detail
+	{
+		template <class Graph>
+		Graph make_case_graph(const EulerCase& c)
+		{
+			auto g = Graph{ c.nrVertices };
+			for (auto [u, v] : c.graph_edges())
+				boost::add_edge(u, v, g);
+			return g;
+		}
+
+		template <>
+		inline FlatDag make_case_graph<FlatDag>(const EulerCase& c)
+		{
+			auto g = FlatDag{ c.nrVertices };
+			auto loader = BulkEdgeLoader<FlatDag>{ g };
+			for (auto [u, v] : c.graph_edges())
+				loader.add_edge(u, v);
+			loader.freeze();
+			return g;
+		}
+
+		template <>
+		inline CsrGraph make_case_graph<CsrGraph>(const EulerCase& c)
+		{
+			return make_csr_graph(c.nrVertices, c.graph_edges());
+		}
+
+		static std::string verdict(const EulerCircuitCheck& check) { return check ? std::string{} : check.message(); }
+
+		//runs find on a graph built from the case and verifies its walk; exceptions count as failures,
+		//unless the case has no walk to find
+		template <class Find, class Verify>
+		std::string run_engine(const EulerCase& c, Find find, Verify verify)
+		{
+			try {
+				auto walk = find();
+				if (c.eulerian())
+					return verify(walk);
+				if (walk.empty())
+					return {};
+				return "returned a walk of " + std::to_string(walk.size()) + " edges on a graph without one";
+			}
+			catch (const std::exception& e) {
+				return c.eulerian() ? std::string{ "threw: " } + e.what() : std::string{};
+			}
+		}
+
+		//the library finders and the instrumented reference on a graph with a vertex index
+		template <class Graph>
+		void add_indexed_engines(std::vector<EulerEngine>& engines, const std::string& container, bool withReference)
+		{
+			auto verify = [](const Graph& g, const EulerCase& c) {
+				return [&g, &c](const auto& walk) { return verdict(verify_euler_circuit(g, walk, c.start(), c.last())); };
+			};
+			engines.push_back({ "hierholzer/" + container, [verify](const EulerCase& c) {
+				auto g = make_case_graph<Graph>(c);
+				return run_engine(c, [&] {
+					return c.openEdge ? bglx::find_one_directed_euler_trail_hierholzer(g, c.start(), c.last())
+						: bglx::find_one_directed_euler_cycle_hierholzer(g, c.start());
+				}, verify(g, c));
+			} });
+			engines.push_back({ "hierholzer_index_map/" + container, [verify](const EulerCase& c) {
+				auto g = make_case_graph<Graph>(c);
+				auto index = get(boost::vertex_index, g);
+				return run_engine(c, [&] {
+					return c.openEdge ? bglx::find_one_directed_euler_trail_hierholzer(g, c.start(), c.last(), index)
+						: bglx::find_one_directed_euler_cycle_hierholzer(g, c.start(), index);
+				}, verify(g, c));
+			} });
+			if (withReference) {
+				engines.push_back({ "instrumented/" + container, [verify](const EulerCase& c) {
+					auto g = make_case_graph<Graph>(c);
+					auto stats = HierholzerStats{};
+					auto index = get(boost::vertex_index, g);
+					return run_engine(c, [&] {
+						return c.openEdge ? instrumented_euler_trail(g, c.start(), c.last(), index, stats)
+							: instrumented_euler_cycle(g, c.start(), index, stats);
+					}, verify(g, c));
+				} });
+			}
+		}
+	}
+
+	//every engine the differential tests compare; new finders register here
+	static std::vector<EulerEngine> euler_engines()
+	{
+		std::vector<EulerEngine> engines;
+		detail::add_indexed_engines<Dag>(engines, "Dag", true);
+		detail::add_indexed_engines<FlatDag>(engines, "FlatDag", false);
+		detail::add_indexed_engines<boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS>>(engines, "VecDag", false);
+		detail::add_indexed_engines<boost::adjacency_list<boost::listS, boost::vecS, boost::directedS>>(engines, "ListDag", false);
+		detail::add_indexed_engines<CsrGraph>(engines, "CsrGraph", true);
+
+		//setS vertices only work through a property map
+		engines.push_back({ "hierholzer_index_map/Dag_VSet", [](const EulerCase& c) {
+			auto g = Dag_VSet{};
+			std::vector<Dag_VSet::vertex_descriptor> vertices(c.nrVertices);
+			std::unordered_map<Dag_VSet::vertex_descriptor, std::size_t> indices;
+			for (auto& v : vertices) {
+				v = boost::add_vertex(g);
+				indices.emplace(v, indices.size());
+			}
+			for (auto [u, v] : c.graph_edges())
+				boost::add_edge(vertices[u], vertices[v], g);
+			auto index = boost::associative_property_map<decltype(indices)>(indices);
+			auto start = vertices[c.start()];
+			auto last = vertices[c.last()];
+			return detail::run_engine(c, [&] {
+				return c.openEdge ? bglx::find_one_directed_euler_trail_hierholzer(g, start, last, index)
+					: bglx::find_one_directed_euler_cycle_hierholzer(g, start, index);
+			}, [&](const auto& walk) {
+				return detail::verdict(verify_euler_circuit_by_endpoints(g, walk, start, last, index));
+			});
+		} });
+		return engines;
+	}
+
+	//a random Eulerian case of 3..maxVertices vertices (a few more after splitting parallel edges) with
+	//a random degree distribution and edge order; every second case is opened into a trail
+	template <class Rng>
+	EulerCase random_euler_case(Rng& rng, std::size_t maxVertices)
+	{
+		auto options = RandomEulerOptions{};
+		options.nrVertices = std::uniform_int_distribution<std::size_t>{ 3, std::max<std::size_t>(maxVertices, 3) }(rng);
+		options.nrEdges = std::uniform_int_distribution<std::size_t>{ options.nrVertices, 4 * options.nrVertices }(rng);
+		if (options.nrEdges == options.nrVertices + 1)
+			++options.nrEdges;
+		options.distribution = static_cast<DegreeDistribution>(std::uniform_int_distribution<int>{ 0, 2 }(rng));
+		options.hubFraction = 0.1;
+		options.maxCycleLength = std::uniform_int_distribution<std::size_t>{ 2, 8 }(rng);
+		options.seed = rng();
+		options.nrThreads = 1;
+		options.simple = true;
+		auto g = make_random_euler_csr(options);
+
+		auto c = EulerCase{};
+		c.nrVertices = boost::num_vertices(g);
+		for (auto e : boost::make_iterator_range(boost::edges(g)))
+			c.edges.emplace_back(static_cast<std::uint32_t>(e.source), static_cast<std::uint32_t>(boost::target(e, g)));
+		std::shuffle(c.edges.begin(), c.edges.end(), rng);
+		if (rng() % 2 == 0)
+			c.openEdge = std::uniform_int_distribution<std::size_t>{ 0, c.edges.size() - 1 }(rng);
+		return c;
+	}
+
+	enum class EulerMutation
+	{
+		//an edge whose reverse is not in the graph points the other way, two vertices are off by two
+		ReversedEdge,
+		//one more edge that is not in the graph yet, to a new vertex when there is no free pair
+		ExtraEdge,
+		//a 3-cycle on three new vertices, balanced but out of reach
+		DisconnectedCycle,
+		//a cycle asked from a new isolated vertex, a trail from any other vertex than its start
+		WrongStart
+	};
+
+	//a near-Eulerian copy of the Eulerian case c. edges keeps the Eulerian graph, so the mutation
+	//survives shrinking; a case without a free reversal gets an extra edge instead
+	template <class Rng>
+	EulerCase mutate_euler_case(EulerCase c, EulerMutation mutation, Rng& rng)
+	{
+		auto pick = [&rng](std::size_t n) { return std::uniform_int_distribution<std::size_t>{ 0, n - 1 }(rng); };
+		auto present = std::set<std::pair<std::uint32_t, std::uint32_t>>(c.edges.begin(), c.edges.end());
+		auto newVertex = [&c] { return static_cast<std::uint32_t>(c.nrVertices++); };
+		if (mutation == EulerMutation::ReversedEdge) {
+			std::vector<std::size_t> candidates;
+			for (std::size_t i = 0; i < c.edges.size(); ++i) {
+				if (i != c.openEdge && !present.count({ c.edges[i].second, c.edges[i].first }))
+					candidates.push_back(i);
+			}
+			if (!candidates.empty()) {
+				c.reversedEdge = candidates[pick(candidates.size())];
+				return c;
+			}
+			mutation = EulerMutation::ExtraEdge;
+		}
+		switch (mutation) {
+		case EulerMutation::ExtraEdge: {
+			auto u = static_cast<std::uint32_t>(pick(c.nrVertices));
+			for (int attempt = 0; attempt < 64; ++attempt) {
+				auto v = static_cast<std::uint32_t>(pick(c.nrVertices));
+				if (v != u && !present.count({ u, v })) {
+					c.extraEdges.emplace_back(u, v);
+					return c;
+				}
+			}
+			c.extraEdges.emplace_back(u, newVertex());
+			return c;
+		}
+		case EulerMutation::DisconnectedCycle: {
+			auto a = newVertex();
+			auto b = newVertex();
+			auto d = newVertex();
+			c.extraEdges = { { a, b }, { b, d }, { d, a } };
+			return c;
+		}
+		default: {
+			if (!c.openEdge) {
+				c.wrongStart = newVertex();
+				return c;
+			}
+			auto start = c.start();
+			auto other = static_cast<std::uint32_t>(pick(c.nrVertices - 1));
+			c.wrongStart = other < start ? other : other + 1;
+			return c;
+		}
+		}
+	}
+
+	namespace detail
+	{
+		//all edges (open one included) touch a single weakly connected component
+		static bool is_connected(const EulerCase& c)
+		{
+			std::vector<std::size_t> parent(c.nrVertices);
+			std::iota(parent.begin(), parent.end(), 0);
+			auto find = [&parent](std::size_t v) {
+				while (parent[v] != v)
+					v = parent[v] = parent[parent[v]];
+				return v;
+			};
+			for (auto [u, v] : c.edges)
+				parent[find(u)] = find(v);
+			auto root = find(c.edges.front().first);
+			return std::all_of(c.edges.begin(), c.edges.end(), [&](const auto& e) { return find(e.first) == root; });
+		}
+
+		//edge indices of a closed walk reached by leaving first and always taking the lowest unused
+		//out-edge, without the open and the reversed edge; empty when it runs into a dead end
+		static std::vector<std::size_t> cycle_from(const EulerCase& c, std::size_t first)
+		{
+			std::vector<std::vector<std::size_t>> outEdges(c.nrVertices);
+			for (std::size_t i = 0; i < c.edges.size(); ++i) {
+				if (i != c.openEdge && i != c.reversedEdge)
+					outEdges[c.edges[i].first].push_back(i);
+			}
+			std::vector<std::ptrdiff_t> position(c.nrVertices, -1);
+			std::vector<char> used(c.edges.size(), 0);
+			std::vector<std::size_t> walk{ first };
+			used[first] = 1;
+			position[c.edges[first].first] = 0;
+			auto v = c.edges[first].second;
+			while (position[v] < 0) {
+				position[v] = static_cast<std::ptrdiff_t>(walk.size());
+				auto next = std::find_if(outEdges[v].begin(), outEdges[v].end(), [&used](std::size_t i) { return !used[i]; });
+				if (next == outEdges[v].end())
+					return {};
+				used[*next] = 1;
+				walk.push_back(*next);
+				v = c.edges[*next].second;
+			}
+			return { walk.begin() + position[v], walk.end() };
+		}
+
+		static EulerCase without_edges(const EulerCase& c, std::vector<std::size_t> removed)
+		{
+			std::sort(removed.begin(), removed.end());
+			auto result = EulerCase{};
+			result.nrVertices = c.nrVertices;
+			result.extraEdges = c.extraEdges;
+			result.wrongStart = c.wrongStart;
+			for (std::size_t i = 0; i < c.edges.size(); ++i) {
+				if (std::binary_search(removed.begin(), removed.end(), i))
+					continue;
+				if (i == c.openEdge)
+					result.openEdge = result.edges.size();
+				if (i == c.reversedEdge)
+					result.reversedEdge = result.edges.size();
+				result.edges.push_back(c.edges[i]);
+			}
+			return result;
+		}
+
+		//renumbers the vertices that have edges, and the wrong start, to 0..k-1 in order of first appearance
+		static EulerCase compacted(const EulerCase& c)
+		{
+			std::vector<std::int64_t> ids(c.nrVertices, -1);
+			auto result = c;
+			result.nrVertices = 0;
+			auto id = [&](std::uint32_t v) {
+				if (ids[v] < 0)
+					ids[v] = static_cast<std::int64_t>(result.nrVertices++);
+				return static_cast<std::uint32_t>(ids[v]);
+			};
+			for (auto& [u, v] : result.edges) {
+				u = id(u);
+				v = id(v);
+			}
+			for (auto& [u, v] : result.extraEdges) {
+				u = id(u);
+				v = id(v);
+			}
+			if (result.wrongStart)
+				result.wrongStart = id(*result.wrongStart);
+			return result;
+		}
+	}
+
+	//greedily removes cycles (keeping the open and the reversed edge), closes the trail and renumbers
+	//vertices as long as fails still holds, so a failure is reported on a graph that is small enough to
+	//read. the Eulerian edges stay balanced and connected and the mutation is kept, so an Eulerian case
+	//shrinks to Eulerian ones and a near-Eulerian case to near-Eulerian ones.
+	template <class Fails>
+	EulerCase shrink_euler_case(EulerCase c, Fails fails)
+	{
+		for (auto progress = true; progress;) {
+			progress = false;
+			//a closed trail can start anywhere, the wrong start would become a right one
+			if (c.openEdge && !c.wrongStart) {
+				auto closed = c;
+				closed.openEdge.reset();
+				if (fails(closed)) {
+					c = std::move(closed);
+					progress = true;
+				}
+			}
+			for (std::size_t first = 0; first < c.edges.size() && !progress; ++first) {
+				if (first == c.openEdge || first == c.reversedEdge)
+					continue;
+				auto cycle = detail::cycle_from(c, first);
+				if (cycle.empty() || cycle.size() + (c.openEdge ? 1 : 0) + (c.reversedEdge ? 1 : 0) >= c.edges.size())
+					continue;
+				auto smaller = detail::without_edges(c, cycle);
+				if (detail::is_connected(smaller) && fails(smaller)) {
+					c = std::move(smaller);
+					progress = true;
+				}
+			}
+		}
+		auto small = detail::compacted(c);
+		return fails(small) ? small : c;
+	}
+}
@@ -0,0 +1,235 @@
+#pragma once
+#include "CsrGraph.h"
+#include "Parallel.h"
+#include <boost/graph/graph_traits.hpp>
+#include <boost/graph/properties.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace bglx::test
+{
+	enum class EulerCircuitError
+	{
+		None,
+		WrongStart,
+		Discontinuous,
+		EdgeRepeated,
+		EdgeNotInGraph,
+		WrongEnd,
+		EdgeMissing
+	};
+
+	//outcome of verify_euler_circuit. position is the index in the walk of the first offending edge,
+	//or the walk length when edges are missing at the end.
+	struct EulerCircuitCheck
+	{
+		EulerCircuitError error = EulerCircuitError::None;
+		std::size_t position = 0;
+
+		explicit operator bool() const { return error == EulerCircuitError::None; }
+
+		std::string message() const
+		{
+			auto at = std::to_string(position);
+			switch (error) {
+			case EulerCircuitError::None: return "Valid Euler walk.";
+			case EulerCircuitError::WrongStart: return "The walk does not start from the starting vertex.";
+			case EulerCircuitError::Discontinuous: return "Edge " + at + " does not start where the previous edge ends.";
+			case EulerCircuitError::EdgeRepeated: return "Edge " + at + " was visited before.";
+			case EulerCircuitError::EdgeNotInGraph: return "Edge " + at + " is not an edge of the graph.";
+			case EulerCircuitError::WrongEnd: return "The walk does not end at the last vertex.";
+			case EulerCircuitError::EdgeMissing: return "The walk misses edges of the graph after " + at + " edges.";
+			}
+			return "Unknown error.";
+		}
+	};
+
+	namespace detail
+	{
+		//one bit per edge slot, claimed at most once from any thread
+		class ConcurrentBitset
+		{
+		public:
+			explicit ConcurrentBitset(std::size_t nrBits)
+				: m_words(std::make_unique<std::atomic<std::uint64_t>[]>((nrBits + 63) / 64)) { }
+
+			//true when the bit was clear before
+			bool claim(std::size_t bit)
+			{
+				auto mask = std::uint64_t{ 1 } << (bit % 64);
+				auto& word = m_words[bit / 64];
+				//a plain load first keeps the common (clear) case to one locked instruction per edge
+				return (word.load(std::memory_order_relaxed) & mask) == 0
+					&& (word.fetch_or(mask, std::memory_order_relaxed) & mask) == 0;
+			}
+
+		private:
+			std::unique_ptr<std::atomic<std::uint64_t>[]> m_words;
+		};
+
+		//checks walk positions [first, first + size) and stops at the first problem. prev is the vertex
+		//the chunk has to continue from, claim(e) marks an edge as used and reports a repeat or an error.
+		template <class Graph, class Iterator, class Claim>
+		EulerCircuitCheck check_euler_chunk(const Graph& g, Iterator it, std::size_t first, std::size_t size,
+			typename boost::graph_traits<Graph>::vertex_descriptor prev, Claim& claim)
+		{
+			for (auto position = first; position < first + size; ++position, ++it) {
+				auto e = *it;
+				if (boost::source(e, g) != prev)
+					return { position == 0 ? EulerCircuitError::WrongStart : EulerCircuitError::Discontinuous, position };
+				auto claimed = claim(e);
+				if (claimed != EulerCircuitError::None)
+					return { claimed, position };
+				prev = boost::target(e, g);
+			}
+			return {};
+		}
+
+		//runs check_euler_chunk over nrThreads slices of the walk. slices only know their own first
+		//problem, so a failing walk is checked once more in one slice to find the earliest position.
+		template <class Graph, class Walk, class MakeClaim>
+		EulerCircuitCheck check_euler_walk(const Graph& g, const Walk& walk,
+			typename boost::graph_traits<Graph>::vertex_descriptor start,
+			typename boost::graph_traits<Graph>::vertex_descriptor last, unsigned nrThreads, MakeClaim makeClaim)
+		{
+			using Iterator = typename Walk::const_iterator;
+			auto size = static_cast<std::size_t>(std::distance(walk.begin(), walk.end()));
+			if (size == 0)
+				return boost::num_edges(g) == 0 ? EulerCircuitCheck{} : EulerCircuitCheck{ EulerCircuitError::EdgeMissing, 0 };
+
+			constexpr std::size_t MinChunk = 1 << 16;
+			nrThreads = nrThreads == 0 ? default_thread_count() : nrThreads;
+			auto nrChunks = static_cast<unsigned>(std::clamp<std::size_t>(size / MinChunk, 1, nrThreads));
+			auto run = [&](unsigned nrSlices) {
+				//chunk starts are found by walking the list once when it is not random access
+				std::vector<Iterator> starts;
+				starts.reserve(nrSlices);
+				auto it = walk.begin();
+				auto at = std::size_t{ 0 };
+				for (unsigned chunk = 0; chunk < nrSlices; ++chunk) {
+					auto begin = size * chunk / nrSlices;
+					std::advance(it, begin - at);
+					at = begin;
+					starts.push_back(it);
+				}
+				auto claim = makeClaim();
+				std::vector<EulerCircuitCheck> checks(nrSlices);
+				parallel_chunks(size, nrSlices, [&](unsigned chunk, std::size_t begin, std::size_t end) {
+					auto prev = chunk == 0 ? start : boost::target(*std::prev(starts[chunk]), g);
+					checks[chunk] = check_euler_chunk(g, starts[chunk], begin, end - begin, prev, claim);
+				});
+				for (auto& check : checks) {
+					if (!check)
+						return check;
+				}
+				return EulerCircuitCheck{};
+			};
+
+			auto check = run(nrChunks);
+			if (!check && nrChunks > 1)
+				check = run(1);
+			if (!check)
+				return check;
+			if (boost::target(*std::prev(walk.end()), g) != last)
+				return { EulerCircuitError::WrongEnd, size - 1 };
+			if (size != boost::num_edges(g))
+				return { EulerCircuitError::EdgeMissing, size };
+			return {};
+		}
+	}
+
+	//verifies that walk (a container of edge descriptors, such as the std::list the Hierholzer finders
+	//return) starts at start, is continuous, ends at last and uses every edge exactly once. edges are
+	//told apart by edgeIndex, so this works for multigraphs too. linear time, the walk is cut in
+	//nrThreads slices (0: all cores) that are checked in parallel.
+	template <class Graph, class Walk, class EdgeIndexMap>
+	EulerCircuitCheck verify_euler_circuit(const Graph& g, const Walk& walk,
+		typename boost::graph_traits<Graph>::vertex_descriptor start,
+		typename boost::graph_traits<Graph>::vertex_descriptor last, EdgeIndexMap edgeIndex, unsigned nrThreads = 0)
+	{
+		auto nrEdges = static_cast<std::size_t>(boost::num_edges(g));
+		return detail::check_euler_walk(g, walk, start, last, nrThreads, [&] {
+			return [used = std::make_shared<detail::ConcurrentBitset>(nrEdges), edgeIndex, nrEdges](
+				typename boost::graph_traits<Graph>::edge_descriptor e) {
+				auto index = static_cast<std::size_t>(get(edgeIndex, e));
+				if (index >= nrEdges)
+					return EulerCircuitError::EdgeNotInGraph;
+				return used->claim(index) ? EulerCircuitError::None : EulerCircuitError::EdgeRepeated;
+			};
+		});
+	}
+
+	//same check for graphs without an edge index, such as Dag. an edge is identified by its end points:
+	//the out-edges of every vertex are laid out as sorted target indices and each walk edge claims a free
+	//slot with its target. for parallel edges that only checks how often each (source, target) is used.
+	template <class Graph, class Walk, class VertexIndexMap>
+	EulerCircuitCheck verify_euler_circuit_by_endpoints(const Graph& g, const Walk& walk,
+		typename boost::graph_traits<Graph>::vertex_descriptor start,
+		typename boost::graph_traits<Graph>::vertex_descriptor last, VertexIndexMap vertexIndex, unsigned nrThreads = 0)
+	{
+		using Traits = boost::graph_traits<Graph>;
+		auto nrVertices = static_cast<std::size_t>(boost::num_vertices(g));
+		if (nrVertices > std::numeric_limits<std::uint32_t>::max())
+			throw std::invalid_argument("verify_euler_circuit_by_endpoints supports up to 2^32 - 1 vertices.");
+		nrThreads = nrThreads == 0 ? default_thread_count() : nrThreads;
+
+		std::vector<typename Traits::vertex_descriptor> vertices;
+		vertices.reserve(nrVertices);
+		for (auto [v, vEnd] = boost::vertices(g); v != vEnd; ++v)
+			vertices.push_back(*v);
+		std::vector<std::uint64_t> offsets(nrVertices + 1, 0);
+		for (auto v : vertices)
+			offsets[get(vertexIndex, v) + 1] = boost::out_degree(v, g);
+		for (std::size_t i = 0; i < nrVertices; ++i)
+			offsets[i + 1] += offsets[i];
+		std::vector<std::uint32_t> targets(offsets.back());
+		auto nrSlotThreads = nrVertices < (1 << 16) ? 1u : nrThreads;
+		parallel_for(nrVertices, nrSlotThreads, [&](std::size_t i) {
+			auto row = targets.begin() + offsets[get(vertexIndex, vertices[i])];
+			auto rowBegin = row;
+			for (auto [e, eEnd] = boost::out_edges(vertices[i], g); e != eEnd; ++e)
+				*row++ = static_cast<std::uint32_t>(get(vertexIndex, boost::target(*e, g)));
+			std::sort(rowBegin, row);
+		});
+
+		return detail::check_euler_walk(g, walk, start, last, nrThreads, [&] {
+			return [used = std::make_shared<detail::ConcurrentBitset>(targets.size()), &offsets, &targets, vertexIndex, &g](
+				typename Traits::edge_descriptor e) {
+				auto source = get(vertexIndex, boost::source(e, g));
+				auto target = static_cast<std::uint32_t>(get(vertexIndex, boost::target(e, g)));
+				auto rowEnd = targets.begin() + offsets[source + 1];
+				auto slot = std::lower_bound(targets.begin() + offsets[source], rowEnd, target);
+				if (slot == rowEnd || *slot != target)
+					return EulerCircuitError::EdgeNotInGraph;
+				for (; slot != rowEnd && *slot == target; ++slot) {
+					if (used->claim(static_cast<std::size_t>(slot - targets.begin())))
+						return EulerCircuitError::None;
+				}
+				return EulerCircuitError::EdgeRepeated;
+			};
+		});
+	}
+
+	//Dag and the other vecS graphs: identified by end points, which is exact for their setS out-edges
+	template <class Graph, class Walk>
+	EulerCircuitCheck verify_euler_circuit(const Graph& g, const Walk& walk,
+		typename boost::graph_traits<Graph>::vertex_descriptor start,
+		typename boost::graph_traits<Graph>::vertex_descriptor last)
+	{
+		return verify_euler_circuit_by_endpoints(g, walk, start, last, get(boost::vertex_index, g));
+	}
+
+	template <class Walk>
+	EulerCircuitCheck verify_euler_circuit(const CsrGraph& g, const Walk& walk,
+		std::size_t start, std::size_t last)
+	{
+		return verify_euler_circuit(g, walk, start, last, get(boost::edge_index, g));
+	}
+}
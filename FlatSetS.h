@@ -0,0 +1,66 @@
+#pragma once
+//flat_setS out-edge selector. boost::graph_detail::find() names container_category() qualified,
+//so the flat_set overloads have to be declared before any BGL header, include this file first.
+#ifdef BOOST_GRAPH_DETAIL_CONTAINER_TRAITS_H
+#error "FlatSetS.h has to be included before any BGL header (boost/pending/container_traits.hpp was included first)."
+#endif
+#include <boost/container/flat_set.hpp>
+
+namespace bglx::test
+{
+	//out-edges kept in a sorted vector (boost::container::flat_set): parallel edges are still rejected by
+	//binary search and out-edge iteration is contiguous, but a single insertion is linear in the out-degree
+	struct flat_setS {};
+}
+
+namespace boost::graph_detail
+{
+	struct set_tag;
+	struct unstable_tag;
+
+	template <class Key, class Cmp, class Alloc>
+	set_tag container_category(const boost::container::flat_set<Key, Cmp, Alloc>&);
+
+	template <class Key, class Cmp, class Alloc>
+	unstable_tag iterator_stability(const boost::container::flat_set<Key, Cmp, Alloc>&);
+}
+
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/pending/container_traits.hpp>
+
+namespace boost
+{
+	template <class ValueType>
+	struct container_gen<bglx::test::flat_setS, ValueType>
+	{
+		using type = boost::container::flat_set<ValueType>;
+	};
+
+	template <>
+	struct parallel_edge_traits<bglx::test::flat_setS>
+	{
+		using type = disallow_parallel_edge_tag;
+	};
+
+	namespace graph_detail
+	{
+		template <class Key, class Cmp, class Alloc>
+		set_tag container_category(const boost::container::flat_set<Key, Cmp, Alloc>&)
+		{
+			return set_tag();
+		}
+
+		template <class Key, class Cmp, class Alloc>
+		unstable_tag iterator_stability(const boost::container::flat_set<Key, Cmp, Alloc>&)
+		{
+			return unstable_tag();
+		}
+
+		template <class Key, class Cmp, class Alloc>
+		struct container_traits<boost::container::flat_set<Key, Cmp, Alloc>>
+		{
+			using category = set_tag;
+			using iterator_stability = unstable_tag;
+		};
+	}
+}
@@ -0,0 +1,243 @@
+#pragma once
+#include "BufferedWriter.h"
+#include "CsrGraph.h"
+#include "MappedFile.h"
+#include "NamedDag.h"
+#include <boost/endian/conversion.hpp>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bglx::test
+{
+	//labels the exporters print, empty when a graph carries no names
+	inline std::string_view vertex_label(const Dag& g, Vertex v) { return g[v].name; }
+	inline std::string_view edge_label(const Dag& g, const Edge& e) { return g[e].name; }
+
+	inline std::string_view vertex_label(const CsrGraph& g, std::size_t v)
+	{
+		return g.has_vertex_names() ? g.vertex_name(v) : std::string_view{};
+	}
+
+	inline std::string_view edge_label(const CsrGraph& g, const CsrEdge& e)
+	{
+		return g.has_edge_names() ? g.edge_name(e) : std::string_view{};
+	}
+
+	namespace detail
+	{
+		//copies text, replacing every character in `special` by what escape(c) returns
+		template <class Escape>
+		static void write_escaped(BufferedWriter& out, std::string_view text, const char* special, Escape escape)
+		{
+			for (auto pos = text.find_first_of(special); pos != std::string_view::npos; pos = text.find_first_of(special)) {
+				out.write(text.substr(0, pos));
+				out.write(escape(text[pos]));
+				text.remove_prefix(pos + 1);
+			}
+			out.write(text);
+		}
+
+		static void write_dot_string(BufferedWriter& out, std::string_view text)
+		{
+			out.put('"');
+			write_escaped(out, text, "\"\\\n", [](char c) -> std::string_view {
+				return c == '"' ? "\\\"" : c == '\\' ? "\\\\" : "\\n";
+			});
+			out.put('"');
+		}
+
+		static void write_xml_text(BufferedWriter& out, std::string_view text)
+		{
+			write_escaped(out, text, "&<>\"'", [](char c) -> std::string_view {
+				switch (c) {
+				case '&': return "&amp;";
+				case '<': return "&lt;";
+				case '>': return "&gt;";
+				case '"': return "&quot;";
+				default: return "&apos;";
+				}
+			});
+		}
+	}
+
+	//graphviz digraph, vertices are numbered by their vertex index and labelled with their names
+	template <class Graph>
+	static void write_dot(const Graph& g, BufferedWriter& out)
+	{
+		auto index = get(boost::vertex_index, g);
+		out.write("digraph G {\n");
+		for (auto v : boost::make_iterator_range(boost::vertices(g))) {
+			out.write("  ");
+			out.write_number(get(index, v));
+			if (auto label = vertex_label(g, v); !label.empty()) {
+				out.write(" [label=");
+				detail::write_dot_string(out, label);
+				out.put(']');
+			}
+			out.write(";\n");
+		}
+		for (auto v : boost::make_iterator_range(boost::vertices(g))) {
+			for (auto e : boost::make_iterator_range(boost::out_edges(v, g))) {
+				out.write("  ");
+				out.write_number(get(index, v));
+				out.write(" -> ");
+				out.write_number(get(index, boost::target(e, g)));
+				if (auto label = edge_label(g, e); !label.empty()) {
+					out.write(" [label=");
+					detail::write_dot_string(out, label);
+					out.put(']');
+				}
+				out.write(";\n");
+			}
+		}
+		out.write("}\n");
+	}
+
+	//GraphML with a string `name` attribute on nodes and edges, node ids are n<vertex index>
+	template <class Graph>
+	static void write_graphml(const Graph& g, BufferedWriter& out)
+	{
+		auto index = get(boost::vertex_index, g);
+		out.write(
+			"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+			"<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n"
+			"  <key id=\"vname\" for=\"node\" attr.name=\"name\" attr.type=\"string\"/>\n"
+			"  <key id=\"ename\" for=\"edge\" attr.name=\"name\" attr.type=\"string\"/>\n"
+			"  <graph id=\"G\" edgedefault=\"directed\">\n");
+		for (auto v : boost::make_iterator_range(boost::vertices(g))) {
+			out.write("    <node id=\"n");
+			out.write_number(get(index, v));
+			if (auto label = vertex_label(g, v); !label.empty()) {
+				out.write("\"><data key=\"vname\">");
+				detail::write_xml_text(out, label);
+				out.write("</data></node>\n");
+			}
+			else {
+				out.write("\"/>\n");
+			}
+		}
+		for (auto v : boost::make_iterator_range(boost::vertices(g))) {
+			for (auto e : boost::make_iterator_range(boost::out_edges(v, g))) {
+				out.write("    <edge source=\"n");
+				out.write_number(get(index, v));
+				out.write("\" target=\"n");
+				out.write_number(get(index, boost::target(e, g)));
+				if (auto label = edge_label(g, e); !label.empty()) {
+					out.write("\"><data key=\"ename\">");
+					detail::write_xml_text(out, label);
+					out.write("</data></edge>\n");
+				}
+				else {
+					out.write("\"/>\n");
+				}
+			}
+		}
+		out.write("  </graph>\n</graphml>\n");
+	}
+
+	//binary edge list: 32 byte header (magic "BGLXEDGE", u32 version, u32 reserved, u64 vertices, u64 edges)
+	//followed by one little-endian (u32 source, u32 target) pair per edge in out-edge order. no names.
+	constexpr char BinaryEdgeListMagic[8] = { 'B', 'G', 'L', 'X', 'E', 'D', 'G', 'E' };
+	constexpr std::uint32_t BinaryEdgeListVersion = 1;
+
+	template <class Graph>
+	static void write_binary_edge_list(const Graph& g, BufferedWriter& out)
+	{
+		using boost::endian::native_to_little;
+		auto index = get(boost::vertex_index, g);
+		auto nrVertices = static_cast<std::uint64_t>(boost::num_vertices(g));
+		if (nrVertices > 0xFFFFFFFFull)
+			throw std::invalid_argument("Binary edge lists store 32 bit vertex ids.");
+		out.write_bytes(BinaryEdgeListMagic, sizeof(BinaryEdgeListMagic));
+		std::uint32_t version[2] = { native_to_little(BinaryEdgeListVersion), 0 };
+		out.write_bytes(version, sizeof(version));
+		std::uint64_t counts[2] = { native_to_little(nrVertices),
+			native_to_little(static_cast<std::uint64_t>(boost::num_edges(g))) };
+		out.write_bytes(counts, sizeof(counts));
+		for (auto v : boost::make_iterator_range(boost::vertices(g))) {
+			auto source = native_to_little(static_cast<std::uint32_t>(get(index, v)));
+			for (auto e : boost::make_iterator_range(boost::out_edges(v, g))) {
+				std::uint32_t pair[2] = { source,
+					native_to_little(static_cast<std::uint32_t>(get(index, boost::target(e, g)))) };
+				out.write_bytes(pair, sizeof(pair));
+			}
+		}
+	}
+
+	//reads a binary edge list back into an unnamed CsrGraph; rows keep the order the edges were written in
+	static CsrGraph load_binary_edge_list(const std::string& path)
+	{
+		using boost::endian::little_to_native;
+		auto file = MappedFile{ path };
+		auto fail = [&path](const char* what) { throw std::runtime_error(path + ": " + what); };
+		constexpr std::size_t HeaderSize = 32;
+		if (file.size() < HeaderSize || std::memcmp(file.data(), BinaryEdgeListMagic, sizeof(BinaryEdgeListMagic)) != 0)
+			fail("not a binary edge list.");
+		std::uint32_t version;
+		std::memcpy(&version, file.data() + 8, sizeof(version));
+		if (little_to_native(version) != BinaryEdgeListVersion)
+			fail("unsupported binary edge list version.");
+		std::uint64_t counts[2];
+		std::memcpy(counts, file.data() + 16, sizeof(counts));
+		auto nrVertices = little_to_native(counts[0]);
+		auto nrEdges = little_to_native(counts[1]);
+		if (nrVertices > 0xFFFFFFFFull || nrEdges != (file.size() - HeaderSize) / 8 || (file.size() - HeaderSize) % 8 != 0)
+			fail("edge count does not match the file size.");
+
+		auto pairs = file.data() + HeaderSize;
+		auto pair = [pairs](std::size_t i, int k) {
+			std::uint32_t value;
+			std::memcpy(&value, pairs + 8 * i + 4 * k, sizeof(value));
+			return little_to_native(value);
+		};
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> edges;
+		edges.reserve(static_cast<std::size_t>(nrEdges));
+		for (std::size_t i = 0; i < nrEdges; ++i) {
+			if (pair(i, 0) >= nrVertices || pair(i, 1) >= nrVertices)
+				fail("vertex id out of range.");
+			edges.emplace_back(pair(i, 0), pair(i, 1));
+		}
+		return make_csr_graph(static_cast<std::size_t>(nrVertices), edges);
+	}
+
+	//one line of edge labels, each followed by " -> ", as the Euler tests print their paths
+	template <class Graph, class EdgeRange>
+	static void write_euler_path(const Graph& g, const EdgeRange& path, BufferedWriter& out)
+	{
+		for (auto& e : path) {
+			out.write(edge_label(g, e));
+			out.write(" -> ");
+		}
+		out.put('\n');
+	}
+
+	//convenience overloads writing a whole file
+	template <class Graph>
+	static void write_dot(const Graph& g, const std::string& path)
+	{
+		auto out = BufferedWriter{ path };
+		write_dot(g, out);
+		out.close();
+	}
+
+	template <class Graph>
+	static void write_graphml(const Graph& g, const std::string& path)
+	{
+		auto out = BufferedWriter{ path };
+		write_graphml(g, out);
+		out.close();
+	}
+
+	template <class Graph>
+	static void write_binary_edge_list(const Graph& g, const std::string& path)
+	{
+		auto out = BufferedWriter{ path };
+		write_binary_edge_list(g, out);
+		out.close();
+	}
+}
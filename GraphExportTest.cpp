@@ -0,0 +1,169 @@
+#define _SILENCE_CXX17_ITERATOR_BASE_CLASS_DEPRECATION_WARNING
+#include "GraphExport.h"
+#include <BoostGraphX/euler_graph.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <sstream>
+#include <catch.hpp>
+#include "Make_De_Bruijn_Euler_Digraph.h"
+#include "Timer.h"
+
+namespace bglx::test {
+	static std::string export_temp_file(const std::string& name)
+	{
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	static std::string read_file(const std::string& path)
+	{
+		auto in = std::ifstream(path, std::ios::binary);
+		std::ostringstream text;
+		text << in.rdbuf();
+		return text.str();
+	}
+
+	static Dag make_labelled_triangle()
+	{
+		auto dag = Dag{ 3 };
+		dag[0].name = "a \"quoted\"";
+		dag[1].name = "b<&>";
+		dag[2].name = "";
+		boost::add_edge(0, 1, EdgeProperty{ "x'y" }, dag);
+		boost::add_edge(1, 2, dag);
+		boost::add_edge(2, 0, EdgeProperty{ "back\\slash" }, dag);
+		return dag;
+	}
+
+	TEST_CASE("Graph export")
+	{
+		SECTION("Buffered writer flushes full buffers and writes large chunks through")
+		{
+			auto path = export_temp_file("bglx_writer.txt");
+			auto expected = std::string{};
+			{
+				auto out = BufferedWriter{ path, 16 };
+				for (int i = 0; i < 100; ++i) {
+					out.write_number(i * 1234567);
+					out.put(' ');
+					expected += std::to_string(i * 1234567) + ' ';
+				}
+				auto large = std::string(40, 'z');
+				out.write(large);
+				out.write_number(-42);
+				out.write_number(std::uint64_t{ 18446744073709551615ull });
+				expected += large + "-4218446744073709551615";
+				REQUIRE(out.bytes_written() == expected.size());
+				out.close();
+			}
+			REQUIRE(read_file(path) == expected);
+			std::filesystem::remove(path);
+		}
+
+		SECTION("DOT escapes labels")
+		{
+			auto path = export_temp_file("bglx_export.dot");
+			write_dot(make_labelled_triangle(), path);
+			REQUIRE(read_file(path) ==
+				"digraph G {\n"
+				"  0 [label=\"a \\\"quoted\\\"\"];\n"
+				"  1 [label=\"b<&>\"];\n"
+				"  2;\n"
+				"  0 -> 1 [label=\"x'y\"];\n"
+				"  1 -> 2;\n"
+				"  2 -> 0 [label=\"back\\\\slash\"];\n"
+				"}\n");
+			std::filesystem::remove(path);
+		}
+
+		SECTION("GraphML escapes labels")
+		{
+			auto path = export_temp_file("bglx_export.graphml");
+			write_graphml(make_labelled_triangle(), path);
+			auto text = read_file(path);
+			REQUIRE(text.find("<node id=\"n0\"><data key=\"vname\">a &quot;quoted&quot;</data></node>\n") != std::string::npos);
+			REQUIRE(text.find("<node id=\"n1\"><data key=\"vname\">b&lt;&amp;&gt;</data></node>\n") != std::string::npos);
+			REQUIRE(text.find("<node id=\"n2\"/>\n") != std::string::npos);
+			REQUIRE(text.find("<edge source=\"n0\" target=\"n1\"><data key=\"ename\">x&apos;y</data></edge>\n") != std::string::npos);
+			REQUIRE(text.find("<edge source=\"n1\" target=\"n2\"/>\n") != std::string::npos);
+			REQUIRE(text.substr(text.size() - 22) == "  </graph>\n</graphml>\n");
+			std::filesystem::remove(path);
+		}
+
+		SECTION("Binary edge list round trip")
+		{
+			auto dag = make_De_Bruigin_graph(6);
+			auto path = export_temp_file("bglx_export.edges");
+			write_binary_edge_list(dag, path);
+			REQUIRE(std::filesystem::file_size(path) == 32 + 8 * boost::num_edges(dag));
+			auto csr = load_binary_edge_list(path);
+			REQUIRE(!csr.has_vertex_names());
+			REQUIRE(boost::num_vertices(csr) == boost::num_vertices(dag));
+			REQUIRE(boost::num_edges(csr) == boost::num_edges(dag));
+			for (auto v : boost::make_iterator_range(boost::vertices(dag))) {
+				auto csrE = boost::out_edges(v, csr).first;
+				for (auto e : boost::make_iterator_range(boost::out_edges(v, dag))) {
+					REQUIRE(boost::target(*csrE, csr) == boost::target(e, dag));
+					++csrE;
+				}
+			}
+
+			//a CsrGraph writes the same bytes
+			auto again = export_temp_file("bglx_export_again.edges");
+			write_binary_edge_list(csr, again);
+			REQUIRE(read_file(again) == read_file(path));
+			std::filesystem::remove(again);
+
+			std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+			REQUIRE_THROWS(load_binary_edge_list(path));
+			std::filesystem::remove(path);
+		}
+
+		SECTION("Euler path writer prints edge names in order")
+		{
+			auto dag = make_De_Bruigin_graph(4);
+			auto cycle = bglx::find_one_directed_euler_cycle_hierholzer(dag, *boost::vertices(dag).first);
+			auto expected = std::string{};
+			for (auto e : cycle)
+				expected += dag[e].name + " -> ";
+			expected += '\n';
+			auto path = export_temp_file("bglx_euler_path.txt");
+			{
+				auto out = BufferedWriter{ path, 64 };
+				write_euler_path(dag, cycle, out);
+			}
+			REQUIRE(read_file(path) == expected);
+			std::filesystem::remove(path);
+		}
+	}
+
+	//run explicitly with: BGLTest "[benchmark]"
+	TEST_CASE("Euler path export vs std::endl printing", "[.][benchmark]")
+	{
+		auto dag = make_De_Bruigin_graph(20);
+		auto cycle = bglx::find_one_directed_euler_cycle_hierholzer(dag, *boost::vertices(dag).first);
+		auto path = export_temp_file("bglx_bench_euler.txt");
+		{
+			AutoProfiler timer{ "Euler path, one std::endl per edge takes time: " };
+			auto out = std::ofstream(path, std::ios::trunc);
+			for (auto e : cycle)
+				out << dag[e].name << " -> " << std::endl;
+		}
+		{
+			AutoProfiler timer{ "Euler path, BufferedWriter takes time: " };
+			auto out = BufferedWriter{ path };
+			write_euler_path(dag, cycle, out);
+			out.close();
+		}
+		{
+			AutoProfiler timer{ "DOT export takes time: " };
+			write_dot(dag, path);
+		}
+		{
+			AutoProfiler timer{ "Binary edge list export takes time: " };
+			write_binary_edge_list(dag, path);
+		}
+		std::filesystem::remove(path);
+	}
+}
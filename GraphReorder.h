@@ -0,0 +1,172 @@
+#pragma once
+#include "CsrGraph.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace bglx::test
+{
+	enum class VertexOrder
+	{
+		//breadth-first over out-edges from vertex 0, then from the first vertex not reached yet, so a
+		//walk along the edges mostly moves to nearby ids
+		Bfs,
+		//Cuthill-McKee over in- and out-edges with neighbors by ascending degree, every component started
+		//at a vertex of lowest degree, then reversed: both ends of an edge get close ids (small bandwidth)
+		ReverseCuthillMcKee,
+		//by in- plus out-degree, highest first and ties by id, so the hubs most edges lead to share
+		//cache lines
+		DegreeDescending
+	};
+
+	//a relabeled graph and the mapping between the ids: vertex v of the original is newId[v] in graph,
+	//vertex i of graph is oldId[i] in the original
+	struct ReorderedCsr
+	{
+		CsrGraph graph;
+		std::vector<std::uint32_t> newId;
+		std::vector<std::uint32_t> oldId;
+	};
+
+	namespace detail
+	{
+		//breadth-first from every vertex of starts not reached yet; neighbors(v, fn) calls fn for every
+		//neighbor of v, arrange(first, last) may reorder the vertices one vertex adds before they queue
+		template <class Starts, class Neighbors, class Arrange>
+		std::vector<std::uint32_t> breadth_first_order(std::size_t nrVertices, const Starts& starts,
+			Neighbors&& neighbors, Arrange&& arrange)
+		{
+			std::vector<std::uint32_t> order;
+			order.reserve(nrVertices);
+			std::vector<char> reached(nrVertices, 0);
+			for (auto start : starts) {
+				if (reached[start])
+					continue;
+				reached[start] = 1;
+				//order itself is the queue
+				order.push_back(start);
+				for (auto head = order.size() - 1; head < order.size(); ++head) {
+					auto tail = order.size();
+					neighbors(order[head], [&](std::uint32_t w) {
+						if (!reached[w]) {
+							reached[w] = 1;
+							order.push_back(w);
+						}
+					});
+					arrange(order.begin() + tail, order.end());
+				}
+			}
+			return order;
+		}
+	}
+
+	//the vertices of g in the given order, which is oldId of the reordered graph
+	static std::vector<std::uint32_t> vertex_order(const CsrGraph& g, VertexOrder order, unsigned nrThreads = 0)
+	{
+		auto& a = g.arrays();
+		auto n = a.nrVertices;
+		nrThreads = nrThreads == 0 ? default_thread_count() : nrThreads;
+		auto outEdges = [&a](std::uint32_t v, auto&& fn) {
+			for (auto e = a.offsets[v]; e < a.offsets[v + 1]; ++e)
+				fn(a.targets[e]);
+		};
+		std::vector<std::uint32_t> ids(n);
+		std::iota(ids.begin(), ids.end(), 0);
+		if (order == VertexOrder::Bfs)
+			return detail::breadth_first_order(n, ids, outEdges, [](auto, auto) {});
+
+		//in- plus out-degree; the orders below run on one thread anyway
+		std::vector<std::uint64_t> degree(n);
+		for (std::size_t v = 0; v < n; ++v)
+			degree[v] = a.offsets[v + 1] - a.offsets[v];
+		for (std::size_t e = 0; e < a.nrEdges; ++e)
+			++degree[a.targets[e]];
+		if (order == VertexOrder::DegreeDescending) {
+			std::stable_sort(ids.begin(), ids.end(), [&degree](std::uint32_t u, std::uint32_t v) { return degree[u] > degree[v]; });
+			return ids;
+		}
+		if (order != VertexOrder::ReverseCuthillMcKee)
+			throw std::invalid_argument("Unknown vertex order.");
+
+		auto reversed = detail::reverse_rows(n, a.offsets, a.targets, nrThreads);
+		auto byDegree = [&degree](std::uint32_t u, std::uint32_t v) { return degree[u] < degree[v]; };
+		std::stable_sort(ids.begin(), ids.end(), byDegree);
+		auto result = detail::breadth_first_order(n, ids, [&](std::uint32_t v, auto&& fn) {
+			outEdges(v, fn);
+			for (auto e = reversed.offsets[v]; e < reversed.offsets[v + 1]; ++e)
+				fn(reversed.targets[e]);
+		}, [&](auto first, auto last) { std::stable_sort(first, last, byDegree); });
+		std::reverse(result.begin(), result.end());
+		return result;
+	}
+
+	//g with vertex oldId[i] renamed to i. every row keeps its edge order and every edge its name, so the
+	//walks of g map onto the new graph edge by edge. throws std::invalid_argument when oldId is not a
+	//permutation of the vertices.
+	static ReorderedCsr permute_csr(const CsrGraph& g, std::vector<std::uint32_t> oldId, unsigned nrThreads = 0)
+	{
+		auto& a = g.arrays();
+		auto n = a.nrVertices;
+		nrThreads = nrThreads == 0 ? default_thread_count() : nrThreads;
+		auto threads = n < (1 << 14) ? 1u : nrThreads;
+		if (oldId.size() != n)
+			throw std::invalid_argument("The vertex order must list every vertex once.");
+		std::vector<std::uint32_t> newId(n, static_cast<std::uint32_t>(n));
+		for (std::uint32_t i = 0; i < n; ++i) {
+			if (oldId[i] >= n || newId[oldId[i]] != n)
+				throw std::invalid_argument("The vertex order must list every vertex once.");
+			newId[oldId[i]] = i;
+		}
+
+		auto storage = CsrStorage{};
+		storage.offsets.resize(n + 1);
+		for (std::size_t i = 0; i < n; ++i)
+			storage.offsets[i + 1] = storage.offsets[i] + (a.offsets[oldId[i] + 1] - a.offsets[oldId[i]]);
+		storage.targets.resize(a.nrEdges);
+		parallel_for(n, threads, [&](std::size_t i) {
+			auto to = storage.targets.begin() + storage.offsets[i];
+			for (auto e = a.offsets[oldId[i]]; e < a.offsets[oldId[i] + 1]; ++e)
+				*to++ = newId[a.targets[e]];
+		});
+
+		//name blobs in the new order: the i-th name of the new graph is name oldItem(i) of g
+		auto permuteNames = [&](std::size_t nrItems, const std::uint64_t* nameOffsets, const char* names, auto oldItem,
+			std::vector<std::uint64_t>& newOffsets, std::string& newNames) {
+			newOffsets.resize(nrItems + 1, 0);
+			for (std::size_t i = 0; i < nrItems; ++i) {
+				auto old = oldItem(i);
+				newOffsets[i + 1] = newOffsets[i] + (nameOffsets[old + 1] - nameOffsets[old]);
+			}
+			newNames.resize(newOffsets[nrItems]);
+			parallel_for(nrItems, nrItems < (1 << 14) ? 1u : nrThreads, [&](std::size_t i) {
+				auto old = oldItem(i);
+				std::memcpy(&newNames[newOffsets[i]], names + nameOffsets[old], newOffsets[i + 1] - newOffsets[i]);
+			});
+		};
+		if (g.has_vertex_names()) {
+			permuteNames(n, a.vertexNameOffsets, a.vertexNames, [&](std::size_t i) { return oldId[i]; },
+				storage.vertexNameOffsets, storage.vertexNames);
+		}
+		if (g.has_edge_names()) {
+			//old edge index of every new edge
+			std::vector<std::uint64_t> oldEdge(a.nrEdges);
+			parallel_for(n, threads, [&](std::size_t i) {
+				std::iota(oldEdge.begin() + storage.offsets[i], oldEdge.begin() + storage.offsets[i + 1], a.offsets[oldId[i]]);
+			});
+			permuteNames(a.nrEdges, a.edgeNameOffsets, a.edgeNames, [&](std::size_t e) { return oldEdge[e]; },
+				storage.edgeNameOffsets, storage.edgeNames);
+		}
+		return { CsrGraph{ std::move(storage) }, std::move(newId), std::move(oldId) };
+	}
+
+	//vertex_order then permute_csr
+	static ReorderedCsr reorder_csr(const CsrGraph& g, VertexOrder order, unsigned nrThreads = 0)
+	{
+		return permute_csr(g, vertex_order(g, order, nrThreads), nrThreads);
+	}
+}
@@ -0,0 +1,279 @@
+#pragma once
+#include "CsrGraph.h"
+#include "MappedFile.h"
+#include <boost/endian/conversion.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace bglx::test
+{
+	//binary snapshot of a CsrGraph, version 1. everything is little-endian.
+	//  [0, 128)  SnapshotHeader
+	//  sections  offsets (u64 x n+1), targets (u32 x m), vertex name offsets (u64 x n+1, optional),
+	//            vertex name blob, edge name offsets (u64 x m+1, optional), edge name blob
+	//every section starts on a 64 byte boundary, so the mapped arrays can be used in place.
+	constexpr std::uint32_t SnapshotVersion = 1;
+	constexpr std::size_t SnapshotAlignment = 64;
+
+	enum SnapshotSectionId
+	{
+		SnapshotOffsets,
+		SnapshotTargets,
+		SnapshotVertexNameOffsets,
+		SnapshotVertexNames,
+		SnapshotEdgeNameOffsets,
+		SnapshotEdgeNames,
+		SnapshotSectionCount
+	};
+
+	struct SnapshotSection
+	{
+		std::uint64_t offset;
+		std::uint64_t size;
+	};
+
+	struct SnapshotHeader
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t reserved;
+		std::uint64_t nrVertices;
+		std::uint64_t nrEdges;
+		SnapshotSection sections[SnapshotSectionCount];
+	};
+	static_assert(sizeof(SnapshotHeader) % SnapshotAlignment == 0, "sections must stay aligned");
+
+	constexpr char SnapshotMagic[8] = { 'B', 'G', 'L', 'X', 'C', 'S', 'R', '\0' };
+
+	enum class SnapshotValidation
+	{
+		//the header, section bounds and one linear pass over every offset and target
+		Full,
+		//the header, section bounds and the first/last offsets; for files this program wrote itself
+		Trusted
+	};
+
+	namespace detail
+	{
+		constexpr bool NativeIsLittle = boost::endian::order::native == boost::endian::order::little;
+
+		template <class T>
+		static void write_le_array(std::ofstream& out, const T* data, std::size_t count)
+		{
+			if constexpr (NativeIsLittle || sizeof(T) == 1) {
+				out.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+			}
+			else {
+				std::array<T, 4096> buffer;
+				for (std::size_t i = 0; i < count; i += buffer.size()) {
+					auto n = std::min(buffer.size(), count - i);
+					for (std::size_t k = 0; k < n; ++k)
+						buffer[k] = boost::endian::native_to_little(data[i + k]);
+					out.write(reinterpret_cast<const char*>(buffer.data()), n * sizeof(T));
+				}
+			}
+		}
+
+		static std::uint64_t align_up(std::uint64_t pos)
+		{
+			return (pos + SnapshotAlignment - 1) / SnapshotAlignment * SnapshotAlignment;
+		}
+
+		template <class Fail>
+		static void check_sections(const SnapshotSection* sections, int count, std::uint64_t fileSize, Fail&& fail)
+		{
+			for (int s = 0; s < count; ++s) {
+				auto& section = sections[s];
+				if (section.offset % SnapshotAlignment != 0 || section.offset > fileSize
+					|| section.size > fileSize - section.offset)
+					fail("section out of bounds.");
+			}
+		}
+
+		//offsets[0] == 0, offsets[count] == total and no offset below the one before it
+		static bool offsets_cover(const std::uint64_t* offsets, std::size_t count, std::uint64_t total)
+		{
+			if (offsets[0] != 0 || offsets[count] != total)
+				return false;
+			auto nrSlices = count < (1 << 16) ? 1u : default_thread_count();
+			std::vector<char> ordered(nrSlices, 1);
+			parallel_chunks(count, nrSlices, [&](unsigned slice, std::size_t begin, std::size_t end) {
+				for (auto i = begin; i < end; ++i) {
+					if (offsets[i] > offsets[i + 1]) {
+						ordered[slice] = 0;
+						return;
+					}
+				}
+			});
+			return std::find(ordered.begin(), ordered.end(), 0) == ordered.end();
+		}
+
+		static bool targets_below(const std::uint32_t* targets, std::size_t count, std::uint64_t limit)
+		{
+			auto nrSlices = count < (1 << 16) ? 1u : default_thread_count();
+			std::vector<char> inRange(nrSlices, 1);
+			parallel_chunks(count, nrSlices, [&](unsigned slice, std::size_t begin, std::size_t end) {
+				auto largest = std::uint32_t{ 0 };
+				for (auto i = begin; i < end; ++i)
+					largest = std::max(largest, targets[i]);
+				inRange[slice] = begin == end || largest < limit;
+			});
+			return std::find(inRange.begin(), inRange.end(), 0) == inRange.end();
+		}
+
+		//CsrGraph rows over the offsets and targets sections of a mapped file whose sections passed
+		//check_sections. n and m come from the file, so they are compared against the file size by
+		//division before any size is computed from them: a product that wraps could match a section.
+		template <class Fail>
+		static CsrGraph::Arrays map_csr_rows(const MappedFile& file, const SnapshotSection& offsets,
+			const SnapshotSection& targets, std::uint64_t n, std::uint64_t m, SnapshotValidation validation, Fail&& fail)
+		{
+			if (n >= file.size() / sizeof(std::uint64_t) || m > file.size() / sizeof(std::uint32_t))
+				fail("vertex or edge count too large for the file.");
+			if (offsets.size != (n + 1) * sizeof(std::uint64_t) || targets.size != m * sizeof(std::uint32_t))
+				fail("section size does not match the vertex/edge count.");
+			auto rows = CsrGraph::Arrays{};
+			rows.nrVertices = static_cast<std::size_t>(n);
+			rows.nrEdges = static_cast<std::size_t>(m);
+			rows.offsets = reinterpret_cast<const std::uint64_t*>(file.data() + offsets.offset);
+			rows.targets = reinterpret_cast<const std::uint32_t*>(file.data() + targets.offset);
+			if (validation == SnapshotValidation::Trusted) {
+				if (rows.offsets[0] != 0 || rows.offsets[n] != m)
+					fail("row offsets do not cover the edges.");
+				return rows;
+			}
+			if (!offsets_cover(rows.offsets, rows.nrVertices, m))
+				fail("row offsets do not cover the edges.");
+			if (!targets_below(rows.targets, rows.nrEdges, n))
+				fail("edge target out of range.");
+			return rows;
+		}
+
+		//name offsets of count names over a blob of blobSize bytes
+		template <class Fail>
+		static void check_name_offsets(const std::uint64_t* offsets, std::size_t count, std::uint64_t blobSize,
+			SnapshotValidation validation, Fail&& fail)
+		{
+			auto covered = validation == SnapshotValidation::Trusted ? offsets[0] == 0 && offsets[count] == blobSize
+				: offsets_cover(offsets, count, blobSize);
+			if (!covered)
+				fail("name offsets do not cover the name blob.");
+		}
+	}
+
+	static void write_snapshot(const CsrGraph& g, const std::string& path)
+	{
+		auto& a = g.arrays();
+		auto header = SnapshotHeader{};
+		std::memcpy(header.magic, SnapshotMagic, sizeof(SnapshotMagic));
+		header.version = SnapshotVersion;
+		header.nrVertices = a.nrVertices;
+		header.nrEdges = a.nrEdges;
+
+		std::uint64_t sizes[SnapshotSectionCount] = {
+			(a.nrVertices + 1) * sizeof(std::uint64_t),
+			a.nrEdges * sizeof(std::uint32_t),
+			g.has_vertex_names() ? (a.nrVertices + 1) * sizeof(std::uint64_t) : 0,
+			g.has_vertex_names() ? a.vertexNameOffsets[a.nrVertices] : 0,
+			g.has_edge_names() ? (a.nrEdges + 1) * sizeof(std::uint64_t) : 0,
+			g.has_edge_names() ? a.edgeNameOffsets[a.nrEdges] : 0
+		};
+		auto pos = std::uint64_t{ sizeof(SnapshotHeader) };
+		for (int s = 0; s < SnapshotSectionCount; ++s) {
+			header.sections[s] = { detail::align_up(pos), sizes[s] };
+			pos = header.sections[s].offset + sizes[s];
+		}
+
+		auto out = std::ofstream(path, std::ios::binary | std::ios::trunc);
+		if (!out)
+			throw std::runtime_error("Can not open " + path + " for writing.");
+		auto leHeader = header;
+		boost::endian::native_to_little_inplace(leHeader.version);
+		boost::endian::native_to_little_inplace(leHeader.nrVertices);
+		boost::endian::native_to_little_inplace(leHeader.nrEdges);
+		for (auto& section : leHeader.sections) {
+			boost::endian::native_to_little_inplace(section.offset);
+			boost::endian::native_to_little_inplace(section.size);
+		}
+		out.write(reinterpret_cast<const char*>(&leHeader), sizeof(leHeader));
+
+		static const char padding[SnapshotAlignment] = {};
+		auto written = std::uint64_t{ sizeof(SnapshotHeader) };
+		auto section = [&](SnapshotSectionId id, auto* data, std::size_t count) {
+			out.write(padding, header.sections[id].offset - written);
+			detail::write_le_array(out, data, count);
+			written = header.sections[id].offset + header.sections[id].size;
+		};
+		section(SnapshotOffsets, a.offsets, a.nrVertices + 1);
+		section(SnapshotTargets, a.targets, a.nrEdges);
+		if (g.has_vertex_names()) {
+			section(SnapshotVertexNameOffsets, a.vertexNameOffsets, a.nrVertices + 1);
+			section(SnapshotVertexNames, a.vertexNames, sizes[SnapshotVertexNames]);
+		}
+		if (g.has_edge_names()) {
+			section(SnapshotEdgeNameOffsets, a.edgeNameOffsets, a.nrEdges + 1);
+			section(SnapshotEdgeNames, a.edgeNames, sizes[SnapshotEdgeNames]);
+		}
+		//pad the tail as well, empty sections point at the aligned end of the file
+		out.write(padding, detail::align_up(written) - written);
+		if (!out)
+			throw std::runtime_error("Writing " + path + " failed.");
+	}
+
+	static void write_snapshot(const Dag& dag, const std::string& path)
+	{
+		write_snapshot(make_csr_graph(dag), path);
+	}
+
+	//maps a snapshot and exposes it as a CsrGraph without copying; the mapping lives as long as the graph.
+	//Full validation reads the offsets and targets once, so a corrupt file throws here instead of
+	//sending a later walk outside the mapping.
+	static CsrGraph load_snapshot(const std::string& path, SnapshotValidation validation = SnapshotValidation::Full)
+	{
+		if constexpr (!detail::NativeIsLittle)
+			throw std::runtime_error("Snapshots can only be mapped on little-endian hosts.");
+
+		auto file = std::make_shared<const MappedFile>(path);
+		auto fail = [&path](const char* what) { throw std::runtime_error(path + ": " + what); };
+		if (file->size() < sizeof(SnapshotHeader))
+			fail("too small for a snapshot header.");
+		auto header = SnapshotHeader{};
+		std::memcpy(&header, file->data(), sizeof(header));
+		if (std::memcmp(header.magic, SnapshotMagic, sizeof(SnapshotMagic)) != 0)
+			fail("not a graph snapshot.");
+		if (header.version != SnapshotVersion)
+			fail("unsupported snapshot version.");
+
+		detail::check_sections(header.sections, SnapshotSectionCount, file->size(), fail);
+		auto n = header.nrVertices;
+		auto m = header.nrEdges;
+		auto arrays = detail::map_csr_rows(*file, header.sections[SnapshotOffsets], header.sections[SnapshotTargets], n, m,
+			validation, fail);
+		//map_csr_rows bounded n and m by the file size, these products can not wrap
+		auto at = [&](SnapshotSectionId id) { return file->data() + header.sections[id].offset; };
+		if (auto size = header.sections[SnapshotVertexNameOffsets].size; size != 0) {
+			if (size != (n + 1) * sizeof(std::uint64_t))
+				fail("section size does not match the vertex/edge count.");
+			arrays.vertexNameOffsets = reinterpret_cast<const std::uint64_t*>(at(SnapshotVertexNameOffsets));
+			arrays.vertexNames = at(SnapshotVertexNames);
+			detail::check_name_offsets(arrays.vertexNameOffsets, arrays.nrVertices, header.sections[SnapshotVertexNames].size,
+				validation, fail);
+		}
+		if (auto size = header.sections[SnapshotEdgeNameOffsets].size; size != 0) {
+			if (size != (m + 1) * sizeof(std::uint64_t))
+				fail("section size does not match the vertex/edge count.");
+			arrays.edgeNameOffsets = reinterpret_cast<const std::uint64_t*>(at(SnapshotEdgeNameOffsets));
+			arrays.edgeNames = at(SnapshotEdgeNames);
+			detail::check_name_offsets(arrays.edgeNameOffsets, arrays.nrEdges, header.sections[SnapshotEdgeNames].size,
+				validation, fail);
+		}
+		return CsrGraph{ arrays, std::move(file) };
+	}
+}
@@ -0,0 +1,194 @@
+#pragma once
+#include "Timer.h"
+#include <boost/graph/graph_traits.hpp>
+#include <boost/graph/properties.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <stdexcept>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bglx::test
+{
+	enum HierholzerPhase { HierholzerSetup, HierholzerWalk, HierholzerSplice, HierholzerOutput, HierholzerPhases };
+
+	static constexpr const char* HierholzerPhaseNames[HierholzerPhases] = { "setup", "walk", "splice", "output" };
+
+	//counters of one instrumented Hierholzer run. a walk pushes edges until it gets stuck; the splice
+	//then pops finished edges until it reaches a vertex with unused out-edges, where a new sub-circuit
+	//starts. a re-scan is a cursor lookup at a vertex whose out-edges are used up.
+	struct HierholzerStats
+	{
+		static constexpr bool enabled = true;
+
+		std::uint64_t edgesTraversed = 0;
+		std::uint64_t subCircuits = 0;
+		std::uint64_t maxStackDepth = 0;
+		std::uint64_t cursorRescans = 0;
+		std::int64_t phaseNs[HierholzerPhases] = {};
+	};
+
+	//the default: every counter update sits behind if constexpr, so nothing is left of them
+	struct NoHierholzerStats
+	{
+		static constexpr bool enabled = false;
+	};
+
+	namespace detail
+	{
+		//tick counts per phase, converted to nanoseconds once the run is over
+		template <class Stats>
+		class HierholzerClock
+		{
+		public:
+			void enter(HierholzerPhase phase)
+			{
+				if constexpr (Stats::enabled) {
+					auto now = profile_ticks();
+					m_ticks[m_phase] += now - m_since;
+					m_phase = phase;
+					m_since = now;
+				}
+			}
+
+			void finish(Stats& stats)
+			{
+				if constexpr (Stats::enabled) {
+					enter(HierholzerSetup);
+					auto nsPerTick = Profiler::instance().ns_per_tick();
+					for (int p = 0; p < HierholzerPhases; ++p)
+						stats.phaseNs[p] += static_cast<std::int64_t>(m_ticks[p] * nsPerTick);
+				}
+				else {
+					(void)stats;
+				}
+			}
+
+		private:
+			HierholzerPhase m_phase = HierholzerSetup;
+			std::int64_t m_since = Stats::enabled ? profile_ticks() : 0;
+			std::int64_t m_ticks[HierholzerPhases] = {};
+		};
+	}
+
+	//Hierholzer from start with one out-edge cursor per vertex and an explicit stack, the same
+	//traversal as bglx::find_one_directed_euler_*_hierholzer but with its internals counted.
+	//returns the edges in walk order. throws std::runtime_error when the walk from start does not take
+	//every edge in one piece, i.e. a sub-circuit gets stuck away from where it left (unbalanced
+	//degrees) or edges are out of reach; whether it ends at the right vertex is up to the caller.
+	template <class Graph, class IndexMap, class Stats = NoHierholzerStats>
+	std::list<typename boost::graph_traits<Graph>::edge_descriptor> instrumented_euler_walk(
+		const Graph& g, typename boost::graph_traits<Graph>::vertex_descriptor start, IndexMap index, Stats& stats)
+	{
+		using Traits = boost::graph_traits<Graph>;
+		using Edge = typename Traits::edge_descriptor;
+		auto clock = detail::HierholzerClock<Stats>{};
+
+		std::vector<std::pair<typename Traits::out_edge_iterator, typename Traits::out_edge_iterator>> cursors(
+			boost::num_vertices(g));
+		for (auto [v, vEnd] = boost::vertices(g); v != vEnd; ++v)
+			cursors[get(index, *v)] = boost::out_edges(*v, g);
+		std::vector<Edge> stack;
+		std::vector<Edge> finished;
+		stack.reserve(boost::num_edges(g));
+		finished.reserve(boost::num_edges(g));
+
+		clock.enter(HierholzerWalk);
+		auto walking = true;
+		auto v = start;
+		for (;;) {
+			auto& cursor = cursors[get(index, v)];
+			if (cursor.first != cursor.second) {
+				auto e = *cursor.first++;
+				stack.push_back(e);
+				v = boost::target(e, g);
+				if constexpr (Stats::enabled) {
+					if (!walking) {
+						clock.enter(HierholzerWalk);
+						++stats.subCircuits;
+						walking = true;
+					}
+					++stats.edgesTraversed;
+					stats.maxStackDepth = std::max<std::uint64_t>(stats.maxStackDepth, stack.size());
+				}
+			}
+			else {
+				if constexpr (Stats::enabled) {
+					++stats.cursorRescans;
+					if (walking) {
+						clock.enter(HierholzerSplice);
+						walking = false;
+					}
+				}
+				if (stack.empty())
+					break;
+				if (!finished.empty() && boost::target(stack.back(), g) != boost::source(finished.back(), g))
+					throw std::runtime_error("The graph has no Euler walk from the start vertex.");
+				finished.push_back(stack.back());
+				stack.pop_back();
+				v = boost::source(finished.back(), g);
+			}
+		}
+		(void)walking;
+		if (finished.size() != boost::num_edges(g))
+			throw std::runtime_error("Some edges cannot be reached from the start vertex.");
+
+		clock.enter(HierholzerOutput);
+		auto walk = std::list<Edge>(finished.rbegin(), finished.rend());
+		clock.finish(stats);
+		return walk;
+	}
+
+	template <class Graph, class IndexMap, class Stats = NoHierholzerStats>
+	std::list<typename boost::graph_traits<Graph>::edge_descriptor> instrumented_euler_cycle(
+		const Graph& g, typename boost::graph_traits<Graph>::vertex_descriptor start, IndexMap index, Stats& stats)
+	{
+		auto cycle = instrumented_euler_walk(g, start, index, stats);
+		if (!cycle.empty() && boost::target(cycle.back(), g) != start)
+			throw std::runtime_error("The Euler cycle does not return to the start vertex.");
+		return cycle;
+	}
+
+	template <class Graph>
+	std::list<typename boost::graph_traits<Graph>::edge_descriptor> instrumented_euler_cycle(
+		const Graph& g, typename boost::graph_traits<Graph>::vertex_descriptor start)
+	{
+		auto stats = NoHierholzerStats{};
+		return instrumented_euler_cycle(g, start, get(boost::vertex_index, g), stats);
+	}
+
+	//the walk from start of a graph with an Euler trail ends at last, which is only checked
+	template <class Graph, class IndexMap, class Stats = NoHierholzerStats>
+	std::list<typename boost::graph_traits<Graph>::edge_descriptor> instrumented_euler_trail(
+		const Graph& g, typename boost::graph_traits<Graph>::vertex_descriptor start,
+		typename boost::graph_traits<Graph>::vertex_descriptor last, IndexMap index, Stats& stats)
+	{
+		auto trail = instrumented_euler_walk(g, start, index, stats);
+		if (!trail.empty() && boost::target(trail.back(), g) != last)
+			throw std::runtime_error("The Euler trail does not end at the last vertex.");
+		return trail;
+	}
+
+	template <class Graph>
+	std::list<typename boost::graph_traits<Graph>::edge_descriptor> instrumented_euler_trail(
+		const Graph& g, typename boost::graph_traits<Graph>::vertex_descriptor start,
+		typename boost::graph_traits<Graph>::vertex_descriptor last)
+	{
+		auto stats = NoHierholzerStats{};
+		return instrumented_euler_trail(g, start, last, get(boost::vertex_index, g), stats);
+	}
+
+	//"131072 edges, 4095 sub-circuits, max stack 65540, 131073 re-scans, setup 1.2 ms, walk ..."
+	static std::string format_hierholzer_stats(const HierholzerStats& stats)
+	{
+		std::ostringstream text;
+		text << stats.edgesTraversed << " edges, " << stats.subCircuits << " sub-circuits, max stack "
+			<< stats.maxStackDepth << ", " << stats.cursorRescans << " re-scans";
+		for (int p = 0; p < HierholzerPhases; ++p)
+			text << ", " << HierholzerPhaseNames[p] << " " << format_duration(stats.phaseNs[p]);
+		return text.str();
+	}
+}
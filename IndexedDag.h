@@ -0,0 +1,210 @@
+#pragma once
+#include "NamedDag.h"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+
+namespace bglx::test
+{
+	//open-addressing (linear probing) hash from interned names to vertices.
+	//names are copied once into append-only chunks owned by the index, lookups take a
+	//std::string_view and never allocate. erasing uses backward shift, so there are no tombstones.
+	class NameIndex
+	{
+	public:
+		NameIndex() = default;
+		NameIndex(const NameIndex&) = delete;
+		NameIndex& operator=(const NameIndex&) = delete;
+		NameIndex(NameIndex&&) = default;
+		NameIndex& operator=(NameIndex&&) = default;
+
+		std::size_t size() const { return m_size; }
+
+		void reserve(std::size_t nrNames)
+		{
+			auto capacity = std::size_t{ 16 };
+			while (capacity * 3 < nrNames * 4)
+				capacity *= 2;
+			if (capacity > m_slots.size())
+				rehash(capacity);
+		}
+
+		std::pair<Vertex, bool> find(std::string_view name) const
+		{
+			if (m_size == 0)
+				return { Vertex{}, false };
+			auto hash = hash_of(name);
+			for (auto i = hash & mask();; i = (i + 1) & mask()) {
+				auto& slot = m_slots[i];
+				if (slot.data == nullptr)
+					return { Vertex{}, false };
+				if (slot.hash == hash && slot.view() == name)
+					return { slot.v, true };
+			}
+		}
+
+		//returns false and leaves the index untouched if the name is already present
+		bool insert(std::string_view name, Vertex v)
+		{
+			if ((m_size + 1) * 4 > m_slots.size() * 3)
+				rehash(m_slots.empty() ? 16 : m_slots.size() * 2);
+			auto hash = hash_of(name);
+			auto i = hash & mask();
+			for (; m_slots[i].data != nullptr; i = (i + 1) & mask()) {
+				if (m_slots[i].hash == hash && m_slots[i].view() == name)
+					return false;
+			}
+			m_slots[i] = Slot{ hash, intern(name), name.size(), v };
+			++m_size;
+			return true;
+		}
+
+		bool erase(std::string_view name)
+		{
+			if (m_size == 0)
+				return false;
+			auto hash = hash_of(name);
+			auto i = hash & mask();
+			for (;; i = (i + 1) & mask()) {
+				if (m_slots[i].data == nullptr)
+					return false;
+				if (m_slots[i].hash == hash && m_slots[i].view() == name)
+					break;
+			}
+			//backward shift: pull later entries of the probe run into the hole
+			for (auto j = (i + 1) & mask(); m_slots[j].data != nullptr; j = (j + 1) & mask()) {
+				auto home = m_slots[j].hash & mask();
+				auto holeIsOnPath = i <= j ? (home <= i || home > j) : (home <= i && home > j);
+				if (holeIsOnPath) {
+					m_slots[i] = m_slots[j];
+					i = j;
+				}
+			}
+			m_slots[i] = Slot{};
+			--m_size;
+			return true;
+		}
+
+		//vecS renumbers every vertex after a removed one, mirror that here
+		void shift_down_after(Vertex removed)
+		{
+			for (auto& slot : m_slots) {
+				if (slot.data != nullptr && slot.v > removed)
+					--slot.v;
+			}
+		}
+
+		void clear()
+		{
+			m_slots.clear();
+			m_chunks.clear();
+			m_chunkUsed = 0;
+			m_size = 0;
+		}
+
+	private:
+		struct Slot
+		{
+			std::size_t hash = 0;
+			const char* data = nullptr;
+			std::size_t length = 0;
+			Vertex v = 0;
+			std::string_view view() const { return { data, length }; }
+		};
+
+		static constexpr std::size_t ChunkSize = 64 * 1024;
+
+		static std::size_t hash_of(std::string_view name) { return std::hash<std::string_view>{}(name); }
+		std::size_t mask() const { return m_slots.size() - 1; }
+
+		//storage of erased names is only given back on clear()
+		const char* intern(std::string_view name)
+		{
+			auto length = std::max<std::size_t>(name.size(), 1);
+			if (m_chunks.empty() || m_chunkUsed + length > m_chunkCapacity) {
+				m_chunkCapacity = std::max(ChunkSize, length);
+				m_chunks.emplace_back(new char[m_chunkCapacity]);
+				m_chunkUsed = 0;
+			}
+			auto dest = m_chunks.back().get() + m_chunkUsed;
+			std::memcpy(dest, name.data(), name.size());
+			m_chunkUsed += length;
+			return dest;
+		}
+
+		void rehash(std::size_t capacity)
+		{
+			auto old = std::move(m_slots);
+			m_slots.assign(capacity, Slot{});
+			for (auto& slot : old) {
+				if (slot.data == nullptr)
+					continue;
+				auto i = slot.hash & mask();
+				while (m_slots[i].data != nullptr)
+					i = (i + 1) & mask();
+				m_slots[i] = slot;
+			}
+		}
+
+		std::vector<Slot> m_slots;
+		std::size_t m_size = 0;
+		std::vector<std::unique_ptr<char[]>> m_chunks;
+		std::size_t m_chunkUsed = 0;
+		std::size_t m_chunkCapacity = 0;
+	};
+
+	//a Dag whose vertex names are unique and kept in a NameIndex. vertices have to be added and removed
+	//through this wrapper and their names left alone; edges can be edited freely on graph(),
+	//that does not move vertices.
+	class IndexedDag
+	{
+	public:
+		IndexedDag() = default;
+
+		//takes over a graph whose vertex names are unique and indexes it once
+		explicit IndexedDag(Dag dag) : m_dag(std::move(dag))
+		{
+			m_index.reserve(boost::num_vertices(m_dag));
+			for (auto v : boost::make_iterator_range(boost::vertices(m_dag))) {
+				if (!m_index.insert(m_dag[v].name, v))
+					throw std::invalid_argument("Duplicated vertex name.");
+			}
+		}
+
+		const Dag& graph() const { return m_dag; }
+		Dag& graph() { return m_dag; }
+
+		std::pair<Vertex, bool> vertex(std::string_view name) const { return m_index.find(name); }
+
+		//returns the existing vertex and false if the name is already taken
+		std::pair<Vertex, bool> add_vertex(std::string_view name)
+		{
+			auto [existing, found] = m_index.find(name);
+			if (found)
+				return { existing, false };
+			auto v = boost::add_vertex(VertexProperty{ std::string{ name } }, m_dag);
+			m_index.insert(name, v);
+			return { v, true };
+		}
+
+		void remove_vertex(Vertex v)
+		{
+			m_index.erase(m_dag[v].name);
+			boost::clear_vertex(v, m_dag);
+			boost::remove_vertex(v, m_dag);
+			m_index.shift_down_after(v);
+		}
+
+		void clear()
+		{
+			m_dag.clear();
+			m_index.clear();
+		}
+
+	private:
+		Dag m_dag;
+		NameIndex m_index;
+	};
+}
@@ -26,15 +26,17 @@ namespace bglx::test
 		return { name + "0", name + "1" };
 	}
 
-	static Dag make_De_Bruigin_graph(int order)
+	//Graph can be any Dag-shaped graph with a bundled `name` on vertices and edges (Dag, PmrDag)
+	template <class Graph = Dag>
+	static Graph make_De_Bruigin_graph(int order)
 	{
 		auto names = std::vector<std::string>{ "0", "1" };
 		for (int i = 0; i < order; i++) {
 			names = expandString(names);
 		}
 		std::cout << names.size() << std::endl;
-		auto dag = test::Dag{};
-		std::unordered_map<std::string, test::Vertex> nameToVertex;
+		auto dag = Graph{};
+		std::unordered_map<std::string, typename Graph::vertex_descriptor> nameToVertex;
 		for (auto name : names) {
 			auto v = boost::add_vertex(dag);
 			dag[v].name = name;
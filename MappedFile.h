@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace bglx::test
+{
+	//read-only mapping of a whole file, unmapped on destruction. an empty file maps to data() == nullptr.
+	class MappedFile
+	{
+	public:
+		explicit MappedFile(const std::string& path)
+		{
+#ifdef _WIN32
+			auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+				OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+				throw std::runtime_error("Can not open " + path);
+			LARGE_INTEGER size;
+			GetFileSizeEx(file, &size);
+			m_size = static_cast<std::size_t>(size.QuadPart);
+			if (m_size != 0) {
+				m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (m_mapping != nullptr)
+					m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+			}
+			CloseHandle(file);
+			if (m_size != 0 && m_data == nullptr) {
+				if (m_mapping != nullptr)
+					CloseHandle(m_mapping);
+				throw std::runtime_error("Can not map " + path);
+			}
+#else
+			auto fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+				throw std::runtime_error("Can not open " + path);
+			struct stat st;
+			if (::fstat(fd, &st) != 0) {
+				::close(fd);
+				throw std::runtime_error("Can not stat " + path);
+			}
+			m_size = static_cast<std::size_t>(st.st_size);
+			if (m_size != 0) {
+				auto addr = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+				if (addr == MAP_FAILED) {
+					::close(fd);
+					throw std::runtime_error("Can not map " + path);
+				}
+				m_data = static_cast<const char*>(addr);
+			}
+			::close(fd);
+#endif
+		}
+
+		~MappedFile()
+		{
+			if (m_data == nullptr)
+				return;
+#ifdef _WIN32
+			UnmapViewOfFile(m_data);
+			CloseHandle(m_mapping);
+#else
+			::munmap(const_cast<char*>(m_data), m_size);
+#endif
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const char* data() const { return m_data; }
+		std::size_t size() const { return m_size; }
+
+		//hint that the whole file is about to be read front to back
+		void advise_sequential() const
+		{
+#ifndef _WIN32
+			if (m_data != nullptr)
+				::madvise(const_cast<char*>(m_data), m_size, MADV_SEQUENTIAL);
+#endif
+		}
+
+	private:
+		const char* m_data = nullptr;
+		std::size_t m_size = 0;
+#ifdef _WIN32
+		HANDLE m_mapping = nullptr;
+#endif
+	};
+}
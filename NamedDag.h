@@ -1,15 +1,21 @@
 #pragma once
+#include "FlatSetS.h"
+#include "BufferedWriter.h"
+#include <boost/container/pmr/global_resource.hpp>
 #include <boost/container/pmr/list.hpp>
+#include <boost/container/pmr/memory_resource.hpp>
 #include <boost/container/pmr/monotonic_buffer_resource.hpp>
-#include <boost/container/pmr/polymorphic_allocator.hpp>
 #include <boost/container/pmr/unsynchronized_pool_resource.hpp>
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/copy.hpp>
 #include <boost/graph/graph_utility.hpp>
 #include <boost/property_map/property_map.hpp>
+#include <algorithm>
 #include <iostream>
 #include <queue>
+#include <set>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -35,29 +41,259 @@ namespace bglx::test
 		VertexProperty,
 		EdgeProperty>;
 
+	//Dag that also keeps in-edges, so in_degree and in_edges are O(1) at the price of a second edge list
+	using BidirectionalDag = boost::adjacency_list<
+		boost::setS,
+		boost::vecS,
+		boost::bidirectionalS,
+		VertexProperty,
+		EdgeProperty>;
+
 	using Vertex = Dag::vertex_descriptor;
 	using Edge = Dag::edge_descriptor;
 	using EdgeIt = Dag::edge_iterator;
 
+	namespace detail
+	{
+		//resource that GraphResourceAllocators default constructed on this thread allocate from
+		inline boost::container::pmr::memory_resource*& graph_resource()
+		{
+			thread_local boost::container::pmr::memory_resource* resource = boost::container::pmr::new_delete_resource();
+			return resource;
+		}
+	}
+
+	//makes resource the graph resource of the calling thread and restores the previous one on scope exit.
+	//other threads and the pmr default resource are not affected.
+	class ScopedGraphResource
+	{
+	public:
+		explicit ScopedGraphResource(boost::container::pmr::memory_resource* resource)
+			: m_prev(std::exchange(detail::graph_resource(), resource)) { }
+		~ScopedGraphResource() { detail::graph_resource() = m_prev; }
+		ScopedGraphResource(const ScopedGraphResource&) = delete;
+		ScopedGraphResource& operator=(const ScopedGraphResource&) = delete;
+	private:
+		boost::container::pmr::memory_resource* m_prev;
+	};
+
+	//allocator of the pmr graph containers. a default constructed one takes the graph resource of the
+	//calling thread and keeps it, copies share it. elements are constructed with that resource as the
+	//graph resource, so containers inside them (out-edge sets, names) allocate from the same resource
+	//as the container holding them, also when they are added after the scope has ended.
+	template <class T>
+	class GraphResourceAllocator
+	{
+	public:
+		using value_type = T;
+
+		GraphResourceAllocator() noexcept : m_resource(detail::graph_resource()) { }
+		explicit GraphResourceAllocator(boost::container::pmr::memory_resource* resource) noexcept : m_resource(resource) { }
+		template <class U>
+		GraphResourceAllocator(const GraphResourceAllocator<U>& other) noexcept : m_resource(other.resource()) { }
+
+		T* allocate(std::size_t n) { return static_cast<T*>(m_resource->allocate(n * sizeof(T), alignof(T))); }
+		void deallocate(T* p, std::size_t n) noexcept { m_resource->deallocate(p, n * sizeof(T), alignof(T)); }
+
+		template <class U, class... Args>
+		void construct(U* p, Args&&... args)
+		{
+			auto scope = ScopedGraphResource{ m_resource };
+			::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+		}
+
+		//a copied container allocates from the graph resource of the thread that copies it
+		GraphResourceAllocator select_on_container_copy_construction() const { return {}; }
+
+		boost::container::pmr::memory_resource* resource() const noexcept { return m_resource; }
+
+		template <class U>
+		bool operator==(const GraphResourceAllocator<U>& other) const noexcept
+		{
+			return m_resource == other.resource() || m_resource->is_equal(*other.resource());
+		}
+		template <class U>
+		bool operator!=(const GraphResourceAllocator<U>& other) const noexcept { return !(*this == other); }
+
+	private:
+		boost::container::pmr::memory_resource* m_resource;
+	};
+
+	using GraphString = std::basic_string<char, std::char_traits<char>, GraphResourceAllocator<char>>;
+
+	//container selectors whose containers allocate through GraphResourceAllocator
+	struct pmr_vecS {};
+	struct pmr_setS {};
+
+	struct PmrVertexProperty
+	{
+		GraphString name;
+	};
+
+	struct PmrEdgeProperty
+	{
+		GraphString name;
+	};
+
+	//same shape as Dag, but vertex storage, out-edge sets and vertex names come from the graph resource
+	//of the thread that constructs it; build it inside a ScopedGraphResource to pick the resource.
+	//note: adjacency_list boxes every edge property with plain new before inserting the edge, so edge
+	//name buffers come from the graph resource of the thread adding the edge, not from the graph's.
+	using PmrDag = boost::adjacency_list<
+		pmr_setS,
+		pmr_vecS,
+		boost::directedS,
+		PmrVertexProperty,
+		PmrEdgeProperty>;
+
+	//read-mostly Dag, load it with BulkEdgeLoader to keep construction from going quadratic
+	using FlatDag = boost::adjacency_list<
+		flat_setS,
+		boost::vecS,
+		boost::directedS,
+		VertexProperty,
+		EdgeProperty>;
+
+	//buffers edges and on freeze() merges them, sorted by (source, target), into every flat_setS
+	//out-edge list in one pass, which is linear in the old plus the new out-degree also when the graph
+	//already has edges. the first of several parallel edges wins and edges already in the graph are
+	//kept, as with setS. Graph must use vecS vertices, flat_setS out-edges and directedS (no in-edge or
+	//global edge lists to update), and all vertices must exist before freeze().
+	template <class Graph>
+	class BulkEdgeLoader
+	{
+		static_assert(std::is_same<typename boost::graph_traits<Graph>::directed_category, boost::directed_tag>::value,
+			"BulkEdgeLoader writes out-edge lists directly, which only directedS graphs allow.");
+	public:
+		using vertex_descriptor = typename boost::graph_traits<Graph>::vertex_descriptor;
+		using edge_bundled = typename boost::edge_bundle_type<Graph>::type;
+
+		explicit BulkEdgeLoader(Graph& g) : m_g(g) { }
+
+		void reserve(std::size_t nrEdges) { m_pending.reserve(nrEdges); }
+
+		void add_edge(vertex_descriptor u, vertex_descriptor v, edge_bundled property = {})
+		{
+			m_pending.push_back({ u, v, std::move(property) });
+		}
+
+		//moves all buffered edges into the graph, returns the number of edges actually inserted
+		std::size_t freeze()
+		{
+			std::stable_sort(m_pending.begin(), m_pending.end(),
+				[](const PendingEdge& a, const PendingEdge& b) {
+				return a.u != b.u ? a.u < b.u : a.v < b.v;
+			});
+			using OutEdgeList = std::remove_reference_t<decltype(m_g.out_edge_list(vertex_descriptor{}))>;
+			std::vector<typename OutEdgeList::value_type> run;
+			auto nrInserted = std::size_t{ 0 };
+			for (auto first = m_pending.begin(); first != m_pending.end();) {
+				auto u = first->u;
+				auto last = std::find_if(first, m_pending.end(),
+					[u](const PendingEdge& e) { return e.u != u; });
+				run.clear();
+				for (; first != last; ++first) {
+					if (run.empty() || run.back().get_target() != first->v)
+						run.emplace_back(first->v, first->property);
+				}
+				//skips the targets the list already has, like add_edge would
+				auto& outEdges = m_g.out_edge_list(u);
+				auto before = outEdges.size();
+				outEdges.insert(boost::container::ordered_unique_range,
+					std::make_move_iterator(run.begin()), std::make_move_iterator(run.end()));
+				nrInserted += outEdges.size() - before;
+			}
+			m_pending.clear();
+			m_pending.shrink_to_fit();
+			return nrInserted;
+		}
+
+	private:
+		struct PendingEdge
+		{
+			vertex_descriptor u;
+			vertex_descriptor v;
+			edge_bundled property;
+		};
+		Graph& m_g;
+		std::vector<PendingEdge> m_pending;
+	};
+
+
+	//the print helpers format into a BufferedWriter over stdout, which is flushed once per call
+	//instead of once per line; pass a writer to batch several calls into one write
+	static void printVertex(const Dag& dag, Vertex v, BufferedWriter& out)
+	{
+		out.write("  ");
+		out.write(dag[v].name);
+	}
+
 	static void printVertex(const Dag& dag, Vertex v)
 	{
-		std::cout << "  " << dag[v].name;
+		auto out = BufferedWriter{ stdout, 256 };
+		printVertex(dag, v, out);
+	}
+
+	static void printEdge(const Dag& dag, Edge edge, BufferedWriter& out)
+	{
+		out.write("Edge: ");
+		out.write(dag[boost::source(edge, dag)].name);
+		out.write(" -> ");
+		out.write(dag[boost::target(edge, dag)].name);
+		out.put('\n');
 	}
 
 	static void printEdge(const Dag& dag, Edge edge)
 	{
-		auto source = boost::source(edge, dag);
-		auto target = boost::target(edge, dag);
-		std::cout << "Edge: " << dag[source].name << " -> " << dag[target].name << std::endl;
+		auto out = BufferedWriter{ stdout, 256 };
+		printEdge(dag, edge, out);
 	}
 
 	static void printEdges(const Dag& dag, const std::set<Edge>& edges)
 	{
-		std::cout << "--------------------------------------------" << std::endl;
+		auto out = BufferedWriter{ stdout };
+		out.write("--------------------------------------------\n");
 		for (auto& edge : edges) {
-			printEdge(dag, edge);
+			printEdge(dag, edge, out);
 		}
-		std::cout << "--------------------------------------------" << std::endl;
+		out.write("--------------------------------------------\n");
+	}
+
+}
+
+namespace boost
+{
+	template <class ValueType>
+	struct container_gen<bglx::test::pmr_vecS, ValueType>
+	{
+		using type = std::vector<ValueType, bglx::test::GraphResourceAllocator<ValueType>>;
+	};
+
+	template <class ValueType>
+	struct container_gen<bglx::test::pmr_setS, ValueType>
+	{
+		using type = std::set<ValueType, std::less<ValueType>, bglx::test::GraphResourceAllocator<ValueType>>;
 	};
 
+	namespace detail
+	{
+		template <>
+		struct is_random_access<bglx::test::pmr_vecS>
+		{
+			enum { value = true };
+			using type = mpl::true_;
+		};
+	}
+
+	template <>
+	struct parallel_edge_traits<bglx::test::pmr_vecS>
+	{
+		using type = allow_parallel_edge_tag;
+	};
+
+	template <>
+	struct parallel_edge_traits<bglx::test::pmr_setS>
+	{
+		using type = disallow_parallel_edge_tag;
+	};
 }
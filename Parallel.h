@@ -0,0 +1,53 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace bglx::test
+{
+	static unsigned default_thread_count()
+	{
+		auto nrThreads = std::thread::hardware_concurrency();
+		return nrThreads == 0 ? 1 : nrThreads;
+	}
+
+	//calls fn(chunk, begin, end) for nrChunks contiguous slices of [0, nrItems), each on its own thread;
+	//the calling thread runs chunk 0. the first exception of any chunk is rethrown once all have joined.
+	template <class Fn>
+	static void parallel_chunks(std::size_t nrItems, unsigned nrChunks, Fn&& fn)
+	{
+		nrChunks = std::max(1u, nrChunks);
+		std::vector<std::exception_ptr> errors(nrChunks);
+		auto run = [&](unsigned chunk) {
+			try {
+				fn(chunk, nrItems * chunk / nrChunks, nrItems * (chunk + 1) / nrChunks);
+			}
+			catch (...) {
+				errors[chunk] = std::current_exception();
+			}
+		};
+		std::vector<std::thread> threads;
+		threads.reserve(nrChunks - 1);
+		for (unsigned chunk = 1; chunk < nrChunks; ++chunk)
+			threads.emplace_back(run, chunk);
+		run(0);
+		for (auto& thread : threads)
+			thread.join();
+		for (auto& error : errors) {
+			if (error)
+				std::rethrow_exception(error);
+		}
+	}
+
+	//parallel_chunks over [0, nrItems) calling fn(i) for every item
+	template <class Fn>
+	static void parallel_for(std::size_t nrItems, unsigned nrThreads, Fn&& fn)
+	{
+		parallel_chunks(nrItems, nrThreads, [&fn](unsigned, std::size_t begin, std::size_t end) {
+			for (auto i = begin; i < end; ++i)
+				fn(i);
+		});
+	}
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include "AllocationTracker.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace bglx::test
+{
+	//resident memory of the whole process. peakRss is the high-water mark since the process started,
+	//so over a phase its delta is how far the phase pushed the peak up. the rollup fields come from
+	//smaps_rollup in /proc/self, which walks the page tables and is only read when asked for.
+	struct MemorySample
+	{
+		bool valid = false;
+		std::uint64_t rss = 0;
+		std::uint64_t peakRss = 0;
+		bool hasRollup = false;
+		std::uint64_t pss = 0;
+		std::uint64_t anonymous = 0;
+		std::uint64_t swap = 0;
+	};
+
+	namespace detail
+	{
+#ifdef __linux__
+		//calls onField(name, kB) for every "Name:   123 kB" line. plain stdio, so sampling does not
+		//show up in an AllocationScope measuring the same stretch.
+		template <class OnField>
+		static bool read_kb_fields(const char* path, OnField onField)
+		{
+			auto file = std::fopen(path, "r");
+			if (file == nullptr)
+				return false;
+			char line[256];
+			while (std::fgets(line, sizeof(line), file) != nullptr) {
+				auto colon = std::strchr(line, ':');
+				if (colon == nullptr)
+					continue;
+				*colon = '\0';
+				unsigned long long kb = 0;
+				if (std::sscanf(colon + 1, "%llu kB", &kb) == 1)
+					onField(line, std::uint64_t{ kb } * 1024);
+			}
+			std::fclose(file);
+			return true;
+		}
+#endif
+	}
+
+	static MemorySample sample_process_memory(bool withRollup = false)
+	{
+		auto sample = MemorySample{};
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters{};
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+			sample.valid = true;
+			sample.rss = counters.WorkingSetSize;
+			sample.peakRss = counters.PeakWorkingSetSize;
+		}
+		(void)withRollup;
+#else
+#ifdef __linux__
+		sample.valid = detail::read_kb_fields("/proc/self/status", [&](const char* name, std::uint64_t bytes) {
+			if (std::strcmp(name, "VmRSS") == 0)
+				sample.rss = bytes;
+			else if (std::strcmp(name, "VmHWM") == 0)
+				sample.peakRss = bytes;
+		});
+		if (withRollup) {
+			sample.hasRollup = detail::read_kb_fields("/proc/self/smaps_rollup", [&](const char* name, std::uint64_t bytes) {
+				if (std::strcmp(name, "Pss") == 0)
+					sample.pss = bytes;
+				else if (std::strcmp(name, "Anonymous") == 0)
+					sample.anonymous = bytes;
+				else if (std::strcmp(name, "Swap") == 0)
+					sample.swap = bytes;
+			});
+		}
+#else
+		(void)withRollup;
+#endif
+		//getrusage knows the peak everywhere (kB on Linux, bytes on macOS), rss only through /proc
+		rusage usage{};
+		if (sample.peakRss == 0 && ::getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+			sample.peakRss = static_cast<std::uint64_t>(usage.ru_maxrss);
+#else
+			sample.peakRss = static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+			sample.valid = sample.peakRss != 0;
+		}
+#endif
+		return sample;
+	}
+
+	static std::string format_byte_delta(std::uint64_t before, std::uint64_t after)
+	{
+		return after >= before ? "+" + format_bytes(after - before) : "-" + format_bytes(before - after);
+	}
+
+	//"RSS 1.20 GB (+800.00 MB), peak RSS 1.50 GB (+300.00 MB)", plus the rollup of the end sample
+	static std::string format_memory_samples(const MemorySample& before, const MemorySample& after)
+	{
+		if (!before.valid || !after.valid)
+			return {};
+		auto text = std::string{};
+		if (after.rss != 0)
+			text += "RSS " + format_bytes(after.rss) + " (" + format_byte_delta(before.rss, after.rss) + "), ";
+		text += "peak RSS " + format_bytes(after.peakRss) + " (" + format_byte_delta(before.peakRss, after.peakRss) + ")";
+		if (after.hasRollup) {
+			text += ", PSS " + format_bytes(after.pss) + ", anonymous " + format_bytes(after.anonymous)
+				+ ", swap " + format_bytes(after.swap);
+		}
+		return text;
+	}
+}
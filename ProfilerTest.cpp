@@ -0,0 +1,276 @@
+#define _SILENCE_CXX17_ITERATOR_BASE_CLASS_DEPRECATION_WARNING
+#include "NamedDag.h"
+#include "Timer.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <catch.hpp>
+#include "Make_De_Bruijn_Euler_Digraph.h"
+
+namespace bglx::test {
+	static const ProfileNode& child_named(const std::vector<ProfileNode>& nodes, std::size_t parent, std::string_view name)
+	{
+		for (auto child : nodes[parent].children) {
+			if (nodes[child].name == name)
+				return nodes[child];
+		}
+		FAIL("no child named " << name);
+		return nodes[0];
+	}
+
+	TEST_CASE("Profiler")
+	{
+		SECTION("Stats use nearest rank percentiles")
+		{
+			std::vector<std::int64_t> durations;
+			for (int d = 100; d >= 1; --d)
+				durations.push_back(d);
+			auto stats = profile_stats(durations);
+			REQUIRE(stats.count == 100);
+			REQUIRE(stats.total == 5050);
+			REQUIRE(stats.min == 1);
+			REQUIRE(stats.max == 100);
+			REQUIRE(stats.p50 == 50);
+			REQUIRE(stats.p99 == 99);
+			REQUIRE(profile_stats({ 7 }).p99 == 7);
+		}
+
+		SECTION("Durations are printed in the largest fitting unit")
+		{
+			REQUIRE(format_duration(999) == "999 ns");
+			REQUIRE(format_duration(1500) == "1.500 us");
+			REQUIRE(format_duration(2500000) == "2.500 ms");
+			REQUIRE(format_duration(3000000000) == "3.000 s");
+		}
+
+		SECTION("Call tree from events")
+		{
+			//build { load { parse parse } sort } build { load }, listed in completion order as rings hold them
+			auto nodes = build_profile_tree({
+				{ "parse", 2, 10, 20 },
+				{ "parse", 2, 30, 50 },
+				{ "load", 1, 5, 60 },
+				{ "sort", 1, 70, 80 },
+				{ "build", 0, 0, 100 },
+				{ "load", 1, 210, 230 },
+				{ "build", 0, 200, 300 } });
+			REQUIRE(nodes[0].children.size() == 1);
+			auto& build = child_named(nodes, 0, "build");
+			REQUIRE(build.durations == std::vector<std::int64_t>{ 100, 100 });
+			REQUIRE(build.children.size() == 2);
+			auto& load = child_named(nodes, nodes[0].children[0], "load");
+			REQUIRE(load.depth == 2);
+			REQUIRE(load.durations == std::vector<std::int64_t>{ 55, 20 });
+			auto& parse = nodes[load.children.at(0)];
+			REQUIRE(parse.name == "parse");
+			REQUIRE(parse.durations == std::vector<std::int64_t>{ 10, 20 });
+			REQUIRE(child_named(nodes, nodes[0].children[0], "sort").durations.size() == 1);
+		}
+
+#if BGLX_PROFILING
+		SECTION("Scopes record into the ring of their thread")
+		{
+			Profiler::instance().reset();
+			for (int i = 0; i < 3; ++i) {
+				BGLX_PROFILE_SCOPE("outer");
+				for (int j = 0; j < 4; ++j) {
+					BGLX_PROFILE_SCOPE("inner");
+				}
+			}
+			auto& ring = this_thread_ring();
+			REQUIRE(ring.depth == 0);
+			auto nodes = build_profile_tree(ring.events());
+			auto& outer = child_named(nodes, 0, "outer");
+			REQUIRE(outer.durations.size() == 3);
+			REQUIRE(nodes[outer.children.at(0)].durations.size() == 12);
+
+			std::vector<ProfileEvent> workerEvents;
+			ProfileRing* workerRing = nullptr;
+			{
+				BGLX_PROFILE_SCOPE("waiting for worker");
+				std::thread worker([&] {
+					{
+						AutoProfiler timer{ "worker" };
+					}
+					workerRing = &this_thread_ring();
+					workerEvents = workerRing->events();
+				});
+				worker.join();
+			}
+			REQUIRE(workerRing != &ring);
+			REQUIRE(workerEvents.size() == 1);
+			REQUIRE(workerEvents[0].depth == 0);
+			REQUIRE(std::string_view{ workerEvents[0].name } == "worker");
+
+			std::ostringstream report;
+			Profiler::instance().report(report);
+			REQUIRE(report.str().find("  outer ") != std::string::npos);
+			REQUIRE(report.str().find("    inner ") != std::string::npos);
+			REQUIRE(report.str().find("  waiting for worker ") != std::string::npos);
+		}
+#endif
+
+		SECTION("Ticks are calibrated once")
+		{
+			auto nsPerTick = Profiler::instance().ns_per_tick();
+			REQUIRE(nsPerTick > 0);
+			//later calls, e.g. one per instrumented Euler run, return the cached ratio right away
+			auto same = true;
+			auto beg = profile_now();
+			for (int i = 0; i < 1000; ++i)
+				same = same && Profiler::instance().ns_per_tick() == nsPerTick;
+			auto ns = profile_now() - beg;
+			REQUIRE(same);
+			REQUIRE(ns < 2000000);
+		}
+
+		SECTION("Perf counter samples are formatted per edge")
+		{
+			auto sample = PerfSample{};
+			sample.values[PerfCycles] = 2000;
+			sample.values[PerfInstructions] = 3000;
+			sample.values[PerfLlcMisses] = 50;
+			sample.valid[PerfCycles] = sample.valid[PerfInstructions] = sample.valid[PerfLlcMisses] = true;
+			REQUIRE(format_perf_sample(sample, 100) ==
+				"IPC 1.50, cycles 20.00 per edge, instructions 30.00 per edge, LLC misses 0.50 per edge");
+			REQUIRE(format_perf_sample(sample, 0) == "IPC 1.50, cycles 2000, instructions 3000, LLC misses 50");
+			REQUIRE(format_perf_sample(PerfSample{}, 100).empty());
+		}
+
+		SECTION("Perf counters either count or report nothing")
+		{
+			auto counters = PerfCounters{};
+			counters.start();
+			auto sum = std::uint64_t{ 0 };
+			for (std::uint64_t i = 0; i < 1000000; ++i)
+				sum += i * i;
+			auto sample = counters.stop();
+			REQUIRE(sum != 0);
+			auto nrValid = std::count(std::begin(sample.valid), std::end(sample.valid), true);
+			REQUIRE((nrValid > 0) == counters.available());
+			if (sample.valid[PerfInstructions])
+				REQUIRE(sample.values[PerfInstructions] > 1000000);
+			{
+				//prints either counters or that they are unavailable, never throws
+				AutoProfiler timer{ "perf counted scope", ProfilePerfCounters, 1000 };
+			}
+		}
+
+		SECTION("Allocation sizes are bucketed by powers of two")
+		{
+			REQUIRE(allocation_bucket(0) == 0);
+			REQUIRE(allocation_bucket(8) == 0);
+			REQUIRE(allocation_bucket(9) == 1);
+			REQUIRE(allocation_bucket(16) == 1);
+			REQUIRE(allocation_bucket(1000) == 7);
+			REQUIRE(allocation_bucket(std::size_t{ 1 } << 40) == AllocationBuckets - 1);
+			auto stats = AllocationStats{};
+			stats.count = 3;
+			stats.bytes = 2048;
+			stats.peakLive = 1024;
+			stats.histogram[0] = 2;
+			stats.histogram[7] = 1;
+			REQUIRE(format_allocation_stats(stats) ==
+				"3 allocations, 2.00 KB, peak live 1.00 KB, sizes <=8 B: 2, <=1.00 KB: 1");
+		}
+
+		SECTION("Allocation scopes count operator new")
+		{
+			REQUIRE(global_allocations().hooked);
+			AllocationScope outer;
+			auto kept = std::vector<char>(1 << 20);
+			AllocationStats innerStats;
+			{
+				AllocationScope inner;
+				auto small = std::make_unique<std::uint64_t>(1);
+				auto medium = std::make_unique<char[]>(1000);
+				innerStats = inner.stop();
+			}
+			auto outerStats = outer.stop();
+			REQUIRE(innerStats.count == 2);
+			REQUIRE(innerStats.bytes == 1008);
+			REQUIRE(innerStats.histogram[allocation_bucket(1000)] == 1);
+			REQUIRE(innerStats.peakLive >= 1008);
+			REQUIRE(innerStats.peakLive < (1 << 20));
+			REQUIRE(outerStats.count == 3);
+			REQUIRE(outerStats.peakLive >= (1 << 20) + 1008);
+			REQUIRE(outer.stop().count == 3);
+		}
+
+		SECTION("Counting resource sees pmr graph allocations")
+		{
+			CountingResource counting;
+			{
+				ScopedGraphResource scope{ &counting };
+				auto dag = make_De_Bruigin_graph<PmrDag>(4);
+				REQUIRE(counting.counters().live() > 0);
+			}
+			auto totals = counting.counters().totals();
+			REQUIRE(totals.count > 0);
+			REQUIRE(totals.peakLive > 0);
+			REQUIRE(counting.counters().live() == 0);
+		}
+
+		SECTION("Process memory grows with touched pages")
+		{
+			auto before = sample_process_memory(true);
+#if defined(__linux__) || defined(_WIN32)
+			REQUIRE(before.valid);
+#endif
+			if (before.valid) {
+				REQUIRE(before.peakRss >= before.rss);
+				constexpr std::size_t size = 64 << 20;
+				auto block = std::make_unique<char[]>(size);
+				std::memset(block.get(), 1, size);
+				auto after = sample_process_memory(true);
+				//the heap may reuse pages that were resident already, so only require the block to be resident
+				REQUIRE(after.peakRss >= before.peakRss);
+				REQUIRE(after.peakRss >= size);
+				if (after.rss != 0)
+					REQUIRE(after.rss >= size);
+				if (after.hasRollup)
+					REQUIRE(after.anonymous >= size);
+				REQUIRE(block[size - 1] == 1);
+				auto text = format_memory_samples(before, after);
+				REQUIRE(text.find("peak RSS ") != std::string::npos);
+			}
+			REQUIRE(format_byte_delta(3072, 1024) == "-2.00 KB");
+			REQUIRE(format_memory_samples(MemorySample{}, MemorySample{}).empty());
+		}
+
+		SECTION("Full rings overwrite the oldest scopes")
+		{
+			auto ring = std::make_unique<ProfileRing>();
+			for (std::size_t i = 0; i < ProfileRing::Capacity + 5; ++i)
+				ring->push({ "e", 0, static_cast<std::int64_t>(i), static_cast<std::int64_t>(i) + 1 });
+			REQUIRE(ring->dropped() == 5);
+			auto events = ring->events();
+			REQUIRE(events.size() == ProfileRing::Capacity);
+			REQUIRE(events.front().begin == 5);
+		}
+	}
+
+	//run explicitly with: BGLTest "[benchmark]"
+	TEST_CASE("Profile scope overhead", "[.][benchmark]")
+	{
+		constexpr int nrScopes = 10000000;
+		Profiler::instance().reset();
+		auto beg = profile_now();
+		for (int i = 0; i < nrScopes; ++i) {
+			BGLX_PROFILE_SCOPE("empty scope");
+		}
+		auto perScope = double(profile_now() - beg) / nrScopes;
+		std::cout << "Profile scope overhead: " << perScope << " ns per scope\n";
+		{
+			AutoProfiler timer{ "De Bruigin build" };
+			for (int order = 10; order <= 16; ++order) {
+				BGLX_PROFILE_SCOPE("make_De_Bruigin_graph");
+				make_De_Bruigin_graph(order);
+			}
+		}
+		Profiler::instance().report(std::cout);
+		std::cout << std::endl;
+	}
+}
@@ -0,0 +1,249 @@
+#pragma once
+#include "CsrGraph.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace bglx::test
+{
+	enum class DegreeDistribution
+	{
+		//every cycle vertex is drawn uniformly, degrees are close to nrEdges / nrVertices
+		Uniform,
+		//vertex of rank r is drawn with weight (r + 1)^(-1 / (exponent - 1)), so degrees follow a power
+		//law with the given exponent (Chung-Lu)
+		PowerLaw,
+		//hubEdgeShare of the cycle vertices are drawn from the hubFraction highest ranked vertices
+		Hubs
+	};
+
+	//random Eulerian digraph: a Hamiltonian cycle over a random permutation, which makes it strongly
+	//connected, plus random cycles of 2..maxCycleLength vertices until there are nrEdges edges. every
+	//cycle adds one in- and one out-edge to each of its vertices, so in-degree equals out-degree.
+	//the result only depends on seed, not on nrThreads.
+	struct RandomEulerOptions
+	{
+		std::size_t nrVertices = 1024;
+		//at least nrVertices, and the edges beyond the Hamiltonian cycle must not be exactly one
+		std::size_t nrEdges = 4096;
+		DegreeDistribution distribution = DegreeDistribution::Uniform;
+		double powerLawExponent = 2.1;
+		double hubFraction = 0.001;
+		double hubEdgeShare = 0.5;
+		std::size_t maxCycleLength = 64;
+		std::uint64_t seed = 1;
+		unsigned nrThreads = 0;
+		//no parallel edges: every repeat of an edge u -> v is routed through a new vertex, u -> w -> v,
+		//which keeps the graph Eulerian but adds vertices. needed for setS graphs such as Dag.
+		bool simple = false;
+	};
+
+	namespace detail
+	{
+		//seeds of the per-chunk generators, so neighbouring chunks do not get correlated streams
+		static std::uint64_t split_mix(std::uint64_t x)
+		{
+			x += 0x9E3779B97F4A7C15ull;
+			x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+			x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+			return x ^ (x >> 31);
+		}
+
+		//draws vertices of the requested distribution in O(1): a rank by the distribution, the power law
+		//by inverting the continuous weight integral instead of keeping a table of nrVertices weights, and
+		//the vertex rank * stride + offset (mod n), a random permutation that needs no lookup table
+		class VertexSampler
+		{
+		public:
+			VertexSampler(const RandomEulerOptions& options, std::mt19937_64& rng)
+				: m_options(options), m_n(static_cast<double>(options.nrVertices))
+			{
+				auto n = options.nrVertices;
+				m_offset = rng() % n;
+				do {
+					m_stride = rng() % n;
+				} while (std::gcd(m_stride, n) != 1);
+				if (options.distribution == DegreeDistribution::PowerLaw) {
+					if (options.powerLawExponent <= 1.0)
+						throw std::invalid_argument("The power law exponent must be above 1.");
+					m_power = 1.0 - 1.0 / (options.powerLawExponent - 1.0);
+					m_range = std::abs(m_power) < 1e-9 ? std::log(m_n + 1) : std::pow(m_n + 1, m_power) - 1.0;
+				}
+				auto nrHubs = static_cast<std::size_t>(options.hubFraction * options.nrVertices);
+				//at least three hubs, so that a cycle drawn from hubs only can always be closed
+				m_nrHubs = std::min(std::max<std::size_t>(nrHubs, 3), options.nrVertices);
+			}
+
+			template <class Rng>
+			std::uint32_t operator()(Rng& rng) const
+			{
+				return static_cast<std::uint32_t>((rank(rng) * m_stride + m_offset) % m_options.nrVertices);
+			}
+
+			//any vertex with equal probability, whatever the distribution
+			template <class Rng>
+			std::uint32_t uniform(Rng& rng) const
+			{
+				return static_cast<std::uint32_t>(rng() % m_options.nrVertices);
+			}
+
+		private:
+			template <class Rng>
+			std::size_t rank(Rng& rng) const
+			{
+				//53 random bits scaled to [0, 1); the distribution objects cost more than the whole draw
+				auto unit = [&rng] { return static_cast<double>(rng() >> 11) * (1.0 / 9007199254740992.0); };
+				auto uniform = [&unit](std::size_t n) { return static_cast<std::size_t>(unit() * static_cast<double>(n)); };
+				switch (m_options.distribution) {
+				case DegreeDistribution::PowerLaw: {
+					auto u = unit();
+					auto x = std::abs(m_power) < 1e-9 ? std::exp(u * m_range) : std::pow(u * m_range + 1.0, 1.0 / m_power);
+					return std::min(static_cast<std::size_t>(x) - 1, m_options.nrVertices - 1);
+				}
+				case DegreeDistribution::Hubs:
+					if (unit() < m_options.hubEdgeShare)
+						return uniform(m_nrHubs);
+					return uniform(m_options.nrVertices);
+				default:
+					return uniform(m_options.nrVertices);
+				}
+			}
+
+			const RandomEulerOptions& m_options;
+			double m_n;
+			double m_power = 0;
+			double m_range = 0;
+			std::size_t m_nrHubs = 3;
+			std::size_t m_stride = 1;
+			std::size_t m_offset = 0;
+		};
+
+		//appends random closed walks with exactly nrEdges edges in total; no self-loops
+		template <class Rng>
+		static void append_random_cycles(std::size_t nrEdges, std::size_t maxCycleLength,
+			const VertexSampler& sample, Rng& rng, std::vector<std::pair<std::uint32_t, std::uint32_t>>& edges)
+		{
+			constexpr int MaxRedraws = 64;
+			auto length = std::uniform_int_distribution<std::size_t>{ 2, std::max<std::size_t>(maxCycleLength, 2) };
+			while (nrEdges > 0) {
+				auto cycleLength = length(rng);
+				if (cycleLength + 2 > nrEdges)
+					cycleLength = nrEdges;
+				nrEdges -= cycleLength;
+				auto first = sample(rng);
+				auto prev = first;
+				for (std::size_t i = 1; i < cycleLength; ++i) {
+					auto next = prev;
+					//the last vertex has to differ from the first one as well, to close without a self-loop.
+					//a power law close to exponent 1 puts almost all weight on one vertex, so after a few
+					//misses the vertex is drawn uniformly, which needs about one more draw on 3+ vertices
+					auto misses = 0;
+					while (next == prev || (i + 1 == cycleLength && next == first))
+						next = ++misses <= MaxRedraws ? sample(rng) : sample.uniform(rng);
+					edges.emplace_back(prev, next);
+					prev = next;
+				}
+				edges.emplace_back(prev, first);
+			}
+		}
+	}
+
+	static CsrGraph make_random_euler_csr(const RandomEulerOptions& options)
+	{
+		using EdgeList = std::vector<std::pair<std::uint32_t, std::uint32_t>>;
+		auto nrVertices = options.nrVertices;
+		if (nrVertices == 0 || nrVertices > std::numeric_limits<std::uint32_t>::max())
+			throw std::invalid_argument("Random Euler graphs need 1 to 2^32 - 1 vertices.");
+		if (options.nrEdges < nrVertices)
+			throw std::invalid_argument("Random Euler graphs need at least one edge per vertex.");
+		auto nrCycleEdges = options.nrEdges - nrVertices;
+		if (nrCycleEdges == 1 || (nrCycleEdges > 0 && nrVertices < 3))
+			throw std::invalid_argument("The edges beyond the Hamiltonian cycle cannot form cycles without self-loops.");
+		auto nrThreads = options.nrThreads == 0 ? default_thread_count() : options.nrThreads;
+
+		auto rng = std::mt19937_64{ detail::split_mix(options.seed) };
+		std::vector<std::uint32_t> order(nrVertices);
+		std::iota(order.begin(), order.end(), 0);
+		std::shuffle(order.begin(), order.end(), rng);
+		auto sample = detail::VertexSampler{ options, rng };
+
+		//chunk 0 is the Hamiltonian cycle, the rest are fixed-size slices of the cycle edges with their
+		//own seeds, so the chunking and the result are the same for every thread count
+		constexpr std::size_t EdgesPerChunk = 1 << 20;
+		auto nrCycleChunks = nrCycleEdges == 0 ? std::size_t{ 0 } : std::max<std::size_t>(1, nrCycleEdges / EdgesPerChunk);
+		std::vector<EdgeList> chunks(nrCycleChunks + 1);
+		chunks[0].reserve(nrVertices);
+		for (std::size_t i = 0; i < nrVertices; ++i)
+			chunks[0].emplace_back(order[i], order[(i + 1) % nrVertices]);
+		order = {};
+		parallel_for(nrCycleChunks, nrThreads, [&](std::size_t c) {
+			auto budget = c + 1 == nrCycleChunks ? nrCycleEdges - c * EdgesPerChunk : EdgesPerChunk;
+			auto chunkRng = std::mt19937_64{ detail::split_mix(options.seed ^ detail::split_mix(c + 1)) };
+			chunks[c + 1].reserve(budget);
+			detail::append_random_cycles(budget, options.maxCycleLength, sample, chunkRng, chunks[c + 1]);
+		});
+
+		auto storage = CsrStorage{};
+		storage.targets = detail::scatter_rows_by_owner<std::uint32_t>(nrVertices, chunks.size(), [&](std::size_t c, auto&& emit) {
+			for (auto& edge : chunks[c])
+				emit(edge.first, edge.second);
+		}, nrThreads, storage.offsets);
+		chunks.clear();
+		if (!options.simple)
+			return CsrGraph{ std::move(storage) };
+
+		//sort every row and give each repeated target a new vertex: u -> w replaces the repeat and
+		//w -> v gets a row of its own after the original vertices
+		auto repeats = std::vector<std::uint64_t>(nrVertices + 1, 0);
+		parallel_chunks(nrVertices, nrThreads, [&](unsigned, std::size_t begin, std::size_t end) {
+			for (auto v = begin; v < end; ++v) {
+				auto first = storage.targets.begin() + storage.offsets[v];
+				auto last = storage.targets.begin() + storage.offsets[v + 1];
+				std::sort(first, last);
+				for (auto it = first; it != last; ++it)
+					repeats[v + 1] += it != first && *it == *(it - 1);
+			}
+		});
+		for (std::size_t v = 0; v < nrVertices; ++v)
+			repeats[v + 1] += repeats[v];
+		auto nrRepeats = static_cast<std::size_t>(repeats[nrVertices]);
+		if (nrRepeats == 0)
+			return CsrGraph{ std::move(storage) };
+		if (nrVertices + nrRepeats > std::numeric_limits<std::uint32_t>::max())
+			throw std::invalid_argument("Too many vertices after splitting parallel edges.");
+		storage.offsets.resize(nrVertices + nrRepeats + 1);
+		for (std::size_t w = 0; w < nrRepeats; ++w)
+			storage.offsets[nrVertices + w + 1] = options.nrEdges + w + 1;
+		storage.targets.resize(options.nrEdges + nrRepeats);
+		parallel_chunks(nrVertices, nrThreads, [&](unsigned, std::size_t begin, std::size_t end) {
+			for (auto v = begin; v < end; ++v) {
+				auto w = nrVertices + repeats[v];
+				auto prev = std::numeric_limits<std::uint64_t>::max();
+				for (auto i = storage.offsets[v]; i < storage.offsets[v + 1]; ++i) {
+					auto target = storage.targets[i];
+					if (target != prev) {
+						prev = target;
+						continue;
+					}
+					storage.targets[options.nrEdges + (w - nrVertices)] = target;
+					storage.targets[i] = static_cast<std::uint32_t>(w++);
+				}
+			}
+		});
+		return CsrGraph{ std::move(storage) };
+	}
+
+	//make_random_euler_csr with options.simple forced, copied into a Dag
+	static Dag make_random_euler_dag(RandomEulerOptions options)
+	{
+		options.simple = true;
+		return make_dag(make_random_euler_csr(options));
+	}
+}
@@ -0,0 +1,390 @@
+#pragma once
+#include "CsrGraph.h"
+#include "GraphSnapshot.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include "TopologicalSort.h"
+#include <boost/endian/conversion.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bglx::test
+{
+	struct ReachabilityOptions
+	{
+		//random interval labelings per vertex; more of them answer more negative queries without a search
+		unsigned nrLabels = 4;
+		std::uint64_t seed = 1;
+		unsigned nrThreads = 0;
+	};
+
+	//labels behind an in-memory ReachabilityIndex
+	struct ReachabilityStorage
+	{
+		std::size_t nrLabels = 0;
+		std::vector<std::uint32_t> level;
+		std::vector<std::uint32_t> intervals;
+	};
+
+	//visit marks of the fallback search. one per thread, reusable across queries and indexes.
+	class ReachabilitySearch
+	{
+	public:
+		void begin(std::size_t nrVertices)
+		{
+			if (m_mark.size() < nrVertices)
+				m_mark.resize(nrVertices, 0);
+			if (++m_epoch == 0) {
+				std::fill(m_mark.begin(), m_mark.end(), 0);
+				m_epoch = 1;
+			}
+			m_stack.clear();
+		}
+
+		//true the first time v is seen in this search
+		bool visit(std::size_t v)
+		{
+			if (m_mark[v] == m_epoch)
+				return false;
+			m_mark[v] = m_epoch;
+			return true;
+		}
+
+		std::vector<std::uint32_t>& stack() { return m_stack; }
+
+	private:
+		std::vector<std::uint32_t> m_mark;
+		std::uint32_t m_epoch = 0;
+		std::vector<std::uint32_t> m_stack;
+	};
+
+	//"can u reach v" on a static Dag (GRAIL, Yildirim et al.). every vertex gets its topological level
+	//and nrLabels intervals [low, post] from randomized depth-first traversals; u reaches v only if
+	//level[u] < level[v] and each interval of v lies in the one of u. most negative queries stop there,
+	//the others run a depth-first search that skips every vertex whose labels already rule v out, so
+	//answers are exact. all arrays are flat and read-only: the index is built in memory or mapped from
+	//a file written by write_reachability_index, like CsrGraph and its snapshots.
+	class ReachabilityIndex
+	{
+	public:
+		struct Arrays
+		{
+			std::size_t nrVertices = 0;
+			std::size_t nrLabels = 0;
+			const std::uint32_t* level = nullptr;
+			//(low, post) pairs, nrLabels per vertex, vertex after vertex so a check reads one contiguous run
+			const std::uint32_t* intervals = nullptr;
+		};
+
+		ReachabilityIndex() : ReachabilityIndex(ReachabilityStorage{}, CsrGraph{}) { }
+
+		//graph is the one the labels were computed for; CsrGraph copies share their arrays
+		ReachabilityIndex(ReachabilityStorage storage, CsrGraph graph) : m_graph(std::move(graph))
+		{
+			auto owner = std::make_shared<const ReachabilityStorage>(std::move(storage));
+			m_arrays.nrVertices = owner->level.size();
+			m_arrays.nrLabels = owner->nrLabels;
+			m_arrays.level = owner->level.data();
+			m_arrays.intervals = owner->intervals.data();
+			m_owner = std::move(owner);
+		}
+
+		ReachabilityIndex(const Arrays& arrays, CsrGraph graph, std::shared_ptr<const void> owner)
+			: m_arrays(arrays), m_graph(std::move(graph)), m_owner(std::move(owner)) { }
+
+		const Arrays& arrays() const { return m_arrays; }
+		//the out-edges the fallback search runs on
+		const CsrGraph& graph() const { return m_graph; }
+
+		//bytes of the labels and the rows, whether they are in memory or mapped
+		std::size_t memory_bytes() const
+		{
+			auto n = m_arrays.nrVertices;
+			return (n + 2 * n * m_arrays.nrLabels) * sizeof(std::uint32_t)
+				+ (n + 1) * sizeof(std::uint64_t) + m_graph.nr_edges() * sizeof(std::uint32_t);
+		}
+
+		//false when the labels prove that u cannot reach v
+		bool may_reach(std::size_t u, std::size_t v) const
+		{
+			if (m_arrays.level[u] >= m_arrays.level[v])
+				return false;
+			auto k = m_arrays.nrLabels;
+			auto from = m_arrays.intervals + 2 * k * u;
+			auto to = m_arrays.intervals + 2 * k * v;
+			for (std::size_t i = 0; i < 2 * k; i += 2) {
+				if (to[i] < from[i] || to[i + 1] > from[i + 1])
+					return false;
+			}
+			return true;
+		}
+
+		//thread safe; search holds the visit marks and must not be shared between threads
+		bool reachable(std::size_t u, std::size_t v, ReachabilitySearch& search) const
+		{
+			if (u == v)
+				return true;
+			if (!may_reach(u, v))
+				return false;
+			auto& a = m_graph.arrays();
+			search.begin(m_arrays.nrVertices);
+			auto& stack = search.stack();
+			stack.push_back(static_cast<std::uint32_t>(u));
+			while (!stack.empty()) {
+				auto x = stack.back();
+				stack.pop_back();
+				for (auto e = a.offsets[x]; e < a.offsets[x + 1]; ++e) {
+					auto w = a.targets[e];
+					if (w == v)
+						return true;
+					if (may_reach(w, v) && search.visit(w))
+						stack.push_back(w);
+				}
+			}
+			return false;
+		}
+
+		//uses a search of the calling thread
+		bool reachable(std::size_t u, std::size_t v) const
+		{
+			thread_local ReachabilitySearch search;
+			return reachable(u, v, search);
+		}
+
+	private:
+		Arrays m_arrays;
+		CsrGraph m_graph;
+		std::shared_ptr<const void> m_owner;
+	};
+
+	namespace detail
+	{
+		//one randomized traversal: roots and children are taken in random order, post is the post-order
+		//rank from 1 and low the smallest rank below a vertex, so v reachable from u has low[u] <= low[v]
+		//and post[v] < post[u]. iterative, every vertex is pushed once.
+		inline void label_reachability_intervals(const CsrGraph& g, const std::vector<std::uint32_t>& roots,
+			std::uint64_t seed, std::vector<std::uint32_t>& low, std::vector<std::uint32_t>& post)
+		{
+			struct Frame
+			{
+				std::uint32_t v;
+				std::uint64_t next;
+				std::uint64_t left;
+			};
+			auto rng = std::mt19937_64{ seed };
+			auto& a = g.arrays();
+			auto order = roots;
+			std::shuffle(order.begin(), order.end(), rng);
+			low.assign(a.nrVertices, 0);
+			post.assign(a.nrVertices, 0);
+			std::vector<char> seen(a.nrVertices, 0);
+			std::vector<Frame> stack;
+			auto rank = std::uint32_t{ 0 };
+			auto push = [&](std::uint32_t v) {
+				seen[v] = 1;
+				auto degree = a.offsets[v + 1] - a.offsets[v];
+				//children in a random rotation, which is as good as a shuffle for the labels
+				auto first = degree == 0 ? 0 : rng() % degree;
+				stack.push_back({ v, first, degree });
+				low[v] = std::numeric_limits<std::uint32_t>::max();
+			};
+			for (auto root : order) {
+				push(root);
+				while (!stack.empty()) {
+					auto& frame = stack.back();
+					if (frame.left == 0) {
+						auto v = frame.v;
+						post[v] = ++rank;
+						low[v] = std::min(low[v], post[v]);
+						stack.pop_back();
+						if (!stack.empty())
+							low[stack.back().v] = std::min(low[stack.back().v], low[v]);
+						continue;
+					}
+					auto degree = a.offsets[frame.v + 1] - a.offsets[frame.v];
+					auto w = a.targets[a.offsets[frame.v] + frame.next];
+					frame.next = frame.next + 1 == degree ? 0 : frame.next + 1;
+					--frame.left;
+					if (seen[w])
+						low[frame.v] = std::min(low[frame.v], low[w]);
+					else
+						push(w);
+				}
+			}
+		}
+
+		inline ReachabilityIndex build_reachability_index(CsrGraph graph, const ReachabilityOptions& options)
+		{
+			auto nrThreads = options.nrThreads == 0 ? default_thread_count() : options.nrThreads;
+			auto nrVertices = graph.nr_vertices();
+			auto k = std::max(1u, options.nrLabels);
+			auto levels = topological_levels(graph, nrThreads);
+			if (!levels.is_acyclic())
+				throw std::invalid_argument("A reachability index needs an acyclic graph.");
+			auto storage = ReachabilityStorage{};
+			storage.nrLabels = k;
+			storage.level = std::move(levels.level);
+			auto& roots = levels.order;
+			roots.resize(levels.levelOffsets.size() > 1 ? levels.levelOffsets[1] : 0);
+
+			//the labelings run in parallel into their own arrays, which are then interleaved per vertex
+			std::vector<std::vector<std::uint32_t>> low(k), post(k);
+			parallel_for(k, std::min(k, nrThreads), [&](std::size_t i) {
+				label_reachability_intervals(graph, roots, options.seed ^ (0x9E3779B97F4A7C15ull * (i + 1)), low[i], post[i]);
+			});
+			storage.intervals.resize(2 * k * nrVertices);
+			parallel_chunks(nrVertices, nrVertices < (1 << 14) ? 1u : nrThreads, [&](unsigned, std::size_t begin, std::size_t end) {
+				for (auto v = begin; v < end; ++v) {
+					for (std::size_t i = 0; i < k; ++i) {
+						storage.intervals[2 * (k * v + i)] = low[i][v];
+						storage.intervals[2 * (k * v + i) + 1] = post[i][v];
+					}
+				}
+			});
+			return ReachabilityIndex{ std::move(storage), std::move(graph) };
+		}
+	}
+
+	//builds the index for an acyclic graph with vertices numbered 0..n-1 (Dag and the other vecS
+	//graphs, CsrGraph); throws std::invalid_argument on a cycle. the index keeps the out-edges as
+	//CSR rows for its searches, a CsrGraph is shared rather than copied.
+	template <class Graph>
+	ReachabilityIndex make_reachability_index(const Graph& g, const ReachabilityOptions& options = {})
+	{
+		return detail::build_reachability_index(CsrGraph{ make_csr_topology(g, options.nrThreads) }, options);
+	}
+
+	inline ReachabilityIndex make_reachability_index(const CsrGraph& g, const ReachabilityOptions& options = {})
+	{
+		return detail::build_reachability_index(g, options);
+	}
+
+	//binary reachability index, version 1, little-endian, laid out like a graph snapshot:
+	//  [0, 128)  ReachabilityHeader
+	//  sections  offsets (u64 x n+1), targets (u32 x m), levels (u32 x n), intervals (u32 x 2kn)
+	//every section starts on a 64 byte boundary and is used in place once mapped.
+	constexpr std::uint32_t ReachabilityVersion = 1;
+
+	enum ReachabilitySectionId
+	{
+		ReachabilityOffsets,
+		ReachabilityTargets,
+		ReachabilityLevels,
+		ReachabilityIntervals,
+		ReachabilitySectionCount
+	};
+
+	struct ReachabilityHeader
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t nrLabels;
+		std::uint64_t nrVertices;
+		std::uint64_t nrEdges;
+		SnapshotSection sections[ReachabilitySectionCount];
+		std::uint64_t reserved[4];
+	};
+	static_assert(sizeof(ReachabilityHeader) % SnapshotAlignment == 0, "sections must stay aligned");
+
+	constexpr char ReachabilityMagic[8] = { 'B', 'G', 'L', 'X', 'R', 'C', 'H', '\0' };
+
+	static void write_reachability_index(const ReachabilityIndex& index, const std::string& path)
+	{
+		auto& a = index.arrays();
+		auto& rows = index.graph().arrays();
+		auto header = ReachabilityHeader{};
+		std::memcpy(header.magic, ReachabilityMagic, sizeof(ReachabilityMagic));
+		header.version = ReachabilityVersion;
+		header.nrLabels = static_cast<std::uint32_t>(a.nrLabels);
+		header.nrVertices = a.nrVertices;
+		header.nrEdges = rows.nrEdges;
+
+		std::uint64_t sizes[ReachabilitySectionCount] = {
+			(a.nrVertices + 1) * sizeof(std::uint64_t),
+			rows.nrEdges * sizeof(std::uint32_t),
+			a.nrVertices * sizeof(std::uint32_t),
+			2 * a.nrLabels * a.nrVertices * sizeof(std::uint32_t)
+		};
+		auto pos = std::uint64_t{ sizeof(ReachabilityHeader) };
+		for (int s = 0; s < ReachabilitySectionCount; ++s) {
+			header.sections[s] = { detail::align_up(pos), sizes[s] };
+			pos = header.sections[s].offset + sizes[s];
+		}
+
+		auto out = std::ofstream(path, std::ios::binary | std::ios::trunc);
+		if (!out)
+			throw std::runtime_error("Can not open " + path + " for writing.");
+		auto leHeader = header;
+		boost::endian::native_to_little_inplace(leHeader.version);
+		boost::endian::native_to_little_inplace(leHeader.nrLabels);
+		boost::endian::native_to_little_inplace(leHeader.nrVertices);
+		boost::endian::native_to_little_inplace(leHeader.nrEdges);
+		for (auto& section : leHeader.sections) {
+			boost::endian::native_to_little_inplace(section.offset);
+			boost::endian::native_to_little_inplace(section.size);
+		}
+		out.write(reinterpret_cast<const char*>(&leHeader), sizeof(leHeader));
+
+		static const char padding[SnapshotAlignment] = {};
+		auto written = std::uint64_t{ sizeof(ReachabilityHeader) };
+		auto section = [&](ReachabilitySectionId id, auto* data, std::size_t count) {
+			out.write(padding, header.sections[id].offset - written);
+			detail::write_le_array(out, data, count);
+			written = header.sections[id].offset + header.sections[id].size;
+		};
+		section(ReachabilityOffsets, rows.offsets, a.nrVertices + 1);
+		section(ReachabilityTargets, rows.targets, rows.nrEdges);
+		section(ReachabilityLevels, a.level, a.nrVertices);
+		section(ReachabilityIntervals, a.intervals, 2 * a.nrLabels * a.nrVertices);
+		out.write(padding, detail::align_up(written) - written);
+		if (!out)
+			throw std::runtime_error("Writing " + path + " failed.");
+	}
+
+	//maps an index file without copying; the mapping lives as long as the index and its graph().
+	//the header, section bounds and graph rows are checked like load_snapshot does, the labels are trusted.
+	static ReachabilityIndex load_reachability_index(const std::string& path,
+		SnapshotValidation validation = SnapshotValidation::Full)
+	{
+		if constexpr (!detail::NativeIsLittle)
+			throw std::runtime_error("Reachability indexes can only be mapped on little-endian hosts.");
+
+		auto file = std::make_shared<const MappedFile>(path);
+		auto fail = [&path](const char* what) { throw std::runtime_error(path + ": " + what); };
+		if (file->size() < sizeof(ReachabilityHeader))
+			fail("too small for a reachability index header.");
+		auto header = ReachabilityHeader{};
+		std::memcpy(&header, file->data(), sizeof(header));
+		if (std::memcmp(header.magic, ReachabilityMagic, sizeof(ReachabilityMagic)) != 0)
+			fail("not a reachability index.");
+		if (header.version != ReachabilityVersion)
+			fail("unsupported reachability index version.");
+
+		detail::check_sections(header.sections, ReachabilitySectionCount, file->size(), fail);
+		auto n = header.nrVertices;
+		auto rows = detail::map_csr_rows(*file, header.sections[ReachabilityOffsets], header.sections[ReachabilityTargets], n,
+			header.nrEdges, validation, fail);
+		//n is bounded by the file size now, the label count is bounded the same way before the product
+		if (n != 0 && header.nrLabels > file->size() / sizeof(std::uint32_t) / 2 / n)
+			fail("label count too large for the file.");
+		if (header.sections[ReachabilityLevels].size != n * sizeof(std::uint32_t)
+			|| header.sections[ReachabilityIntervals].size != 2 * std::uint64_t{ header.nrLabels } * n * sizeof(std::uint32_t))
+			fail("section size does not match the vertex/edge/label count.");
+
+		auto at = [&](ReachabilitySectionId id) { return file->data() + header.sections[id].offset; };
+		auto arrays = ReachabilityIndex::Arrays{};
+		arrays.nrVertices = static_cast<std::size_t>(n);
+		arrays.nrLabels = header.nrLabels;
+		arrays.level = reinterpret_cast<const std::uint32_t*>(at(ReachabilityLevels));
+		arrays.intervals = reinterpret_cast<const std::uint32_t*>(at(ReachabilityIntervals));
+		return ReachabilityIndex{ arrays, CsrGraph{ rows, file }, file };
+	}
+}
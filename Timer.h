@@ -1,19 +1,564 @@
 #pragma once
+#include "AllocationTracker.h"
+#include "ProcessMemory.h"
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <chrono>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <utility>
+#include <vector>
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//set BGLX_PROFILING to 0 to compile scope recording out; AutoProfiler then only prints its own line
+#ifndef BGLX_PROFILING
+#define BGLX_PROFILING 1
+#endif
+
+namespace bglx::test
+{
+	//one finished scope. begin/end are profile_ticks() while recorded and nanoseconds once reported,
+	//depth is the number of enclosing scopes of the same thread.
+	//name must outlive the report, use a literal or Profiler::intern.
+	struct ProfileEvent
+	{
+		const char* name;
+		std::uint32_t depth;
+		std::int64_t begin;
+		std::int64_t end;
+	};
+	//name, depth padded to 8 bytes and the two stamps: what every ProfileScope writes to the ring
+	static_assert(sizeof(void*) != 8 || sizeof(ProfileEvent) == 32, "ProfileEvent is one 32 byte store");
+
+	//nanoseconds of the steady clock
+	inline std::int64_t profile_now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	//what scopes are stamped with: the time stamp counter on x86, which is about half the cost of a
+	//steady clock read, or steady clock nanoseconds elsewhere. Profiler converts ticks back to ns.
+	inline std::int64_t profile_ticks()
+	{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+		return static_cast<std::int64_t>(__rdtsc());
+#else
+		return profile_now();
+#endif
+	}
+
+	//the most recent finished scopes of one thread; older ones are overwritten once it is full.
+	//only the owning thread writes it, reports read it while no scope is being recorded.
+	class ProfileRing
+	{
+	public:
+		static constexpr std::size_t Capacity = std::size_t{ 1 } << 16;
+
+		void push(const ProfileEvent& event) { m_events[m_next++ & (Capacity - 1)] = event; }
+
+		//oldest first
+		std::vector<ProfileEvent> events() const
+		{
+			auto nrKept = std::min<std::uint64_t>(m_next, Capacity);
+			std::vector<ProfileEvent> events;
+			events.reserve(static_cast<std::size_t>(nrKept));
+			for (auto i = m_next - nrKept; i < m_next; ++i)
+				events.push_back(m_events[i & (Capacity - 1)]);
+			return events;
+		}
+
+		std::uint64_t dropped() const { return m_next > Capacity ? m_next - Capacity : 0; }
+		void clear() { m_next = 0; }
+
+		//scopes currently open on the owning thread
+		std::uint32_t depth = 0;
+
+	private:
+		std::unique_ptr<ProfileEvent[]> m_events = std::make_unique<ProfileEvent[]>(Capacity);
+		std::uint64_t m_next = 0;
+	};
+
+	//a node of the aggregated call tree: every scope with the same name under the same parent
+	struct ProfileNode
+	{
+		std::string_view name;
+		std::size_t parent;
+		std::uint32_t depth;
+		std::vector<std::size_t> children;
+		std::vector<std::int64_t> durations;
+	};
+
+	struct ProfileStats
+	{
+		std::size_t count = 0;
+		std::int64_t total = 0;
+		std::int64_t min = 0;
+		std::int64_t max = 0;
+		std::int64_t p50 = 0;
+		std::int64_t p99 = 0;
+	};
+
+	//nearest-rank percentiles over the durations of one node
+	static ProfileStats profile_stats(std::vector<std::int64_t> durations)
+	{
+		auto stats = ProfileStats{};
+		if (durations.empty())
+			return stats;
+		std::sort(durations.begin(), durations.end());
+		auto rank = [&durations](double p) {
+			auto r = static_cast<std::size_t>(std::ceil(p * durations.size()));
+			return durations[std::max<std::size_t>(r, 1) - 1];
+		};
+		stats.count = durations.size();
+		for (auto d : durations)
+			stats.total += d;
+		stats.min = durations.front();
+		stats.max = durations.back();
+		stats.p50 = rank(0.50);
+		stats.p99 = rank(0.99);
+		return stats;
+	}
+
+	//rebuilds the nesting of one thread's events from their begin times and depths. node 0 is the root,
+	//children keep the order they were first entered in. scopes whose parent was still open, or got
+	//overwritten in the ring, hang off the deepest enclosing scope that is known.
+	static std::vector<ProfileNode> build_profile_tree(std::vector<ProfileEvent> events)
+	{
+		std::sort(events.begin(), events.end(), [](const ProfileEvent& a, const ProfileEvent& b) {
+			return a.begin != b.begin ? a.begin < b.begin : a.depth < b.depth;
+		});
+		std::vector<ProfileNode> nodes(1, ProfileNode{ {}, 0, 0, {}, {} });
+		std::map<std::pair<std::size_t, std::string_view>, std::size_t> byParentAndName;
+		//open scopes as (node, depth, end)
+		struct Open { std::size_t node; std::uint32_t depth; std::int64_t end; };
+		std::vector<Open> stack;
+		for (auto& event : events) {
+			while (!stack.empty() && (stack.back().depth >= event.depth || stack.back().end < event.end))
+				stack.pop_back();
+			auto parent = stack.empty() ? std::size_t{ 0 } : stack.back().node;
+			auto key = std::make_pair(parent, std::string_view{ event.name });
+			auto found = byParentAndName.find(key);
+			if (found == byParentAndName.end()) {
+				found = byParentAndName.emplace(key, nodes.size()).first;
+				nodes[parent].children.push_back(nodes.size());
+				nodes.push_back(ProfileNode{ key.second, parent, nodes[parent].depth + 1, {}, {} });
+			}
+			nodes[found->second].durations.push_back(event.end - event.begin);
+			stack.push_back({ found->second, event.depth, event.end });
+		}
+		return nodes;
+	}
+
+	//ns, us, ms or s with three decimals
+	static std::string format_duration(std::int64_t ns)
+	{
+		std::ostringstream text;
+		if (ns < 1000)
+			text << ns << " ns";
+		else {
+			const char* unit = ns < 1000000 ? " us" : ns < 1000000000 ? " ms" : " s";
+			auto scale = ns < 1000000 ? 1e3 : ns < 1000000000 ? 1e6 : 1e9;
+			text << std::fixed << std::setprecision(3) << ns / scale << unit;
+		}
+		return text.str();
+	}
+
+	static void print_profile_tree(std::ostream& out, const std::vector<ProfileNode>& nodes)
+	{
+		auto width = std::size_t{ 5 };
+		for (std::size_t i = 1; i < nodes.size(); ++i)
+			width = std::max(width, 2 * (nodes[i].depth - 1) + nodes[i].name.size());
+		out << "  " << std::left << std::setw(width) << "scope" << std::right;
+		for (auto column : { "count", "total", "min", "max", "p50", "p99" })
+			out << std::setw(13) << column;
+		out << '\n';
+		auto print = [&](std::size_t node, auto& self) -> void {
+			if (node != 0) {
+				auto& n = nodes[node];
+				auto stats = profile_stats(n.durations);
+				out << "  " << std::string(2 * (n.depth - 1), ' ') << std::left
+					<< std::setw(width - 2 * (n.depth - 1)) << n.name << std::right << std::setw(13) << stats.count;
+				for (auto value : { stats.total, stats.min, stats.max, stats.p50, stats.p99 })
+					out << std::setw(13) << format_duration(value);
+				out << '\n';
+			}
+			for (auto child : nodes[node].children)
+				self(child, self);
+		};
+		print(0, print);
+	}
+
+	//owns the rings of all threads that recorded scopes. a thread takes a ring on its first scope and
+	//hands it back when it exits, so thread pools that come and go reuse rings instead of piling them up.
+	class Profiler
+	{
+	public:
+		static Profiler& instance()
+		{
+			static Profiler profiler;
+			return profiler;
+		}
+
+		ProfileRing* acquire_ring()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!m_free.empty()) {
+				auto ring = m_free.back();
+				m_free.pop_back();
+				return ring;
+			}
+			m_rings.push_back(std::make_unique<ProfileRing>());
+			return m_rings.back().get();
+		}
+
+		void release_ring(ProfileRing* ring)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			ring->depth = 0;
+			m_free.push_back(ring);
+		}
+
+		//a name with program lifetime, for scope names built at run time
+		const char* intern(const std::string& name)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_names.insert(name).first->c_str();
+		}
+
+		//nanoseconds per profile tick, measured once against the steady clock on the first call: over the
+		//time since the profiler was created, which is stretched to 2 ms if it is shorter. the ticks run
+		//at a fixed rate, so later calls return the cached ratio without waiting.
+		double ns_per_tick() const
+		{
+			std::call_once(m_calibrated, [this] {
+				auto ns = profile_now();
+				while (ns - m_createdNs < 2000000)
+					ns = profile_now();
+				auto ticks = profile_ticks();
+				m_nsPerTick = ticks == m_createdTicks ? 1.0 : double(ns - m_createdNs) / double(ticks - m_createdTicks);
+			});
+			return m_nsPerTick;
+		}
+
+		//one call tree per ring. call it while no other thread is recording.
+		void report(std::ostream& out)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto nsPerTick = ns_per_tick();
+			for (std::size_t r = 0; r < m_rings.size(); ++r) {
+				auto events = m_rings[r]->events();
+				if (events.empty())
+					continue;
+				for (auto& event : events) {
+					event.begin = std::llround((event.begin - m_createdTicks) * nsPerTick);
+					event.end = std::llround((event.end - m_createdTicks) * nsPerTick);
+				}
+				out << "profile of thread slot " << r << ", " << events.size() << " scopes";
+				if (auto dropped = m_rings[r]->dropped())
+					out << " (" << dropped << " older scopes overwritten)";
+				out << '\n';
+				print_profile_tree(out, build_profile_tree(std::move(events)));
+			}
+		}
+
+		//forgets all recorded scopes. call it while no other thread is recording.
+		void reset()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (auto& ring : m_rings)
+				ring->clear();
+		}
+
+	private:
+		Profiler() : m_createdNs(profile_now()), m_createdTicks(profile_ticks()) { }
+
+		std::int64_t m_createdNs;
+		std::int64_t m_createdTicks;
+		mutable std::once_flag m_calibrated;
+		mutable double m_nsPerTick = 1.0;
+		std::mutex m_mutex;
+		std::vector<std::unique_ptr<ProfileRing>> m_rings;
+		std::vector<ProfileRing*> m_free;
+		std::set<std::string> m_names;
+	};
+
+	//inline rather than static: every translation unit has to see the same ring of a thread
+	inline ProfileRing& this_thread_ring()
+	{
+		struct Holder
+		{
+			ProfileRing* ring = Profiler::instance().acquire_ring();
+			~Holder() { Profiler::instance().release_ring(ring); }
+		};
+		thread_local Holder holder;
+		return *holder.ring;
+	}
+
+#if BGLX_PROFILING
+	//records the time between construction and destruction into the ring of the current thread.
+	//two time stamp counter reads and a 32 byte store, meant for scopes that run millions of times.
+	class ProfileScope
+	{
+	public:
+		explicit ProfileScope(const char* name)
+			: m_ring(this_thread_ring()), m_name(name), m_depth(m_ring.depth++), m_begin(profile_ticks()) { }
+		~ProfileScope()
+		{
+			auto end = profile_ticks();
+			--m_ring.depth;
+			m_ring.push({ m_name, m_depth, m_begin, end });
+		}
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+	private:
+		ProfileRing& m_ring;
+		const char* m_name;
+		std::uint32_t m_depth;
+		std::int64_t m_begin;
+	};
+#else
+	class ProfileScope
+	{
+	public:
+		explicit ProfileScope(const char*) { }
+	};
+#endif
+
+	enum PerfCounterId
+	{
+		PerfCycles,
+		PerfInstructions,
+		PerfL1dMisses,
+		PerfLlcMisses,
+		PerfBranchMisses,
+		PerfDtlbMisses,
+		PerfCounterCount
+	};
+
+	constexpr const char* PerfCounterNames[PerfCounterCount] = {
+		"cycles", "instructions", "L1d misses", "LLC misses", "branch misses", "dTLB misses" };
+
+	//counts of one measured stretch, scaled up where the kernel had to multiplex the counters.
+	//valid[i] is false for counters the kernel or the hardware does not offer.
+	struct PerfSample
+	{
+		std::uint64_t values[PerfCounterCount] = {};
+		bool valid[PerfCounterCount] = {};
+	};
+
+	//user-space hardware counters of the calling thread and the threads it starts while counting, through
+	//perf_event_open. counters that can not be opened (no PMU in a VM, perf_event_paranoid, not Linux)
+	//are skipped, and when none opens available() is false and samples are empty.
+	class PerfCounters
+	{
+	public:
+		PerfCounters()
+		{
+#ifdef __linux__
+			auto cache = [](std::uint64_t cache, std::uint64_t result) {
+				return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (result << 16);
+			};
+			const std::pair<std::uint32_t, std::uint64_t> configs[PerfCounterCount] = {
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+				{ PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+				{ PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+				{ PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_RESULT_MISS) } };
+			for (int c = 0; c < PerfCounterCount; ++c) {
+				perf_event_attr attr{};
+				attr.size = sizeof(attr);
+				attr.type = configs[c].first;
+				attr.config = configs[c].second;
+				attr.disabled = 1;
+				attr.inherit = 1;
+				attr.exclude_kernel = 1;
+				attr.exclude_hv = 1;
+				attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+				m_fds[c] = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+			}
+#endif
+		}
+
+		~PerfCounters()
+		{
+#ifdef __linux__
+			for (auto fd : m_fds) {
+				if (fd >= 0)
+					::close(fd);
+			}
+#endif
+		}
+
+		PerfCounters(const PerfCounters&) = delete;
+		PerfCounters& operator=(const PerfCounters&) = delete;
+
+		bool available() const
+		{
+			return std::any_of(std::begin(m_fds), std::end(m_fds), [](int fd) { return fd >= 0; });
+		}
+
+		void start()
+		{
+#ifdef __linux__
+			for (auto fd : m_fds) {
+				if (fd >= 0) {
+					::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+					::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+				}
+			}
+#endif
+		}
+
+		PerfSample stop()
+		{
+			auto sample = PerfSample{};
+#ifdef __linux__
+			for (auto fd : m_fds) {
+				if (fd >= 0)
+					::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			}
+			for (int c = 0; c < PerfCounterCount; ++c) {
+				//value, time enabled, time running
+				std::uint64_t read[3];
+				if (m_fds[c] < 0 || ::read(m_fds[c], read, sizeof(read)) != sizeof(read) || read[2] == 0)
+					continue;
+				sample.values[c] = read[2] == read[1] ? read[0]
+					: static_cast<std::uint64_t>(double(read[0]) * double(read[1]) / double(read[2]));
+				sample.valid[c] = true;
+			}
+#endif
+			return sample;
+		}
+
+	private:
+		int m_fds[PerfCounterCount] = { -1, -1, -1, -1, -1, -1 };
+	};
+
+	//"IPC 1.23, L1d misses 2.10 per edge, ..." for the valid counters of a sample, misses per edge when
+	//nrEdges is given and absolute counts otherwise. empty when the sample has no valid counter.
+	static std::string format_perf_sample(const PerfSample& sample, std::size_t nrEdges)
+	{
+		std::ostringstream text;
+		text << std::fixed << std::setprecision(2);
+		auto separator = "";
+		if (sample.valid[PerfCycles] && sample.valid[PerfInstructions] && sample.values[PerfCycles] != 0) {
+			text << "IPC " << double(sample.values[PerfInstructions]) / double(sample.values[PerfCycles]);
+			separator = ", ";
+		}
+		for (int c = 0; c < PerfCounterCount; ++c) {
+			if (!sample.valid[c])
+				continue;
+			text << separator << PerfCounterNames[c] << ' ';
+			if (nrEdges != 0)
+				text << double(sample.values[c]) / double(nrEdges) << " per edge";
+			else
+				text << sample.values[c];
+			separator = ", ";
+		}
+		return text.str();
+	}
+
+	//what an AutoProfiler measures besides wall time
+	enum ProfileMetrics : unsigned
+	{
+		ProfileWallTime = 0,
+		ProfilePerfCounters = 1,
+		//needs AllocationHooks.cpp linked in for the global operator new
+		ProfileAllocations = 2,
+		//RSS and peak RSS of the process before and after
+		ProfileMemory = 4,
+		//ProfileMemory plus PSS, anonymous and swap from smaps_rollup, slower on big heaps
+		ProfileMemoryRollup = 8
+	};
+}
+
+#define BGLX_PROFILE_CONCAT_(a, b) a##b
+#define BGLX_PROFILE_CONCAT(a, b) BGLX_PROFILE_CONCAT_(a, b)
+#if BGLX_PROFILING
+//profiles the rest of the enclosing block under a string literal name
+#define BGLX_PROFILE_SCOPE(name) ::bglx::test::ProfileScope BGLX_PROFILE_CONCAT(bglxProfileScope, __LINE__){ name }
+#else
+#define BGLX_PROFILE_SCOPE(name) ((void)0)
+#endif
+
+//prints how long it lived to std::cout on destruction, and records itself as a profile scope.
+//with ProfilePerfCounters the line also gets IPC and hardware counter misses, per edge if nrEdges is given,
+//or a note that the counters are unavailable. with ProfileAllocations it gets the operator new count,
+//bytes, peak live bytes and size histogram of the scope, with ProfileMemory the process RSS and peak RSS
+//at the end and how much the scope changed them.
 class AutoProfiler {
 public:
-	AutoProfiler(std::string name)
+	AutoProfiler(std::string name, unsigned metrics = bglx::test::ProfileWallTime, std::size_t nrEdges = 0)
 		: m_name(std::move(name)),
-		m_beg(std::chrono::high_resolution_clock::now()) { }
+#if BGLX_PROFILING
+		m_scope(bglx::test::Profiler::instance().intern(m_name)),
+#endif
+		m_nrEdges(nrEdges),
+		m_memoryMetrics(metrics & (bglx::test::ProfileMemory | bglx::test::ProfileMemoryRollup))
+	{
+		if (m_memoryMetrics)
+			m_memoryBefore = bglx::test::sample_process_memory(false);
+		if (metrics & bglx::test::ProfilePerfCounters)
+			m_counters = std::make_unique<bglx::test::PerfCounters>();
+		if (metrics & bglx::test::ProfileAllocations)
+			m_allocations = std::make_unique<bglx::test::AllocationScope>();
+		m_beg = std::chrono::steady_clock::now();
+		if (m_counters)
+			m_counters->start();
+	}
 	~AutoProfiler() {
-		auto end = std::chrono::high_resolution_clock::now();
-		auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(end - m_beg);
-		std::cout << m_name << " : " << dur.count() << " ms\n" << std::endl;
+		auto sample = m_counters ? m_counters->stop() : bglx::test::PerfSample{};
+		auto end = std::chrono::steady_clock::now();
+		auto dur = std::chrono::duration_cast<std::chrono::nanoseconds>(end - m_beg);
+		auto allocations = m_allocations ? m_allocations->stop() : bglx::test::AllocationStats{};
+		auto memoryAfter = bglx::test::MemorySample{};
+		if (m_memoryMetrics)
+			memoryAfter = bglx::test::sample_process_memory((m_memoryMetrics & bglx::test::ProfileMemoryRollup) != 0);
+		auto line = m_name + " : " + bglx::test::format_duration(dur.count());
+		if (m_counters) {
+			auto counters = bglx::test::format_perf_sample(sample, m_nrEdges);
+			line += counters.empty() ? std::string{ " (perf counters unavailable)" } : ", " + counters;
+		}
+		if (m_allocations) {
+			line += bglx::test::global_allocations().hooked ? ", " + bglx::test::format_allocation_stats(allocations)
+				: std::string{ " (allocation hooks not linked)" };
+		}
+		if (m_memoryMetrics) {
+			auto memory = bglx::test::format_memory_samples(m_memoryBefore, memoryAfter);
+			line += memory.empty() ? std::string{ " (process memory unavailable)" } : ", " + memory;
+		}
+		//one write per line, so lines of several threads do not interleave
+		std::cout << line + "\n\n" << std::flush;
 	}
 private:
 	std::string m_name;
-	std::chrono::time_point<std::chrono::high_resolution_clock> m_beg;
-};
\ No newline at end of file
+#if BGLX_PROFILING
+	bglx::test::ProfileScope m_scope;
+#endif
+	std::size_t m_nrEdges;
+	std::unique_ptr<bglx::test::PerfCounters> m_counters;
+	std::unique_ptr<bglx::test::AllocationScope> m_allocations;
+	unsigned m_memoryMetrics;
+	bglx::test::MemorySample m_memoryBefore;
+	std::chrono::time_point<std::chrono::steady_clock> m_beg;
+};
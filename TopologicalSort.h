@@ -0,0 +1,147 @@
+#pragma once
+#include "CsrGraph.h"
+#include "Parallel.h"
+#include <boost/graph/graph_traits.hpp>
+#include <boost/graph/properties.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace bglx::test
+{
+	//Kahn order of a graph with vertices numbered 0..n-1 (vecS vertices, CsrGraph). level[v] is the
+	//length of the longest path ending at v, order lists the vertices level by level and
+	//order[levelOffsets[l] .. levelOffsets[l + 1]) are those of level l. vertices on a cycle or behind
+	//one never reach in-degree zero: they are missing from order and keep NoLevel.
+	struct TopologicalLevels
+	{
+		static constexpr std::uint32_t NoLevel = std::numeric_limits<std::uint32_t>::max();
+
+		std::vector<std::uint32_t> order;
+		std::vector<std::uint32_t> level;
+		std::vector<std::size_t> levelOffsets{ 0 };
+
+		bool is_acyclic() const { return order.size() == level.size(); }
+		std::size_t nr_levels() const { return levelOffsets.size() - 1; }
+	};
+
+	namespace detail
+	{
+		//counters that several threads decrement; the vertex reaching zero is owned by that thread
+		class AtomicCounters
+		{
+		public:
+			explicit AtomicCounters(std::size_t size) : m_counters(std::make_unique<std::atomic<std::uint32_t>[]>(size)) { }
+
+			void add(std::size_t i) { m_counters[i].fetch_add(1, std::memory_order_relaxed); }
+			//true for the call that takes the counter to zero
+			bool release(std::size_t i) { return m_counters[i].fetch_sub(1, std::memory_order_acq_rel) == 1; }
+			//release without the locked instruction, for when no other thread touches the counters
+			bool release_unshared(std::size_t i)
+			{
+				auto value = m_counters[i].load(std::memory_order_relaxed) - 1;
+				m_counters[i].store(value, std::memory_order_relaxed);
+				return value == 0;
+			}
+			std::uint32_t value(std::size_t i) const { return m_counters[i].load(std::memory_order_relaxed); }
+
+		private:
+			std::unique_ptr<std::atomic<std::uint32_t>[]> m_counters;
+		};
+
+		//level-synchronous Kahn over CSR rows: in-degrees are counted with atomic counters in parallel,
+		//then every level is the set of vertices whose last in-edge came from the level before. wide
+		//levels are split over nrThreads threads, narrow ones run on the calling thread, so million-deep
+		//chains cost no thread starts and nothing recurses.
+		inline TopologicalLevels topological_levels_rows(std::size_t nrVertices, const std::uint64_t* offsets,
+			const std::uint32_t* targets, unsigned nrThreads)
+		{
+			constexpr std::size_t MinParallel = 1 << 14;
+			if (nrVertices >= TopologicalLevels::NoLevel)
+				throw std::invalid_argument("topological_levels supports up to 2^32 - 2 vertices.");
+			nrThreads = nrThreads == 0 ? default_thread_count() : nrThreads;
+			auto threadsFor = [nrThreads](std::size_t nrItems) { return nrItems < MinParallel ? 1u : nrThreads; };
+
+			auto result = TopologicalLevels{};
+			result.level.assign(nrVertices, TopologicalLevels::NoLevel);
+			result.order.resize(nrVertices);
+			auto inDegree = AtomicCounters{ nrVertices };
+			auto nrEdges = static_cast<std::size_t>(offsets[nrVertices]);
+			parallel_chunks(nrEdges, threadsFor(nrEdges), [&](unsigned, std::size_t begin, std::size_t end) {
+				for (auto e = begin; e < end; ++e)
+					inDegree.add(targets[e]);
+			});
+
+			//every slice collects what it finds into its own buffer, the buffers are then appended to order
+			std::vector<std::vector<std::uint32_t>> found(nrThreads);
+			auto nrOrdered = std::size_t{ 0 };
+			auto append = [&](unsigned nrSlices, std::uint32_t level) {
+				auto begin = nrOrdered;
+				std::vector<std::size_t> sliceOffsets(nrSlices + 1, nrOrdered);
+				for (unsigned s = 0; s < nrSlices; ++s)
+					sliceOffsets[s + 1] = sliceOffsets[s] + found[s].size();
+				parallel_chunks(nrSlices, threadsFor(sliceOffsets[nrSlices] - begin) == 1 ? 1 : nrSlices,
+					[&](unsigned, std::size_t sBegin, std::size_t sEnd) {
+					for (auto s = sBegin; s < sEnd; ++s) {
+						std::copy(found[s].begin(), found[s].end(), result.order.begin() + sliceOffsets[s]);
+						for (auto v : found[s])
+							result.level[v] = level;
+						found[s].clear();
+					}
+				});
+				nrOrdered = sliceOffsets[nrSlices];
+				if (nrOrdered != begin)
+					result.levelOffsets.push_back(nrOrdered);
+			};
+
+			auto nrSources = threadsFor(nrVertices);
+			parallel_chunks(nrVertices, nrSources, [&](unsigned s, std::size_t begin, std::size_t end) {
+				for (auto v = begin; v < end; ++v) {
+					if (inDegree.value(v) == 0)
+						found[s].push_back(static_cast<std::uint32_t>(v));
+				}
+			});
+			append(nrSources, 0);
+
+			for (std::uint32_t level = 1; result.levelOffsets.size() == level + std::size_t{ 1 }; ++level) {
+				auto frontierBegin = result.levelOffsets[level - 1];
+				auto frontierSize = result.levelOffsets[level] - frontierBegin;
+				auto nrSlices = threadsFor(frontierSize);
+				parallel_chunks(frontierSize, nrSlices, [&](unsigned s, std::size_t begin, std::size_t end) {
+					for (auto i = frontierBegin + begin; i < frontierBegin + end; ++i) {
+						auto v = result.order[i];
+						for (auto e = offsets[v]; e < offsets[v + 1]; ++e) {
+							auto target = targets[e];
+							if (nrSlices == 1 ? inDegree.release_unshared(target) : inDegree.release(target))
+								found[s].push_back(target);
+						}
+					}
+				});
+				append(nrSlices, level);
+			}
+			result.order.resize(nrOrdered);
+			return result;
+		}
+	}
+
+	//Kahn order of g by levels, see TopologicalLevels. the out-edges are copied into CSR rows first,
+	//one pass over the adjacency structure instead of one per phase, which for Dag's out-edge sets is
+	//most of the cost. nrThreads 0 uses all cores.
+	template <class Graph>
+	TopologicalLevels topological_levels(const Graph& g, unsigned nrThreads = 0)
+	{
+		auto rows = make_csr_topology(g, nrThreads);
+		return detail::topological_levels_rows(rows.offsets.size() - 1, rows.offsets.data(), rows.targets.data(), nrThreads);
+	}
+
+	//CsrGraph already is rows
+	inline TopologicalLevels topological_levels(const CsrGraph& g, unsigned nrThreads = 0)
+	{
+		auto& arrays = g.arrays();
+		return detail::topological_levels_rows(arrays.nrVertices, arrays.offsets, arrays.targets, nrThreads);
+	}
+}
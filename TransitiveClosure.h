@@ -0,0 +1,214 @@
+#pragma once
+#include "BitOps.h"
+#include "CsrGraph.h"
+#include "NamedDag.h"
+#include "Parallel.h"
+#include "TopologicalSort.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace bglx::test
+{
+	struct TransitiveOptions
+	{
+		//bitset memory of all threads together; the closure is computed in as many column blocks as needed
+		std::size_t maxBitsetBytes = std::size_t{ 256 } << 20;
+		unsigned nrThreads = 0;
+	};
+
+	namespace detail
+	{
+		//descendant bitsets over topological positions, one column block [first, first + width) at a
+		//time. vertices are visited in reverse topological order and every row is the OR of the rows of
+		//its children plus the children themselves, as whole 64-bit words that the compiler vectorizes.
+		//blocks are independent, so every thread takes the next block until none are left; within a
+		//block a vertex only depends on later positions, and positions past the block have no bits in it.
+		class ClosureBlocks
+		{
+		public:
+			ClosureBlocks(const CsrGraph& g, const TransitiveOptions& options) : m_g(g)
+			{
+				auto levels = topological_levels(g, options.nrThreads);
+				if (!levels.is_acyclic())
+					throw std::invalid_argument("Transitive closure and reduction need an acyclic graph.");
+				m_order = std::move(levels.order);
+				m_position.resize(m_order.size());
+				for (std::size_t p = 0; p < m_order.size(); ++p)
+					m_position[m_order[p]] = static_cast<std::uint32_t>(p);
+
+				auto n = m_order.size();
+				m_nrThreads = options.nrThreads == 0 ? default_thread_count() : options.nrThreads;
+				//widest block whose rows for all threads fit the budget, but enough blocks for every thread
+				auto bitsPerThread = options.maxBitsetBytes * 8 / (std::max<std::size_t>(n, 1) * m_nrThreads);
+				auto perThread = (n + m_nrThreads - 1) / m_nrThreads;
+				m_width = std::max<std::size_t>(64, std::min(bitsPerThread, perThread + 63) / 64 * 64);
+				m_nrBlocks = (n + m_width - 1) / m_width;
+			}
+
+			std::size_t nr_blocks() const { return m_nrBlocks; }
+			const std::vector<std::uint32_t>& order() const { return m_order; }
+
+			//fn(block, first, end, rows, words) as each block completes, on the thread that ran it: rows holds words 64-bit
+			//words for each position before end, bit i of row p is set when the vertex at position
+			//first + i is a descendant of the one at p. keep, when given, gets the transitive reduction:
+			//keep[e] stays 1 only for edges e whose target is not reachable through another child.
+			template <class Fn>
+			void run(char* keep, Fn&& fn) const
+			{
+				auto next = std::atomic<std::size_t>{ 0 };
+				auto nrThreads = static_cast<unsigned>(std::min<std::size_t>(m_nrThreads, m_nrBlocks));
+				parallel_chunks(nrThreads, nrThreads, [&](unsigned, std::size_t, std::size_t) {
+					std::vector<std::uint64_t> rows;
+					//blocks to the right have more rows, hand those out first
+					for (auto b = next++; b < m_nrBlocks; b = next++) {
+						auto block = m_nrBlocks - 1 - b;
+						auto first = block * m_width;
+						auto end = std::min(first + m_width, m_order.size());
+						run_block(first, end, rows, keep);
+						fn(block, first, end, rows.data(), m_width / 64);
+					}
+				});
+			}
+
+		private:
+			void run_block(std::size_t first, std::size_t end, std::vector<std::uint64_t>& rows, char* keep) const
+			{
+				auto words = m_width / 64;
+				auto& a = m_g.arrays();
+				rows.assign(end * words, 0);
+				for (auto p = end; p-- > 0;) {
+					auto v = m_order[p];
+					auto row = rows.data() + p * words;
+					for (auto e = a.offsets[v]; e < a.offsets[v + 1]; ++e) {
+						auto child = m_position[a.targets[e]];
+						if (child >= end)
+							continue;
+						auto childRow = rows.data() + child * words;
+						for (std::size_t w = 0; w < words; ++w)
+							row[w] |= childRow[w];
+					}
+					//children are added after the OR, so a child already set was reached another way
+					for (auto e = a.offsets[v]; e < a.offsets[v + 1]; ++e) {
+						auto child = m_position[a.targets[e]];
+						if (child < first || child >= end)
+							continue;
+						auto bit = child - first;
+						auto mask = std::uint64_t{ 1 } << (bit % 64);
+						if (keep != nullptr && (row[bit / 64] & mask) != 0)
+							keep[e] = 0;
+						row[bit / 64] |= mask;
+					}
+				}
+			}
+
+			const CsrGraph& m_g;
+			std::vector<std::uint32_t> m_order;
+			std::vector<std::uint32_t> m_position;
+			unsigned m_nrThreads = 1;
+			std::size_t m_width = 64;
+			std::size_t m_nrBlocks = 0;
+		};
+
+		template <class Fn>
+		static void for_each_bit(const std::uint64_t* row, std::size_t words, Fn&& fn)
+		{
+			for (std::size_t w = 0; w < words; ++w) {
+				for (auto bits = row[w]; bits != 0; bits &= bits - 1)
+					fn(w * 64 + count_trailing_zeros(bits));
+			}
+		}
+	}
+
+	//one flag per edge of g (in edge index order): 1 for the edges of the transitive reduction. of
+	//parallel edges only the first is kept. throws std::invalid_argument on a cycle.
+	static std::vector<char> transitive_reduction_mask(const CsrGraph& g, const TransitiveOptions& options = {})
+	{
+		std::vector<char> keep(g.nr_edges(), 1);
+		auto blocks = detail::ClosureBlocks{ g, options };
+		blocks.run(keep.data(), [](std::size_t, std::size_t, std::size_t, const std::uint64_t*, std::size_t) {});
+		return keep;
+	}
+
+	//all pairs (u, v) with a path from u to v as a CsrGraph, the targets of a row in topological order
+	static CsrGraph transitive_closure(const CsrGraph& g, const TransitiveOptions& options = {})
+	{
+		auto blocks = detail::ClosureBlocks{ g, options };
+		auto& order = blocks.order();
+		auto n = order.size();
+		//every block keeps its part of each row, by position, until the rows are joined
+		struct BlockRows
+		{
+			std::vector<std::uint64_t> offsets;
+			std::vector<std::uint32_t> targets;
+		};
+		std::vector<BlockRows> parts(blocks.nr_blocks());
+		blocks.run(nullptr, [&](std::size_t block, std::size_t first, std::size_t end, const std::uint64_t* rows, std::size_t words) {
+			auto& part = parts[block];
+			part.offsets.assign(end + 1, 0);
+			for (std::size_t p = 0; p < end; ++p) {
+				detail::for_each_bit(rows + p * words, words, [&](std::size_t bit) {
+					part.targets.push_back(order[first + bit]);
+				});
+				part.offsets[p + 1] = part.targets.size();
+			}
+		});
+
+		auto storage = CsrStorage{};
+		storage.offsets.assign(n + 1, 0);
+		for (std::size_t p = 0; p < n; ++p) {
+			for (auto& part : parts) {
+				if (p + 1 < part.offsets.size())
+					storage.offsets[order[p] + 1] += part.offsets[p + 1] - part.offsets[p];
+			}
+		}
+		for (std::size_t v = 0; v < n; ++v)
+			storage.offsets[v + 1] += storage.offsets[v];
+		storage.targets.resize(storage.offsets[n]);
+		auto nrThreads = options.nrThreads == 0 ? default_thread_count() : options.nrThreads;
+		parallel_for(n, n < (1 << 14) ? 1u : nrThreads, [&](std::size_t p) {
+			auto out = storage.targets.begin() + storage.offsets[order[p]];
+			for (auto& part : parts) {
+				if (p + 1 < part.offsets.size())
+					out = std::copy(part.targets.begin() + part.offsets[p], part.targets.begin() + part.offsets[p + 1], out);
+			}
+		});
+		return CsrGraph{ std::move(storage) };
+	}
+
+	//new Dag with the vertices of dag and the edges of its transitive reduction, names included
+	static Dag transitive_reduction(const Dag& dag, const TransitiveOptions& options = {})
+	{
+		//make_csr_topology keeps the out-edge order, so edge e of the rows is the e-th out-edge visited here
+		auto keep = transitive_reduction_mask(CsrGraph{ make_csr_topology(dag, options.nrThreads) }, options);
+		auto reduced = Dag{ boost::num_vertices(dag) };
+		auto e = std::size_t{ 0 };
+		for (auto v : boost::make_iterator_range(boost::vertices(dag))) {
+			reduced[v] = dag[v];
+			for (auto edge : boost::make_iterator_range(boost::out_edges(v, dag))) {
+				if (keep[e++])
+					boost::add_edge(v, boost::target(edge, dag), dag[edge], reduced);
+			}
+		}
+		return reduced;
+	}
+
+	//new Dag with the vertices of dag and an edge for every path; edges of dag keep their names
+	static Dag transitive_closure(const Dag& dag, const TransitiveOptions& options = {})
+	{
+		auto closure = transitive_closure(CsrGraph{ make_csr_topology(dag, options.nrThreads) }, options);
+		//the original edges go in first, then adding a closure edge that already exists is a no-op
+		auto result = Dag{ boost::num_vertices(dag) };
+		for (auto v : boost::make_iterator_range(boost::vertices(dag))) {
+			result[v] = dag[v];
+			for (auto e : boost::make_iterator_range(boost::out_edges(v, dag)))
+				boost::add_edge(v, boost::target(e, dag), dag[e], result);
+			for (auto e : boost::make_iterator_range(boost::out_edges(v, closure)))
+				boost::add_edge(v, boost::target(e, closure), result);
+		}
+		return result;
+	}
+}